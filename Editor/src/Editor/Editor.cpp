@@ -2,59 +2,82 @@
 #include "Iris/Core/Log.hpp"
 #include "Iris/Util/Input.hpp"
 
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
 namespace Iris {
     Editor::Editor(const ApplicationDetails& details) : Application(details) {
         Iris::Log::App::Info("Editor()");
 
-        m_Window = std::make_shared<Window>(RenderAPI::Vulkan, WindowOptions{ "Iris Editor", { 1600, 900 } });
-        m_Renderer = Renderer::Create(RenderAPI::Vulkan, m_Window);
+        RendererOptions rendererOptions{ .Size = glm::uvec2(details.DesiredSize) };
+        for (auto arg: details.CommandLineArgs) {
+            // --frames-in-flight=1 makes the CPU and GPU run in lockstep, handy for comparing frame times
+            if (arg.starts_with("--frames-in-flight=")) {
+                rendererOptions.FramesInFlight = std::stoul(std::string(arg.substr(arg.find('=') + 1)));
+            } else if (arg.starts_with("--output=")) {
+                // headless: frames are written as <output>_<frame>.png
+                m_OutputPath = arg.substr(arg.find('=') + 1);
+            }
+        }
+
+        if (!details.Headless) {
+            m_Window = std::make_shared<Window>(RenderAPI::Vulkan,
+                                                WindowOptions{ "Iris Editor", details.DesiredSize });
+        }
+        m_Renderer = Renderer::Create(RenderAPI::Vulkan, m_Window, rendererOptions);
         m_Renderer->SetScene(m_Scene);
 
+        if (details.Headless && !m_OutputPath.empty()) {
+            m_Renderer->on<FrameReady>([this](uint64_t frame, glm::uvec2 size, std::span<const uint8_t> pixels) {
+                WriteFrame(frame, size, pixels);
+            });
+        }
+
         m_Camera = std::make_shared<Camera>(-1, nullptr, 90.f, 1600.f / 900.f);
 
-        auto& floor = m_Scene->CreateObject();
+        auto floor = m_Scene->CreateObject();
         floor.AddComponent<Mesh>("../Assets/plane.obj");
         floor.GetTransform().SetTranslation({ 0.f, -0.5f, 0.f });
         m_Scene->AddObject(floor);
 
-        auto& axis = m_Scene->CreateObject();
+        auto axis = m_Scene->CreateObject();
         axis.AddComponent<Mesh>("../Assets/Axis/axis.obj");
         axis.AddComponent<Material>("../Assets/Axis/albedo.png");
         axis.GetTransform().SetScale({ 0.3f, 0.3f, 0.3f });
         axis.GetTransform().SetTranslation({ -1.7f, 0.f, -7.3f });
         m_Scene->AddObject(axis);
 
-        auto& light = m_Scene->CreateObject();
+        auto light = m_Scene->CreateObject();
         light.AddComponent<Light>(glm::vec3(1.f, 0.f, 0.f), LightType::POINT);
         light.GetTransform().SetTranslation({ 0.f, 0.f, 5.f });
         m_Scene->AddObject(light);
 
-        auto& light2 = m_Scene->CreateObject();
+        auto light2 = m_Scene->CreateObject();
         light2.AddComponent<Light>(glm::vec3(0.f, 1.f, 0.f), LightType::POINT);
         light2.GetTransform().SetTranslation({ -4.f, 0.f, 5.f });
         m_Scene->AddObject(light2);
 
-        auto& light3 = m_Scene->CreateObject();
+        auto light3 = m_Scene->CreateObject();
         light3.AddComponent<Light>(glm::vec3(0.f, 0.f, 1.f), LightType::POINT);
         light3.GetTransform().SetTranslation({ 1.5f, 1.f, 4.f });
         m_Scene->AddObject(light3);
 
-        auto& light4 = m_Scene->CreateObject();
+        auto light4 = m_Scene->CreateObject();
         light4.AddComponent<Light>(glm::vec3(0.1f, 0.1f, 0.1f), LightType::DIRECTIONAL);
         light4.GetTransform().SetTranslation({ 3.f, 1.f, 7.f });
         m_Scene->AddObject(light4);
 
-        auto& light5 = m_Scene->CreateObject();
+        auto light5 = m_Scene->CreateObject();
         light5.AddComponent<Light>(glm::vec3(0.6f, 0.6f, 0.6f), LightType::SPOT);
         light5.GetTransform().SetTranslation({ -3.f, 5.f, -7.f });
         m_Scene->AddObject(light5);
 
-        auto& light6 = m_Scene->CreateObject();
+        auto light6 = m_Scene->CreateObject();
         light6.AddComponent<Light>(glm::vec3(0.6f, 0.6f, 0.6f), LightType::SPOT);
         light6.GetTransform().SetTranslation({ 3.f, 5.f, 7.f });
         m_Scene->AddObject(light6);
 
-        auto& monkey = m_Scene->CreateObject();
+        auto monkey = m_Scene->CreateObject();
         monkey.AddComponent<Mesh>("../Assets/monkey-low.obj");
         monkey.GetTransform().SetTranslation({ 1.f, 1.f, 3.f });
         m_Scene->AddObject(monkey);
@@ -68,6 +91,19 @@ namespace Iris {
         m_Renderer->Render(*m_Camera);
     }
 
+    void Editor::WriteFrame(uint64_t frame, glm::uvec2 size, std::span<const uint8_t> pixels) {
+        // only the last frame is interesting when a frame count is given
+        if (m_Details.FrameCount != 0 && frame + 1 != m_Details.FrameCount) return;
+
+        auto path = fmt::format("{}_{}.png", m_OutputPath, frame);
+        if (!stbi_write_png(path.c_str(), static_cast<int>(size.x), static_cast<int>(size.y), 4, pixels.data(),
+                            static_cast<int>(size.x * 4))) {
+            Log::App::Error("Failed to write frame {} to {}", frame, path);
+            return;
+        }
+        Log::App::Info("Frame {} written to {}", frame, path);
+    }
+
     Editor::~Editor() {
         Iris::Log::App::Info("~Editor()");
         m_Renderer.reset();
@@ -2,6 +2,7 @@
 #include "Iris/Core/EntryPoint.hpp"
 #include "Iris/Core/Application.hpp"
 #include "Iris/Entity/Components/Camera.hpp"
+#include "Iris/Math/TransformBatch.hpp"
 
 using namespace std::chrono_literals;
 
@@ -15,6 +16,9 @@ namespace Iris {
         ~Editor() override;
 
     private:
+        void WriteFrame(uint64_t frame, glm::uvec2 size, std::span<const uint8_t> pixels);
+    private:
+        std::string m_OutputPath;
         std::shared_ptr<Window> m_Window;
         std::shared_ptr<Camera> m_Camera;
     };
@@ -24,6 +28,18 @@ namespace Iris {
                 .Name = "Iris Editor",
                 .CommandLineArgs = args
         };
+
+        for (auto arg: args) {
+            if (arg == "--headless") {
+                details.Headless = true;
+            } else if (arg.starts_with("--frames=")) {
+                details.FrameCount = std::stoull(std::string(arg.substr(arg.find('=') + 1)));
+            } else if (arg == "--bench-transforms") {
+                // Times the transform kernels on 1M transforms and exits without opening a window
+                Math::BenchmarkTransforms(1'000'000);
+                std::exit(0);
+            }
+        }
         return new Editor(details);
     }
 }
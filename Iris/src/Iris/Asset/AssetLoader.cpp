@@ -0,0 +1,104 @@
+#include "AssetLoader.hpp"
+#include "Iris/Core/JobSystem.hpp"
+
+namespace Iris {
+    AssetLoader::AssetLoader() {
+        // Constructed first so it is destroyed after the loader, whose destructor still needs its workers to
+        // drain the background jobs
+        JobSystem::Get();
+    }
+
+    AssetLoader::~AssetLoader() {
+        std::unique_lock lock(m_JobsMutex);
+        m_Stopping = true;
+        m_JobsDone.wait(lock, [this] { return m_JobsInFlight == 0; });
+    }
+
+    AssetLoader& AssetLoader::Get() {
+        static AssetLoader instance;
+        return instance;
+    }
+
+    void AssetLoader::LoadMesh(const std::string& path, Callback<MeshAsset> callback) {
+        Load<MeshAsset>(m_Meshes, "Load mesh", path, std::move(callback), [](const std::string& source) {
+            return MeshImporter::Import(source);
+        });
+    }
+
+    void AssetLoader::LoadTexture(const std::string& path, Callback<ImageData> callback) {
+        Load<ImageData>(m_Images, "Load texture", path, std::move(callback), [](const std::string& source) {
+            return ImageData::Load(source, ImageUsage::Color);
+        });
+    }
+
+    void AssetLoader::ProcessCompleted() {
+        m_Completed.Flush();
+    }
+
+    void AssetLoader::WaitAll() {
+        while (GetPendingCount() > 0) {
+            ProcessCompleted();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    template <class T>
+    void AssetLoader::Load(Table<T>& table, std::string_view jobName, const std::string& source, Callback<T> callback,
+                           std::shared_ptr<const T> (* load)(const std::string&)) {
+        if (GetPendingCount() == 0) {
+            m_BatchStart = std::chrono::high_resolution_clock::now();
+            m_BatchCount = 0;
+            m_BatchShared = 0;
+        }
+
+        // "a/../b.obj" and "b.obj" are the same asset
+        std::string path = std::filesystem::path(source).lexically_normal().generic_string();
+        auto [it, inserted] = table.requests.try_emplace(path);
+        it->second.emplace_back(std::move(callback));
+        if (!inserted) return;
+        ++m_BatchCount;
+
+        auto finish = [this, &table, path](const std::shared_ptr<const T>& asset) {
+            if (asset) table.resident[path] = asset;
+            auto node = table.requests.extract(path);
+            for (auto& callback: node.mapped()) callback(asset);
+
+            if (GetPendingCount() == 0) {
+                double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::high_resolution_clock::now() - m_BatchStart).count();
+                Log::Core::Info("Loaded {} assets ({} shared) in {:.2f}ms", m_BatchCount, m_BatchShared, ms);
+            }
+        };
+
+        // Still completed through the queue, callers rely on the callback never running inside the request
+        if (auto resident = table.resident.find(path); resident != table.resident.end()) {
+            if (auto asset = resident->second.lock()) {
+                ++m_BatchShared;
+                m_Completed.PushFn([finish, asset] { finish(asset); });
+                return;
+            }
+            table.resident.erase(resident);
+        }
+
+        {
+            std::lock_guard lock(m_JobsMutex);
+            ++m_JobsInFlight;
+        }
+        JobSystem::Get().ScheduleBackground(jobName, [this, finish, path, load] {
+            bool stopping;
+            {
+                std::lock_guard lock(m_JobsMutex);
+                stopping = m_Stopping;
+            }
+            if (!stopping) {
+                std::shared_ptr<const T> asset = load(path);
+                m_Completed.PushFn([finish, asset] { finish(asset); });
+            }
+
+            // Last access to the loader, it may be destroyed as soon as the lock is released
+            std::lock_guard lock(m_JobsMutex);
+            --m_JobsInFlight;
+            m_JobsDone.notify_all();
+        });
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Iris/Renderer/MeshImporter.hpp"
+#include "Iris/Renderer/Image.hpp"
+#include "Iris/Util/CallbackQueue.hpp"
+
+namespace Iris {
+    enum class AssetState : uint8_t {
+        Pending,
+        Loaded,
+        Failed
+    };
+
+    // Reads, parses and decodes assets on the job system's background workers. The finished CPU side payloads
+    // are handed back to the main thread in ProcessCompleted, where the callbacks upload or store them.
+    // Requests for a path that is already loading join the running one, requests for a path that is still
+    // held by someone get the same payload without touching the disk. Payloads are dropped as soon as their
+    // last holder releases them. Everything but the workers is main thread only.
+    class AssetLoader final {
+    public:
+        template <class T>
+        using Callback = std::function<void(std::shared_ptr<const T>)>;  // nullptr when loading failed
+
+        static AssetLoader& Get();
+
+        void LoadMesh(const std::string& path, Callback<MeshAsset> callback);
+        void LoadTexture(const std::string& path, Callback<ImageData> callback);
+
+        // Runs the callbacks of everything finished since the last call, once per frame
+        void ProcessCompleted();
+        // Blocks until nothing is pending, callbacks run on the calling thread
+        void WaitAll();
+        [[nodiscard]] size_t GetPendingCount() const {
+            return m_Meshes.requests.size() + m_Images.requests.size();
+        }
+
+        // Waits for the background jobs still running a load, their callbacks are dropped
+        ~AssetLoader();
+    private:
+        template <class T>
+        struct Table {
+            std::unordered_map<std::string, std::vector<Callback<T>>> requests;
+            std::unordered_map<std::string, std::weak_ptr<const T>> resident;
+        };
+
+        AssetLoader();
+
+        template <class T>
+        void Load(Table<T>& table, std::string_view jobName, const std::string& path, Callback<T> callback,
+                  std::shared_ptr<const T> (* load)(const std::string&));
+    private:
+        Table<MeshAsset> m_Meshes;
+        Table<ImageData> m_Images;
+        CallbackQueue m_Completed;
+
+        // Background jobs that haven't finished yet, the destructor waits for them. Jobs starting after that
+        // skip the load.
+        std::mutex m_JobsMutex;
+        std::condition_variable m_JobsDone;
+        size_t m_JobsInFlight = 0;
+        bool m_Stopping = false;
+
+        // Wall time from the first request until nothing is pending anymore
+        std::chrono::high_resolution_clock::time_point m_BatchStart;
+        size_t m_BatchCount = 0;
+        size_t m_BatchShared = 0;   // served from a payload that was still resident
+    };
+}
@@ -1,6 +1,8 @@
 #include "Application.hpp"
 #include "Iris/Entity/Entity.hpp"
 #include "Iris/Entity/Components/Mesh.hpp"
+#include "Iris/Core/JobSystem.hpp"
+#include "Iris/Asset/AssetLoader.hpp"
 
 using namespace std::chrono_literals;
 
@@ -10,27 +12,36 @@ namespace Iris {
     Application::Application(ApplicationDetails details)
             : m_Details(std::move(details)) {
         s_Instance = this;
-        m_Scene->SetThis(m_Scene);
-        glfwInit();
+        if (!m_Details.Headless) glfwInit();
 
         m_LastFrameFinished = std::chrono::high_resolution_clock::now();
     }
 
     Application::~Application() {
-        glfwTerminate();
+        JobSystem::Get().LogTimings();
+        if (!m_Details.Headless) glfwTerminate();
     }
 
     void Application::Run() {
+        // Offscreen runs render a fixed number of frames, those should show the whole scene
+        if (m_Details.Headless) AssetLoader::Get().WaitAll();
+
         while (m_Renderer) {
-            glfwPollEvents();
-            if (m_Renderer->GetWindow() && glfwWindowShouldClose(m_Renderer->GetWindow()->GetGLFWWindow())) break;
+            if (m_Renderer->GetWindow()) {
+                glfwPollEvents();
+                if (glfwWindowShouldClose(m_Renderer->GetWindow()->GetGLFWWindow())) break;
+            }
+            if (m_Details.FrameCount != 0 && m_Renderer->GetFrameNumber() >= m_Details.FrameCount) break;
 
             auto frameDuration = std::chrono::high_resolution_clock::now() - m_LastFrameFinished;
             uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(frameDuration).count();
 
             float dt = static_cast<float>(micros) / 1000.f;
+            AssetLoader::Get().ProcessCompleted();
             OnUpdate(dt);
             m_LastFrameFinished = std::chrono::high_resolution_clock::now();
         }
+
+        if (m_Renderer) m_Renderer->Flush();
     }
 }
\ No newline at end of file
@@ -8,6 +8,8 @@ namespace Iris {
         std::string Name;
         glm::ivec2 DesiredSize{ 1600, 900 };
         std::vector<std::string_view> CommandLineArgs;
+        bool Headless = false;      // render offscreen without a window or swapchain
+        uint64_t FrameCount = 0;    // frames to render before exiting, 0 runs until the window is closed
     };
 
     class Application {
@@ -0,0 +1,234 @@
+#include "JobSystem.hpp"
+
+namespace Iris {
+    static constexpr uint32_t NotAWorker = std::numeric_limits<uint32_t>::max();
+    static thread_local uint32_t t_WorkerIndex = NotAWorker;
+
+    JobSystem::JobSystem(uint32_t workers) {
+        for (uint32_t i = 0; i <= workers; ++i) {
+            m_Queues.emplace_back(std::make_unique<Queue>());
+            m_Stats.emplace_back(std::make_unique<Stats>());
+        }
+        for (uint32_t i = 0; i < workers; ++i) {
+            m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+        }
+        Log::Core::Info("Job system started with {} workers", workers);
+    }
+
+    JobSystem& JobSystem::Get() {
+        static JobSystem instance;
+        return instance;
+    }
+
+    void JobSystem::Schedule(std::string_view name, Job job, JobCounter* counter) {
+        if (counter) counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+        auto& queue = *m_Queues[CurrentQueue()];
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.tasks.push_back({ name, std::move(job), counter });
+        }
+        m_Queued.fetch_add(1, std::memory_order_release);
+
+        // Taking the lock orders this against a worker that just found nothing and is about to sleep
+        { std::lock_guard lock(m_SleepMutex); }
+        m_WakeUp.notify_one();
+    }
+
+    void JobSystem::ScheduleBackground(std::string_view name, Job job) {
+        {
+            std::lock_guard lock(m_Background.mutex);
+            m_Background.tasks.push_back({ name, std::move(job), nullptr });
+        }
+        m_Queued.fetch_add(1, std::memory_order_release);
+
+        { std::lock_guard lock(m_SleepMutex); }
+        m_WakeUp.notify_one();
+    }
+
+    void JobSystem::Wait(const JobCounter& counter) {
+        uint32_t index = CurrentQueue();
+        while (!counter.IsDone()) {
+            if (auto task = Pop(index, false)) {
+                Run(*task, index);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::ParallelFor(std::string_view name, size_t count, size_t grain,
+                                const std::function<void(size_t, size_t)>& function) {
+        if (count == 0) return;
+        grain = std::max<size_t>(grain, 1);
+        if (count <= grain) {
+            function(0, count);
+            return;
+        }
+
+        JobCounter counter;
+        for (size_t begin = 0; begin < count; begin += grain) {
+            size_t end = std::min(begin + grain, count);
+            Schedule(name, [&function, begin, end] { function(begin, end); }, &counter);
+        }
+        Wait(counter);
+    }
+
+    std::vector<JobTiming> JobSystem::GetTimings() const {
+        std::unordered_map<std::string_view, JobTiming> merged;
+        for (auto& stats: m_Stats) {
+            std::lock_guard lock(stats->mutex);
+            for (auto& [name, timing]: stats->timings) {
+                auto& out = merged[name];
+                out.name = name;
+                out.count += timing.count;
+                out.totalMs += timing.totalMs;
+                out.maxMs = std::max(out.maxMs, timing.maxMs);
+            }
+        }
+
+        std::vector<JobTiming> out;
+        for (auto& [name, timing]: merged) out.push_back(timing);
+        std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.totalMs > b.totalMs; });
+        return out;
+    }
+
+    void JobSystem::ResetTimings() {
+        for (auto& stats: m_Stats) {
+            std::lock_guard lock(stats->mutex);
+            stats->timings.clear();
+        }
+    }
+
+    void JobSystem::LogTimings() const {
+        for (auto& timing: GetTimings()) {
+            Log::Core::Info("Job {}: {} runs, {:.3f}ms total, {:.3f}ms avg, {:.3f}ms max", timing.name, timing.count,
+                            timing.totalMs, timing.totalMs / static_cast<double>(timing.count), timing.maxMs);
+        }
+    }
+
+    void JobSystem::WorkerLoop(uint32_t index) {
+        t_WorkerIndex = index;
+        while (!m_Stop.load(std::memory_order_acquire)) {
+            if (auto task = Pop(index, true)) {
+                Run(*task, index);
+                continue;
+            }
+
+            std::unique_lock lock(m_SleepMutex);
+            m_WakeUp.wait(lock, [this] {
+                return m_Stop.load(std::memory_order_acquire) || m_Queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+    uint32_t JobSystem::CurrentQueue() const {
+        return t_WorkerIndex == NotAWorker ? static_cast<uint32_t>(m_Workers.size()) : t_WorkerIndex;
+    }
+
+    std::optional<JobSystem::Task> JobSystem::Pop(uint32_t index, bool background) {
+        if (m_Queued.load(std::memory_order_acquire) == 0) return std::nullopt;
+
+        // Own queue newest first, it is most likely still in cache
+        {
+            auto& queue = *m_Queues[index];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                Task task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                m_Queued.fetch_sub(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+
+        // Steal the oldest job of someone else, that's usually the biggest remaining piece of work
+        for (size_t i = 1; i < m_Queues.size(); ++i) {
+            auto& queue = *m_Queues[(index + i) % m_Queues.size()];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                Task task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                m_Queued.fetch_sub(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+
+        if (background) {
+            std::lock_guard lock(m_Background.mutex);
+            if (!m_Background.tasks.empty()) {
+                Task task = std::move(m_Background.tasks.front());
+                m_Background.tasks.pop_front();
+                m_Queued.fetch_sub(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void JobSystem::Run(Task& task, uint32_t index) {
+        auto start = std::chrono::high_resolution_clock::now();
+        task.job();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start)
+                .count();
+
+        {
+            auto& stats = *m_Stats[index];
+            std::lock_guard lock(stats.mutex);
+            auto& timing = stats.timings[task.name];
+            timing.name = task.name;
+            ++timing.count;
+            timing.totalMs += ms;
+            timing.maxMs = std::max(timing.maxMs, ms);
+        }
+
+        if (task.counter) task.counter->m_Pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard lock(m_SleepMutex);
+            m_Stop.store(true, std::memory_order_release);
+        }
+        m_WakeUp.notify_all();
+        for (auto& worker: m_Workers) worker.join();
+    }
+
+    TaskGraph::TaskId TaskGraph::Add(std::string_view name, std::function<void()> function,
+                                     std::vector<TaskId> dependencies) {
+        auto id = static_cast<TaskId>(m_Nodes.size());
+        auto& node = m_Nodes.emplace_back();
+        node.name = name;
+        node.function = std::move(function);
+        node.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        for (auto dependency: dependencies) {
+            m_Nodes[dependency].dependents.push_back(id);
+        }
+        return id;
+    }
+
+    void TaskGraph::Run(JobSystem& jobs) {
+        for (auto& node: m_Nodes) {
+            node.pending.store(node.dependencyCount, std::memory_order_relaxed);
+        }
+
+        JobCounter counter;
+        for (TaskId id = 0; id < m_Nodes.size(); ++id) {
+            if (m_Nodes[id].dependencyCount == 0) Schedule(jobs, id, counter);
+        }
+        jobs.Wait(counter);
+    }
+
+    void TaskGraph::Schedule(JobSystem& jobs, TaskId id, JobCounter& counter) {
+        jobs.Schedule(m_Nodes[id].name, [this, &jobs, &counter, id] {
+            auto& node = m_Nodes[id];
+            node.function();
+
+            // Dependents are scheduled before this job counts as done, so the counter can't hit zero early
+            for (auto dependent: node.dependents) {
+                if (m_Nodes[dependent].pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    Schedule(jobs, dependent, counter);
+                }
+            }
+        }, &counter);
+    }
+}
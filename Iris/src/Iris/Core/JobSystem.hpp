@@ -0,0 +1,104 @@
+#pragma once
+
+namespace Iris {
+    // Completion counter for a group of jobs
+    class JobCounter final {
+    public:
+        [[nodiscard]] bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+    private:
+        std::atomic<uint32_t> m_Pending{ 0 };
+
+        friend class JobSystem;
+    };
+
+    // Accumulated run time of every job scheduled under one name
+    struct JobTiming {
+        std::string name;
+        uint64_t count = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    // Work-stealing job system. Every worker owns a deque it pushes to and pops from at the back, idle workers
+    // steal from the front of the others. Threads that aren't workers share one extra deque. Waiting on a counter
+    // runs queued jobs instead of blocking, so jobs may schedule and wait on other jobs.
+    class JobSystem final {
+    public:
+        using Job = std::function<void()>;
+
+        explicit JobSystem(uint32_t workers = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+        static JobSystem& Get();
+
+        // Names are used for the timings and must outlive the job system (string literals)
+        void Schedule(std::string_view name, Job job, JobCounter* counter = nullptr);
+        // Long running work like asset imports. Only idle workers pick these up, Wait never runs them, so a
+        // frame waiting on its own jobs can't get stuck behind one.
+        void ScheduleBackground(std::string_view name, Job job);
+        void Wait(const JobCounter& counter);
+
+        // Calls function(begin, end) on chunks of at most grain elements of [0, count), returns once all are done
+        void ParallelFor(std::string_view name, size_t count, size_t grain,
+                         const std::function<void(size_t begin, size_t end)>& function);
+
+        [[nodiscard]] uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+        [[nodiscard]] std::vector<JobTiming> GetTimings() const;
+        void ResetTimings();
+        void LogTimings() const;
+
+        ~JobSystem();
+    private:
+        struct Task {
+            std::string_view name;
+            Job job;
+            JobCounter* counter;
+        };
+
+        // Mutex guarded, jobs are coarse enough that the lock is never the bottleneck
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        struct Stats {
+            mutable std::mutex mutex;
+            std::unordered_map<std::string_view, JobTiming> timings;
+        };
+
+        void WorkerLoop(uint32_t index);
+        [[nodiscard]] uint32_t CurrentQueue() const;
+        std::optional<Task> Pop(uint32_t index, bool background);
+        void Run(Task& task, uint32_t index);
+    private:
+        std::vector<std::thread> m_Workers;
+        std::vector<std::unique_ptr<Queue>> m_Queues;   // one per worker, the last one is for other threads
+        std::vector<std::unique_ptr<Stats>> m_Stats;    // same indexing as m_Queues
+        Queue m_Background;
+
+        std::atomic<uint32_t> m_Queued{ 0 };
+        std::atomic<bool> m_Stop{ false };
+        std::mutex m_SleepMutex;
+        std::condition_variable m_WakeUp;
+    };
+
+    // Jobs with dependencies between them. A task is scheduled as soon as everything it depends on has finished.
+    class TaskGraph final {
+    public:
+        using TaskId = uint32_t;
+
+        TaskId Add(std::string_view name, std::function<void()> function, std::vector<TaskId> dependencies = {});
+        // Blocks until every task has run, the graph can be run again afterwards
+        void Run(JobSystem& jobs);
+    private:
+        struct Node {
+            std::string_view name;
+            std::function<void()> function;
+            std::vector<TaskId> dependents;
+            uint32_t dependencyCount = 0;
+            std::atomic<uint32_t> pending{ 0 };
+        };
+
+        void Schedule(JobSystem& jobs, TaskId id, JobCounter& counter);
+    private:
+        std::deque<Node> m_Nodes;   // deque, atomics can't be moved
+    };
+}
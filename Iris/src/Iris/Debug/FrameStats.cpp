@@ -0,0 +1,50 @@
+#include "FrameStats.hpp"
+
+namespace Iris::Debug {
+    static float ToMs(std::chrono::high_resolution_clock::duration duration, uint32_t frames) {
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        return static_cast<float>(ns) / 1'000'000.f / static_cast<float>(frames);
+    }
+
+    FrameStats::FrameStats(std::string_view name, uint32_t reportInterval) : m_Name(name),
+                                                                             m_ReportInterval(reportInterval) {}
+
+    void FrameStats::BeginFrame() {
+        auto now = Clock::now();
+        if (m_FrameStart != Clock::time_point{}) {
+            m_TotalFrame += now - m_FrameStart;
+            if (++m_Frames == m_ReportInterval) Report();
+        }
+        m_FrameStart = now;
+        m_CurrentWait = {};
+    }
+
+    void FrameStats::BeginWait() {
+        m_WaitStart = Clock::now();
+    }
+
+    void FrameStats::EndWait() {
+        auto waited = Clock::now() - m_WaitStart;
+        m_CurrentWait += waited;
+        m_TotalWait += waited;
+    }
+
+    void FrameStats::EndRecord() {
+        m_TotalRecord += Clock::now() - m_FrameStart - m_CurrentWait;
+    }
+
+    void FrameStats::Report() {
+        m_FrameTime = ToMs(m_TotalFrame, m_Frames);
+        m_WaitTime = ToMs(m_TotalWait, m_Frames);
+        m_RecordTime = ToMs(m_TotalRecord, m_Frames);
+
+        Log::Core::Info("{}: {:.3f}ms/frame ({:.1f} fps), CPU record {:.3f}ms, GPU wait {:.3f}ms ({:.0f}% of frame)",
+                        m_Name, m_FrameTime, 1000.f / m_FrameTime, m_RecordTime, m_WaitTime,
+                        100.f * m_WaitTime / m_FrameTime);
+
+        m_Frames = 0;
+        m_TotalFrame = {};
+        m_TotalWait = {};
+        m_TotalRecord = {};
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+namespace Iris::Debug {
+    // Rolling frame timings, used to compare how much of a frame the CPU spends waiting on the GPU.
+    class FrameStats {
+    public:
+        explicit FrameStats(std::string_view name, uint32_t reportInterval = 600);
+
+        void BeginFrame();
+        void BeginWait();
+        void EndWait();
+        void EndRecord();
+
+        [[nodiscard]] float GetFrameTime() const { return m_FrameTime; };
+
+        [[nodiscard]] float GetWaitTime() const { return m_WaitTime; };
+
+        [[nodiscard]] float GetRecordTime() const { return m_RecordTime; };
+    private:
+        using Clock = std::chrono::high_resolution_clock;
+
+        void Report();
+    private:
+        std::string m_Name;
+        uint32_t m_ReportInterval;
+        uint32_t m_Frames = 0;
+
+        Clock::time_point m_FrameStart{};
+        Clock::time_point m_WaitStart{};
+        Clock::duration m_CurrentWait{};
+
+        Clock::duration m_TotalFrame{};
+        Clock::duration m_TotalWait{};
+        Clock::duration m_TotalRecord{};
+
+        float m_FrameTime = 0.f;
+        float m_WaitTime = 0.f;
+        float m_RecordTime = 0.f;
+    };
+}
@@ -7,8 +7,7 @@ namespace Iris {
 
     class Component {
     public:
-        explicit Component(size_t parentId, std::shared_ptr<Scene> scene) : m_ParentId(parentId),
-                                                                            m_Scene(std::move(scene)) {}
+        explicit Component(size_t parentId, Scene* scene) : m_ParentId(parentId), m_Scene(scene) {}
 
         [[nodiscard]] Entity& GetParent() const;
 
@@ -17,6 +16,6 @@ namespace Iris {
         virtual void RenderUI() {};
     protected:
         size_t m_ParentId;
-        std::shared_ptr<Scene> m_Scene;
+        Scene* m_Scene;     // the scene owns its components, so a plain pointer is enough
     };
 }
@@ -0,0 +1,69 @@
+#pragma once
+
+namespace Iris {
+    // Sparse set holding every component of one type in the scene. Components are packed densely, the sparse
+    // table maps an entity to its slot. Removal moves the last component into the hole, so the dense array never
+    // has gaps and iterating a component type is a linear scan.
+    template <class T>
+    class ComponentPool final {
+    public:
+        static constexpr uint32_t Invalid = std::numeric_limits<uint32_t>::max();
+
+        // An entity has at most one component of each type, adding another one replaces it
+        template <class... Args>
+        T& Emplace(uint32_t entity, Args&&... args) {
+            if (entity >= m_Sparse.size()) m_Sparse.resize(entity + 1, Invalid);
+
+            if (m_Sparse[entity] != Invalid) {
+                auto& component = m_Components[m_Sparse[entity]];
+                component = T(std::forward<Args>(args)...);
+                return component;
+            }
+
+            m_Sparse[entity] = static_cast<uint32_t>(m_Components.size());
+            m_Entities.push_back(entity);
+            return m_Components.emplace_back(std::forward<Args>(args)...);
+        }
+
+        void Remove(uint32_t entity) {
+            if (!Has(entity)) return;
+
+            uint32_t slot = m_Sparse[entity];
+            uint32_t last = m_Entities.back();
+            if (slot != m_Components.size() - 1) {
+                m_Components[slot] = std::move(m_Components.back());
+                m_Entities[slot] = last;
+                m_Sparse[last] = slot;
+            }
+            m_Components.pop_back();
+            m_Entities.pop_back();
+            m_Sparse[entity] = Invalid;
+        }
+
+        [[nodiscard]] bool Has(uint32_t entity) const {
+            return entity < m_Sparse.size() && m_Sparse[entity] != Invalid;
+        }
+
+        T& Get(uint32_t entity) { return m_Components[m_Sparse[entity]]; }
+        const T& Get(uint32_t entity) const { return m_Components[m_Sparse[entity]]; }
+
+        T* TryGet(uint32_t entity) { return Has(entity) ? &m_Components[m_Sparse[entity]] : nullptr; }
+
+        [[nodiscard]] size_t Size() const { return m_Components.size(); }
+        void Reserve(size_t count) {
+            m_Components.reserve(count);
+            m_Entities.reserve(count);
+        }
+
+        // Dense arrays, index i of both belongs to the same entity
+        std::span<T> GetComponents() { return m_Components; }
+        [[nodiscard]] std::span<const uint32_t> GetEntities() const { return m_Entities; }
+
+        auto begin() { return m_Components.begin(); }
+        auto end() { return m_Components.end(); }
+    private:
+        std::vector<uint32_t> m_Sparse;     // entity -> slot, Invalid when the entity has no such component
+        std::vector<uint32_t> m_Entities;   // slot -> entity
+        std::vector<T> m_Components;        // slot -> component
+    };
+}
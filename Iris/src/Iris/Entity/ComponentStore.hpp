@@ -1,12 +1,20 @@
 #pragma once
+#include "Iris/Entity/ComponentPool.hpp"
 
-template <class... Ts> requires (sizeof...(Ts) > 0)
-class ComponentStore final {
-public:
-    template <class T>
-    std::vector<T>& GetComponents() {
-        return std::get<std::vector<T>>(m_Tuple);
-    }
-private:
-    std::tuple<std::vector<Ts>...> m_Tuple{};
-};
\ No newline at end of file
+namespace Iris {
+    // One pool per component type, shared by every entity of a scene
+    template <class... Ts> requires (sizeof...(Ts) > 0)
+    class ComponentStore final {
+    public:
+        template <class T>
+        ComponentPool<T>& GetPool() {
+            return std::get<ComponentPool<T>>(m_Tuple);
+        }
+
+        void RemoveAll(uint32_t entity) {
+            (std::get<ComponentPool<Ts>>(m_Tuple).Remove(entity), ...);
+        }
+    private:
+        std::tuple<ComponentPool<Ts>...> m_Tuple{};
+    };
+}
@@ -5,7 +5,7 @@
 #include "Iris/Scene/Scene.hpp"
 
 namespace Iris {
-    Camera::Camera(size_t parentId, const std::shared_ptr<Scene>& scene, float fov, float aspect, float nearClip,
+    Camera::Camera(size_t parentId, Scene* scene, float fov, float aspect, float nearClip,
                    float farClip)
             : Component(parentId, scene), m_FOV(fov), m_AspectRatio(aspect), m_NearClip(nearClip), m_FarClip(farClip) {
         UpdateView();
@@ -49,6 +49,14 @@ namespace Iris {
         return m_View;
     }
 
+    float Camera::GetNearClip() const {
+        return m_NearClip;
+    }
+
+    float Camera::GetFarClip() const {
+        return m_FarClip;
+    }
+
     void Camera::UpdateProjection() {
         m_AspectRatio = m_ViewportSize.x / m_ViewportSize.y;
         m_Projection = glm::perspective(glm::radians(m_FOV), m_AspectRatio, m_NearClip, m_FarClip);
@@ -7,7 +7,7 @@
 namespace Iris {
     class Camera final : public Component {
     public:
-        Camera(size_t parentId, const std::shared_ptr<Scene>& scene, float fov = 90.f, float aspect = 1600.f / 900.f,
+        Camera(size_t parentId, Scene* scene, float fov = 90.f, float aspect = 1600.f / 900.f,
                float nearClip = 0.1f, float farClip = 1000.f);
 
         void SetViewportSize(glm::vec2 size);
@@ -19,6 +19,8 @@ namespace Iris {
         [[nodiscard]] glm::vec3 GetRightDirection() const;
         [[nodiscard]] glm::mat4 GetProjectionMatrix() const;
         [[nodiscard]] glm::mat4 GetViewMatrix() const;
+        [[nodiscard]] float GetNearClip() const;
+        [[nodiscard]] float GetFarClip() const;
     private:
         void UpdateProjection();
         void UpdateView();
@@ -3,9 +3,9 @@
 #include <imgui.h>
 
 namespace Iris {
-    Light::Light(const size_t& parentId, const std::shared_ptr<Scene>& scene) : Component(parentId, scene) {}
+    Light::Light(const size_t& parentId, Scene* scene) : Component(parentId, scene) {}
 
-    Light::Light(const size_t& parentId, const std::shared_ptr<Scene>& scene, glm::vec3 color, LightType type)
+    Light::Light(const size_t& parentId, Scene* scene, glm::vec3 color, LightType type)
             : Light(parentId, scene) {
         this->color = color;
         this->type = type;
@@ -10,8 +10,8 @@ namespace Iris {
 
     class Light : public Component {
     public:
-        Light(const size_t& parentId, const std::shared_ptr<Scene>& scene);
-        Light(const size_t& parentId, const std::shared_ptr<Scene>& scene,
+        Light(const size_t& parentId, Scene* scene);
+        Light(const size_t& parentId, Scene* scene,
               glm::vec3 color, LightType type = LightType::SPOT);
         glm::vec3 color{ 1.f, 1.f, 1.f };
         LightType type{ LightType::SPOT };
@@ -1,5 +1,19 @@
 #include "Material.hpp"
+#include "Iris/Scene/Scene.hpp"
 
 namespace Iris {
+    Material::Material(size_t parentId, Scene* scene, std::string_view texture)
+            : Component(parentId, scene), m_Texture(texture), m_State(AssetState::Pending) {
+        auto handle = m_Scene->GetEntity(parentId).GetHandle();
+        AssetLoader::Get().LoadTexture(m_Texture, [scene, handle, path = m_Texture](
+                std::shared_ptr<const ImageData> image) {
+            if (!scene->IsAlive(handle)) return;
+            auto* material = scene->GetPool<Material>().TryGet(handle.id);
+            if (!material || material->m_State != AssetState::Pending || material->m_Texture != path) return;
 
+            material->m_Image = std::move(image);
+            material->m_State = material->m_Image ? AssetState::Loaded : AssetState::Failed;
+            scene->OnAssetResolved(handle);
+        });
+    }
 }
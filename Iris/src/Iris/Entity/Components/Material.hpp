@@ -1,20 +1,32 @@
 #pragma once
 #include "Iris/Entity/Component.hpp"
+#include "Iris/Asset/AssetLoader.hpp"
 
 namespace Iris {
     class Material final : public Component {
     public:
-        Material(size_t parentId, const std::shared_ptr<Scene>& scene) : Component(parentId, scene) {}
+        Material(size_t parentId, Scene* scene) : Component(parentId, scene) {}
 
-        Material(size_t parentId, const std::shared_ptr<Scene>& scene, std::string_view texture) :
-                Component(parentId, scene), m_Texture(texture) {}
+        // The texture is decoded in the background
+        Material(size_t parentId, Scene* scene, std::string_view texture);
 
         [[nodiscard]] const std::string& getTexture() const { return m_Texture; }
+        // Decoded texels once the state is Loaded
+        [[nodiscard]] const std::shared_ptr<const ImageData>& GetImage() const { return m_Image; }
+        [[nodiscard]] AssetState GetState() const { return m_State; }
+
+        // Cutout materials (foliage, fences) discard texels below half alpha, everything else ignores the
+        // texture's alpha. Read when the object is added to the renderer.
+        void SetAlphaTest(bool alphaTest) { m_AlphaTest = alphaTest; }
+        [[nodiscard]] bool IsAlphaTested() const { return m_AlphaTest; }
 
     private:
         glm::vec3 m_Ambient{};
         glm::vec3 m_Diffuse{};
         glm::vec3 m_Specular{};
         std::string m_Texture;
+        bool m_AlphaTest = false;
+        AssetState m_State = AssetState::Loaded;
+        std::shared_ptr<const ImageData> m_Image;
     };
 }
@@ -1,77 +1,62 @@
 #include "Mesh.hpp"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
 #include "Iris/Scene/Scene.hpp"
 
 namespace Iris {
 
     void Mesh::SetMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+        m_Path.clear();
+        m_State = AssetState::Loaded;
+        m_Asset.reset();
         m_Vertices = vertices;
         m_Indices = indices;
+        m_Submeshes = { Submesh{ .firstIndex = 0, .indexCount = static_cast<uint32_t>(m_Indices.size()) }};
+        m_Bounds = Bounds::FromVertices(m_Vertices);
     }
 
-    Mesh::Mesh(size_t parentId, const std::shared_ptr<Scene>& scene, std::vector<Vertex> vertices,
+    Mesh::Mesh(size_t parentId, Scene* scene, std::vector<Vertex> vertices,
                std::vector<uint32_t> indices)
-            : Component(parentId, scene), m_Vertices(std::move(vertices)), m_Indices(std::move(indices)) {}
-
-    Mesh::Mesh(size_t parentId, const std::shared_ptr<Scene>& scene, std::string_view path)
-            : Component(parentId, scene) {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn;
-        std::string err;
-        bool status = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.data());
-        if (!warn.empty()) {
-            Log::Core::Warn("Loading obj: {}", warn);
-        }
-
-        if (!err.empty()) {
-            Log::Core::Error("Loading obj: {}", err);
-        }
-
-        if (!status) {
-            Log::Core::Critical("Failed to load obj");
-            std::exit(-1);
-        }
-        m_Vertices.resize(attrib.vertices.size() / 3);
-        for (auto idx: shapes[0].mesh.indices) {
-            m_Indices.push_back(idx.vertex_index);
-            float nx = attrib.normals[idx.normal_index * 3];
-            float ny = attrib.normals[idx.normal_index * 3 + 1];
-            float nz = attrib.normals[idx.normal_index * 3 + 2];
-
-            float px = attrib.vertices[idx.vertex_index * 3];
-            float py = attrib.vertices[idx.vertex_index * 3 + 1];
-            float pz = attrib.vertices[idx.vertex_index * 3 + 2];
+            : Component(parentId, scene), m_Vertices(std::move(vertices)), m_Indices(std::move(indices)),
+              m_Submeshes{ Submesh{ .firstIndex = 0, .indexCount = static_cast<uint32_t>(m_Indices.size()) }},
+              m_Bounds(Bounds::FromVertices(m_Vertices)) {}
+
+    Mesh::Mesh(size_t parentId, Scene* scene, std::string_view path)
+            : Component(parentId, scene), m_Path(path), m_State(AssetState::Pending) {
+        auto handle = m_Scene->GetEntity(parentId).GetHandle();
+        AssetLoader::Get().LoadMesh(m_Path, [scene, handle, path = m_Path](std::shared_ptr<const MeshAsset> asset) {
+            // The entity may have been destroyed or given another mesh in the meantime
+            if (!scene->IsAlive(handle)) return;
+            auto* mesh = scene->GetPool<Mesh>().TryGet(handle.id);
+            if (!mesh || mesh->m_State != AssetState::Pending || mesh->m_Path != path) return;
+
+            mesh->m_Asset = std::move(asset);
+            mesh->m_State = mesh->m_Asset ? AssetState::Loaded : AssetState::Failed;
+            if (mesh->m_Asset) mesh->m_Bounds = mesh->m_Asset->GetBounds();
+            scene->OnAssetResolved(handle);
+        });
+    }
 
-            float cr = attrib.colors[idx.vertex_index * 3];
-            float cg = attrib.colors[idx.vertex_index * 3 + 1];
-            float cb = attrib.colors[idx.vertex_index * 3 + 2];
+    std::span<const Vertex> Mesh::GetVertices() const {
+        return m_Asset ? m_Asset->GetVertices() : std::span<const Vertex>(m_Vertices);
+    }
 
-            m_Vertices[idx.vertex_index].position = { px, py, pz, 1.f };
-            m_Vertices[idx.vertex_index].color = { cr, cg, cb, 1.f };
-            m_Vertices[idx.vertex_index].normal = { nx, ny, nz, 1.f };
+    std::span<const uint32_t> Mesh::GetIndices() const {
+        return m_Asset ? m_Asset->GetIndices() : std::span<const uint32_t>(m_Indices);
+    }
 
-            float u = 0.f, v = 0.f;
-            if (!attrib.texcoords.empty() && idx.texcoord_index != -1) {
-                u = attrib.texcoords[idx.texcoord_index * 2];
-                v = 1.0f - attrib.texcoords[idx.texcoord_index * 2 + 1]; // Flip Y coord.
-            }
-            m_Vertices[idx.vertex_index].uv = { u, v };
-        }
+    std::span<const Submesh> Mesh::GetSubmeshes() const {
+        return m_Asset ? m_Asset->GetSubmeshes() : std::span<const Submesh>(m_Submeshes);
     }
 
-    const std::vector<Vertex>& Mesh::GetVertices() const {
-        return m_Vertices;
+    const std::string& Mesh::GetPath() const {
+        return m_Path;
     }
 
-    const std::vector<uint32_t>& Mesh::GetIndices() const {
-        return m_Indices;
+    const Bounds& Mesh::GetBounds() const {
+        return m_Bounds;
     }
 
     glm::mat4 Mesh::GetModelMatrix() const {
-        return m_Scene->GetEntity(m_ParentId).GetTransform().GetMatrix();
+        return m_Scene->GetWorldMatrix(m_ParentId);
     }
 }
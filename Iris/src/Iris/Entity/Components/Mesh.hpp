@@ -1,21 +1,38 @@
 #pragma once
 #include "Iris/Entity/Component.hpp"
 #include "Iris/Renderer/Vertex.hpp"
+#include "Iris/Renderer/Bounds.hpp"
+#include "Iris/Renderer/MeshImporter.hpp"
+#include "Iris/Asset/AssetLoader.hpp"
 
 namespace Iris {
     class Mesh final : public Component {
     public:
-        Mesh(size_t parentId, const std::shared_ptr<Scene>& scene) : Component(parentId, scene) {}
-        Mesh(size_t parentId, const std::shared_ptr<Scene>& scene, std::vector<Vertex> vertices,  std::vector<uint32_t> indices);
-        Mesh(size_t parentId, const std::shared_ptr<Scene>& scene, std::string_view path);
+        Mesh(size_t parentId, Scene* scene) : Component(parentId, scene) {}
+        Mesh(size_t parentId, Scene* scene, std::vector<Vertex> vertices,  std::vector<uint32_t> indices);
+        // Imported in the background, the geometry is empty until the state leaves Pending
+        Mesh(size_t parentId, Scene* scene, std::string_view path);
 
         void SetMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
 
-        [[nodiscard]] const std::vector<Vertex>& GetVertices() const;
-        [[nodiscard]] const std::vector<uint32_t>& GetIndices() const;
+        // Point into the mapped cache for imported meshes, ready to be copied to a staging buffer
+        [[nodiscard]] std::span<const Vertex> GetVertices() const;
+        [[nodiscard]] std::span<const uint32_t> GetIndices() const;
+        [[nodiscard]] std::span<const Submesh> GetSubmeshes() const;
         [[nodiscard]] glm::mat4 GetModelMatrix() const;
+        // File the geometry was loaded from, empty for meshes built in code
+        [[nodiscard]] const std::string& GetPath() const;
+        // Content hash of the imported file, 0 for meshes built in code
+        [[nodiscard]] uint64_t GetContentHash() const { return m_Asset ? m_Asset->hash : 0; }
+        [[nodiscard]] const Bounds& GetBounds() const;
+        [[nodiscard]] AssetState GetState() const { return m_State; }
     private:
-        std::vector<Vertex> m_Vertices{};
+        std::string m_Path{};
+        AssetState m_State = AssetState::Loaded;
+        std::shared_ptr<const MeshAsset> m_Asset;   // shared by every copy of the component
+        std::vector<Vertex> m_Vertices{};           // meshes built in code
         std::vector<uint32_t> m_Indices{};
+        std::vector<Submesh> m_Submeshes{};
+        Bounds m_Bounds{};
     };
 }
@@ -4,8 +4,13 @@
 #include <glm/gtx/quaternion.hpp>
 #include "glm/gtc/type_ptr.hpp"
 #include <imgui.h>
+#include "Iris/Scene/Scene.hpp"
 
 namespace Iris {
+    Transform::Transform(size_t parentId, Scene* scene) : Component(parentId, scene) {
+        MarkDirty();
+    }
+
     const glm::vec3& Transform::GetTranslation() const {
         return m_Translation;
     }
@@ -18,41 +23,93 @@ namespace Iris {
         return m_Scale;
     }
 
-    glm::mat4 Transform::GetMatrix() const {
-        return glm::translate(glm::mat4(1.f), m_Translation)
-               * glm::toMat4(glm::quat(glm::radians(m_Rotation)))
-               * glm::scale(glm::mat4(1.f), m_Scale);
+    const glm::mat4& Transform::GetMatrix() {
+        if (m_LocalDirty) {
+            m_LocalMatrix = glm::translate(glm::mat4(1.f), m_Translation)
+                            * glm::toMat4(glm::quat(glm::radians(m_Rotation)))
+                            * glm::scale(glm::mat4(1.f), m_Scale);
+            m_NormalMatrix = glm::mat3x4(glm::transpose(glm::inverse(glm::mat3(m_LocalMatrix))));
+            m_LocalDirty = false;
+        }
+        return m_LocalMatrix;
+    }
+
+    const glm::mat4& Transform::GetWorldMatrix() const {
+        return m_Scene->GetWorldMatrix(m_ParentId);
     }
 
     void Transform::SetTranslation(const glm::vec3& translation) {
+        if (m_Translation == translation) return;
         m_Translation = translation;
+        MarkDirty();
     }
 
     void Transform::SetRotation(const glm::vec3& rotation) {
+        if (m_Rotation == rotation) return;
         m_Rotation = rotation;
+        MarkDirty();
     }
 
     void Transform::SetScale(const glm::vec3& scale) {
+        if (m_Scale == scale) return;
         m_Scale = scale;
+        MarkDirty();
     }
 
     void Transform::Move(const glm::vec3& offset) {
-        m_Translation += offset;
+        SetTranslation(m_Translation + offset);
     }
 
     void Transform::Rotate(const glm::vec3& offset) {
-        m_Rotation += offset;
+        SetRotation(m_Rotation + offset);
     }
 
     void Transform::Reset() {
-        m_Translation = { 0.f, 0.f, 0.f };
-        m_Rotation = { 0.f, 0.f, 0.f };
-        m_Scale = { 1.f, 1.f, 1.f };
+        SetTranslation({ 0.f, 0.f, 0.f });
+        SetRotation({ 0.f, 0.f, 0.f });
+        SetScale({ 1.f, 1.f, 1.f });
+    }
+
+    void Transform::SetParentEntity(size_t entity) {
+        if (entity == m_ParentEntity) return;
+        if (entity == NoParent) {
+            Detach();
+            return;
+        }
+
+        for (size_t ancestor = entity; ancestor != NoParent;
+             ancestor = m_Scene->GetEntity(ancestor).GetTransform().m_ParentEntity) {
+            if (ancestor == m_ParentId) {
+                Log::Core::Error("Can't parent entity {} to its own descendant {}", m_ParentId, entity);
+                return;
+            }
+        }
+
+        Detach();
+        m_ParentEntity = entity;
+        m_Scene->GetEntity(entity).GetTransform().m_Children.push_back(m_ParentId);
+        MarkDirty();
+    }
+
+    void Transform::Detach() {
+        if (m_ParentEntity == NoParent) return;
+
+        std::erase(m_Scene->GetEntity(m_ParentEntity).GetTransform().m_Children, m_ParentId);
+        m_ParentEntity = NoParent;
+        MarkDirty();
     }
 
     void Transform::RenderUI() {
-        ImGui::DragFloat3("Position", glm::value_ptr(m_Translation));
-        ImGui::DragFloat3("Rotation", glm::value_ptr(m_Rotation));
-        ImGui::DragFloat3("Scale", glm::value_ptr(m_Scale));
+        bool changed = ImGui::DragFloat3("Position", glm::value_ptr(m_Translation));
+        changed |= ImGui::DragFloat3("Rotation", glm::value_ptr(m_Rotation));
+        changed |= ImGui::DragFloat3("Scale", glm::value_ptr(m_Scale));
+        if (changed) MarkDirty();
+    }
+
+    void Transform::MarkDirty() {
+        m_LocalDirty = true;
+        if (m_Dirty) return;
+        m_Dirty = true;
+        m_Scene->MarkTransformDirty(m_ParentId);
     }
 }
@@ -2,14 +2,20 @@
 #include "Iris/Entity/Component.hpp"
 
 namespace Iris {
+    // Translation, rotation (euler degrees) and scale relative to the parent entity, or the world without one.
+    // The local matrix is cached, world matrices live in the scene and are recomputed only for changed subtrees.
     class Transform final : public Component {
     public:
-        Transform(size_t parentId, const std::shared_ptr<Scene>& scene) : Component(parentId, scene) {}
+        static constexpr size_t NoParent = std::numeric_limits<size_t>::max();
+
+        Transform(size_t parentId, Scene* scene);
 
         [[nodiscard]] const glm::vec3& GetTranslation() const;
         [[nodiscard]] const glm::vec3& GetRotation() const;
         [[nodiscard]] const glm::vec3& GetScale() const;
-        [[nodiscard]] glm::mat4 GetMatrix() const;
+        [[nodiscard]] const glm::mat4& GetMatrix();
+        // As of the last Scene::UpdateTransforms
+        [[nodiscard]] const glm::mat4& GetWorldMatrix() const;
 
         void SetTranslation(const glm::vec3& translation);
         void SetRotation(const glm::vec3& rotation);
@@ -20,10 +26,28 @@ namespace Iris {
 
         void Reset();
 
+        // The local transform is kept, so the entity moves with its new parent from now on
+        void SetParentEntity(size_t entity);
+        void Detach();
+        [[nodiscard]] size_t GetParentEntity() const { return m_ParentEntity; }
+        [[nodiscard]] const std::vector<size_t>& GetChildren() const { return m_Children; }
+
         void RenderUI() override;
+    private:
+        void MarkDirty();
     private:
         glm::vec3 m_Translation{ 0.f };
         glm::vec3 m_Rotation{ 0.f };
         glm::vec3 m_Scale{ 1.f };
+
+        glm::mat4 m_LocalMatrix{ 1.f };
+        glm::mat3x4 m_NormalMatrix{ 1.f };  // inverse transpose of the local matrix, std430 mat3 layout
+        bool m_LocalDirty = true;
+        bool m_Dirty = false;       // the world matrices of the subtree are stale, cleared by the scene
+
+        size_t m_ParentEntity = NoParent;
+        std::vector<size_t> m_Children;
+
+        friend class Scene;
     };
 }
@@ -1,26 +1,21 @@
 #include "Entity.hpp"
 #include <imgui.h>
-#include "Components/Camera.hpp"
+#include "Iris/Scene/Scene.hpp"
 
 namespace Iris {
-    void Entity::Update(float dt) {
-        UpdateT<Camera>(dt);
-    }
+    Entity::Entity(size_t id, Scene* scene) : m_Id(id), m_Scene(scene) {}
 
-    Entity::Entity(size_t id, std::shared_ptr<Scene> scene) : m_Id(id), m_Scene(std::move(scene)),
-                                                              m_Transform(m_Id, m_Scene) {}
+    Transform& Entity::GetTransform() {
+        return GetComponent<Transform>();
+    }
 
     void Entity::RenderUI() {
-        auto& lights = m_Components.GetComponents<Light>();
-
         ImGui::Text("Transform");
         GetTransform().RenderUI();
 
-        if (!lights.empty()) {
+        if (HasComponent<Light>()) {
             ImGui::Text("Light");
-            for (auto& light: lights) {
-                light.RenderUI();
-            }
+            GetComponent<Light>().RenderUI();
         }
     }
 }
@@ -1,6 +1,5 @@
 #pragma once
 #include "Iris/Entity/Component.hpp"
-#include "Iris/Entity/ComponentStore.hpp"
 #include "Iris/Entity/Components/Transform.hpp"
 #include "Iris/Entity/Components/Camera.hpp"
 #include "Iris/Entity/Components/Material.hpp"
@@ -10,51 +9,43 @@
 namespace Iris {
     class Scene;
 
+    // Stays valid for the lifetime of the entity, a destroyed entity's id is reused with a new generation
+    struct EntityHandle {
+        uint32_t id = 0;
+        uint32_t generation = 0;
+
+        bool operator==(const EntityHandle&) const = default;
+    };
+
+    // Thin handle into the scene, the components themselves live in the scene's pools.
+    // The component accessors are defined in Scene.hpp.
     class Entity final {
     public:
-        Entity(size_t id, std::shared_ptr<Scene> scene);
+        Entity(size_t id, Scene* scene);
 
-        void Update(float dt);
-
-        Transform& GetTransform() { return m_Transform; };
+        Transform& GetTransform();
 
         template <class T>
-        std::vector<T>& GetComponents() {
-            return m_Components.template GetComponents<T>();
-        }
+        T& GetComponent();
 
         template <class T>
-        T& GetComponent() {
-            return m_Components.template GetComponents<T>()[0];
-        }
+        bool HasComponent() const;
 
         template <class T, class... Ts>
-        Entity& AddComponent(Ts... args) {
-            m_Components.template GetComponents<T>().emplace_back(m_Id, m_Scene, args...);
-            return *this;
-        }
+        Entity& AddComponent(Ts... args);
 
-        [[nodiscard]] size_t GetId() const { return m_Id; };
-        void RenderUI();
-    private:
         template <class T>
-        requires std::is_base_of_v<Component, T>
-        void UpdateT(float dt) {
-            for (T& item: GetComponents<T>()) {
-                item.Update(dt);
-            }
-        }
+        void RemoveComponent();
 
+        [[nodiscard]] size_t GetId() const { return m_Id; };
+        [[nodiscard]] EntityHandle GetHandle() const { return { static_cast<uint32_t>(m_Id), m_Generation }; };
+        void RenderUI();
     private:
         size_t m_Id;
-        std::shared_ptr<Scene> m_Scene;
-        Transform m_Transform;
-
-        ComponentStore<
-                Camera,
-                Material,
-                Mesh,
-                Light
-        > m_Components;
+        uint32_t m_Generation = 0;
+        bool m_Alive = true;
+        Scene* m_Scene;
+
+        friend Scene;
     };
 }
@@ -103,4 +103,23 @@ namespace Iris::Math {
 
         return true;
     }
-}
\ No newline at end of file
+
+    std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& viewProjection) {
+        auto row = [&](int i) {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+
+        std::array<glm::vec4, 6> planes = {
+                row(3) + row(0), // left
+                row(3) - row(0), // right
+                row(3) + row(1), // bottom
+                row(3) - row(1), // top
+                row(2),          // near
+                row(3) - row(2)  // far
+        };
+        for (auto& plane: planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return planes;
+    }
+}
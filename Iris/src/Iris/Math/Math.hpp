@@ -3,4 +3,7 @@
 
 namespace Iris::Math {
     bool DecomposeTransform(glm::mat4 transform, glm::vec3& outTranslate, glm::vec3& outRotation, glm::vec3& outScale);
+
+    // Planes as (normal, distance) with normals pointing inside, using Vulkan's 0 <= z <= w clip volume
+    std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& viewProjection);
 }
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "TransformBatch.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define IRIS_X86
+#include <immintrin.h>
+// SSE2 is part of x86-64, the wider kernels are compiled per function with the target attribute and only
+// called after checking the CPU, so the rest of the build doesn't need any -m flags
+#if defined(__GNUC__)
+#define IRIS_X86_TARGETS
+#define IRIS_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace Iris::Math {
+    void TransformBatch::Resize(size_t count) {
+        for (auto* array: { &tx, &ty, &tz, &qx, &qy, &qz, &qw, &sx, &sy, &sz }) {
+            array->resize(count);
+        }
+    }
+
+    void TransformBatch::Set(size_t i, const glm::vec3& translation, const glm::quat& rotation,
+                             const glm::vec3& scale) {
+        tx[i] = translation.x;
+        ty[i] = translation.y;
+        tz[i] = translation.z;
+        qx[i] = rotation.x;
+        qy[i] = rotation.y;
+        qz[i] = rotation.z;
+        qw[i] = rotation.w;
+        sx[i] = scale.x;
+        sy[i] = scale.y;
+        sz[i] = scale.z;
+    }
+
+    // Reference implementation and tail of the SIMD kernels. Same terms as glm::mat3_cast, so the results match
+    // glm::translate * glm::toMat4 * glm::scale.
+    static void ComposeScalar(const TransformBatch& b, size_t begin, size_t end, glm::mat4* world,
+                              glm::mat3x4* normals) {
+        for (size_t i = begin; i < end; ++i) {
+            float x = b.qx[i], y = b.qy[i], z = b.qz[i], w = b.qw[i];
+            float x2 = x + x, y2 = y + y, z2 = z + z;
+            float xx = x * x2, yy = y * y2, zz = z * z2;
+            float xy = x * y2, xz = x * z2, yz = y * z2;
+            float wx = w * x2, wy = w * y2, wz = w * z2;
+
+            glm::vec3 r0(1.f - (yy + zz), xy + wz, xz - wy);
+            glm::vec3 r1(xy - wz, 1.f - (xx + zz), yz + wx);
+            glm::vec3 r2(xz + wy, yz - wx, 1.f - (xx + yy));
+
+            world[i] = glm::mat4(glm::vec4(r0 * b.sx[i], 0.f), glm::vec4(r1 * b.sy[i], 0.f),
+                                 glm::vec4(r2 * b.sz[i], 0.f), glm::vec4(b.tx[i], b.ty[i], b.tz[i], 1.f));
+            if (normals) {
+                normals[i] = glm::mat3x4(glm::vec4(r0 / b.sx[i], 0.f), glm::vec4(r1 / b.sy[i], 0.f),
+                                         glm::vec4(r2 / b.sz[i], 0.f));
+            }
+        }
+    }
+
+#ifdef IRIS_X86
+    // a..d hold one row of a column for 4 transforms, written out as that column of each of the 4 matrices
+    static inline void StoreColumnsSSE(__m128 a, __m128 b, __m128 c, __m128 d, float* out, size_t stride) {
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        _mm_storeu_ps(out, a);
+        _mm_storeu_ps(out + stride, b);
+        _mm_storeu_ps(out + 2 * stride, c);
+        _mm_storeu_ps(out + 3 * stride, d);
+    }
+
+    static void ComposeSSE(const TransformBatch& b, size_t begin, size_t end, glm::mat4* world,
+                           glm::mat3x4* normals) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            __m128 x = _mm_loadu_ps(&b.qx[i]), y = _mm_loadu_ps(&b.qy[i]);
+            __m128 z = _mm_loadu_ps(&b.qz[i]), w = _mm_loadu_ps(&b.qw[i]);
+            __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+            __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+            __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+            __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+            __m128 r00 = _mm_sub_ps(one, _mm_add_ps(yy, zz)), r01 = _mm_add_ps(xy, wz), r02 = _mm_sub_ps(xz, wy);
+            __m128 r10 = _mm_sub_ps(xy, wz), r11 = _mm_sub_ps(one, _mm_add_ps(xx, zz)), r12 = _mm_add_ps(yz, wx);
+            __m128 r20 = _mm_add_ps(xz, wy), r21 = _mm_sub_ps(yz, wx), r22 = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+
+            __m128 sx = _mm_loadu_ps(&b.sx[i]), sy = _mm_loadu_ps(&b.sy[i]), sz = _mm_loadu_ps(&b.sz[i]);
+            float* out = glm::value_ptr(world[i]);
+            StoreColumnsSSE(_mm_mul_ps(r00, sx), _mm_mul_ps(r01, sx), _mm_mul_ps(r02, sx), zero, out, 16);
+            StoreColumnsSSE(_mm_mul_ps(r10, sy), _mm_mul_ps(r11, sy), _mm_mul_ps(r12, sy), zero, out + 4, 16);
+            StoreColumnsSSE(_mm_mul_ps(r20, sz), _mm_mul_ps(r21, sz), _mm_mul_ps(r22, sz), zero, out + 8, 16);
+            StoreColumnsSSE(_mm_loadu_ps(&b.tx[i]), _mm_loadu_ps(&b.ty[i]), _mm_loadu_ps(&b.tz[i]), one,
+                            out + 12, 16);
+
+            if (normals) {
+                __m128 ix = _mm_div_ps(one, sx), iy = _mm_div_ps(one, sy), iz = _mm_div_ps(one, sz);
+                float* n = glm::value_ptr(normals[i]);
+                StoreColumnsSSE(_mm_mul_ps(r00, ix), _mm_mul_ps(r01, ix), _mm_mul_ps(r02, ix), zero, n, 12);
+                StoreColumnsSSE(_mm_mul_ps(r10, iy), _mm_mul_ps(r11, iy), _mm_mul_ps(r12, iy), zero, n + 4, 12);
+                StoreColumnsSSE(_mm_mul_ps(r20, iz), _mm_mul_ps(r21, iz), _mm_mul_ps(r22, iz), zero, n + 8, 12);
+            }
+        }
+        ComposeScalar(b, i, end, world, normals);
+    }
+#endif
+
+#ifdef IRIS_X86_TARGETS
+    // Transposes within each 128 bit lane, so lane k of the result rows holds transforms e and e + 4
+    IRIS_TARGET("avx2,fma")
+    static inline void StoreColumnsAVX2(__m256 a, __m256 b, __m256 c, __m256 d, float* out, size_t stride) {
+        __m256 t0 = _mm256_unpacklo_ps(a, b), t1 = _mm256_unpackhi_ps(a, b);
+        __m256 t2 = _mm256_unpacklo_ps(c, d), t3 = _mm256_unpackhi_ps(c, d);
+        __m256 rows[4] = {
+                _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+                _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+        };
+        for (size_t e = 0; e < 4; ++e) {
+            _mm_storeu_ps(out + e * stride, _mm256_castps256_ps128(rows[e]));
+            _mm_storeu_ps(out + (e + 4) * stride, _mm256_extractf128_ps(rows[e], 1));
+        }
+    }
+
+    IRIS_TARGET("avx2,fma")
+    static void ComposeAVX2(const TransformBatch& b, size_t begin, size_t end, glm::mat4* world,
+                            glm::mat3x4* normals) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.f);
+
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            __m256 x = _mm256_loadu_ps(&b.qx[i]), y = _mm256_loadu_ps(&b.qy[i]);
+            __m256 z = _mm256_loadu_ps(&b.qz[i]), w = _mm256_loadu_ps(&b.qw[i]);
+            __m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+            __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+            __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+            __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+            __m256 r00 = _mm256_sub_ps(one, _mm256_add_ps(yy, zz));
+            __m256 r01 = _mm256_add_ps(xy, wz), r02 = _mm256_sub_ps(xz, wy);
+            __m256 r10 = _mm256_sub_ps(xy, wz), r12 = _mm256_add_ps(yz, wx);
+            __m256 r11 = _mm256_sub_ps(one, _mm256_add_ps(xx, zz));
+            __m256 r20 = _mm256_add_ps(xz, wy), r21 = _mm256_sub_ps(yz, wx);
+            __m256 r22 = _mm256_sub_ps(one, _mm256_add_ps(xx, yy));
+
+            __m256 sx = _mm256_loadu_ps(&b.sx[i]), sy = _mm256_loadu_ps(&b.sy[i]), sz = _mm256_loadu_ps(&b.sz[i]);
+            float* out = glm::value_ptr(world[i]);
+            StoreColumnsAVX2(_mm256_mul_ps(r00, sx), _mm256_mul_ps(r01, sx), _mm256_mul_ps(r02, sx), zero, out, 16);
+            StoreColumnsAVX2(_mm256_mul_ps(r10, sy), _mm256_mul_ps(r11, sy), _mm256_mul_ps(r12, sy), zero, out + 4,
+                             16);
+            StoreColumnsAVX2(_mm256_mul_ps(r20, sz), _mm256_mul_ps(r21, sz), _mm256_mul_ps(r22, sz), zero, out + 8,
+                             16);
+            StoreColumnsAVX2(_mm256_loadu_ps(&b.tx[i]), _mm256_loadu_ps(&b.ty[i]), _mm256_loadu_ps(&b.tz[i]), one,
+                             out + 12, 16);
+
+            if (normals) {
+                __m256 ix = _mm256_div_ps(one, sx), iy = _mm256_div_ps(one, sy), iz = _mm256_div_ps(one, sz);
+                float* n = glm::value_ptr(normals[i]);
+                StoreColumnsAVX2(_mm256_mul_ps(r00, ix), _mm256_mul_ps(r01, ix), _mm256_mul_ps(r02, ix), zero, n, 12);
+                StoreColumnsAVX2(_mm256_mul_ps(r10, iy), _mm256_mul_ps(r11, iy), _mm256_mul_ps(r12, iy), zero, n + 4,
+                                 12);
+                StoreColumnsAVX2(_mm256_mul_ps(r20, iz), _mm256_mul_ps(r21, iz), _mm256_mul_ps(r22, iz), zero, n + 8,
+                                 12);
+            }
+        }
+        ComposeScalar(b, i, end, world, normals);
+    }
+
+    // Same as the AVX2 transpose, the 4 lanes hold transforms e, e + 4, e + 8 and e + 12
+    IRIS_TARGET("avx512f")
+    static inline void StoreColumnsAVX512(__m512 a, __m512 b, __m512 c, __m512 d, float* out, size_t stride) {
+        __m512 t0 = _mm512_unpacklo_ps(a, b), t1 = _mm512_unpackhi_ps(a, b);
+        __m512 t2 = _mm512_unpacklo_ps(c, d), t3 = _mm512_unpackhi_ps(c, d);
+        __m512 rows[4] = {
+                _mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+                _mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+        };
+        for (size_t e = 0; e < 4; ++e) {
+            _mm_storeu_ps(out + e * stride, _mm512_extractf32x4_ps(rows[e], 0));
+            _mm_storeu_ps(out + (e + 4) * stride, _mm512_extractf32x4_ps(rows[e], 1));
+            _mm_storeu_ps(out + (e + 8) * stride, _mm512_extractf32x4_ps(rows[e], 2));
+            _mm_storeu_ps(out + (e + 12) * stride, _mm512_extractf32x4_ps(rows[e], 3));
+        }
+    }
+
+    IRIS_TARGET("avx512f")
+    static void ComposeAVX512(const TransformBatch& b, size_t begin, size_t end, glm::mat4* world,
+                              glm::mat3x4* normals) {
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 one = _mm512_set1_ps(1.f);
+
+        size_t i = begin;
+        for (; i + 16 <= end; i += 16) {
+            __m512 x = _mm512_loadu_ps(&b.qx[i]), y = _mm512_loadu_ps(&b.qy[i]);
+            __m512 z = _mm512_loadu_ps(&b.qz[i]), w = _mm512_loadu_ps(&b.qw[i]);
+            __m512 x2 = _mm512_add_ps(x, x), y2 = _mm512_add_ps(y, y), z2 = _mm512_add_ps(z, z);
+            __m512 xx = _mm512_mul_ps(x, x2), yy = _mm512_mul_ps(y, y2), zz = _mm512_mul_ps(z, z2);
+            __m512 xy = _mm512_mul_ps(x, y2), xz = _mm512_mul_ps(x, z2), yz = _mm512_mul_ps(y, z2);
+            __m512 wx = _mm512_mul_ps(w, x2), wy = _mm512_mul_ps(w, y2), wz = _mm512_mul_ps(w, z2);
+
+            __m512 r00 = _mm512_sub_ps(one, _mm512_add_ps(yy, zz));
+            __m512 r01 = _mm512_add_ps(xy, wz), r02 = _mm512_sub_ps(xz, wy);
+            __m512 r10 = _mm512_sub_ps(xy, wz), r12 = _mm512_add_ps(yz, wx);
+            __m512 r11 = _mm512_sub_ps(one, _mm512_add_ps(xx, zz));
+            __m512 r20 = _mm512_add_ps(xz, wy), r21 = _mm512_sub_ps(yz, wx);
+            __m512 r22 = _mm512_sub_ps(one, _mm512_add_ps(xx, yy));
+
+            __m512 sx = _mm512_loadu_ps(&b.sx[i]), sy = _mm512_loadu_ps(&b.sy[i]), sz = _mm512_loadu_ps(&b.sz[i]);
+            float* out = glm::value_ptr(world[i]);
+            StoreColumnsAVX512(_mm512_mul_ps(r00, sx), _mm512_mul_ps(r01, sx), _mm512_mul_ps(r02, sx), zero, out,
+                               16);
+            StoreColumnsAVX512(_mm512_mul_ps(r10, sy), _mm512_mul_ps(r11, sy), _mm512_mul_ps(r12, sy), zero,
+                               out + 4, 16);
+            StoreColumnsAVX512(_mm512_mul_ps(r20, sz), _mm512_mul_ps(r21, sz), _mm512_mul_ps(r22, sz), zero,
+                               out + 8, 16);
+            StoreColumnsAVX512(_mm512_loadu_ps(&b.tx[i]), _mm512_loadu_ps(&b.ty[i]), _mm512_loadu_ps(&b.tz[i]),
+                               one, out + 12, 16);
+
+            if (normals) {
+                __m512 ix = _mm512_div_ps(one, sx), iy = _mm512_div_ps(one, sy), iz = _mm512_div_ps(one, sz);
+                float* n = glm::value_ptr(normals[i]);
+                StoreColumnsAVX512(_mm512_mul_ps(r00, ix), _mm512_mul_ps(r01, ix), _mm512_mul_ps(r02, ix), zero, n,
+                                   12);
+                StoreColumnsAVX512(_mm512_mul_ps(r10, iy), _mm512_mul_ps(r11, iy), _mm512_mul_ps(r12, iy), zero,
+                                   n + 4, 12);
+                StoreColumnsAVX512(_mm512_mul_ps(r20, iz), _mm512_mul_ps(r21, iz), _mm512_mul_ps(r22, iz), zero,
+                                   n + 8, 12);
+            }
+        }
+        ComposeScalar(b, i, end, world, normals);
+    }
+#endif
+
+    SimdLevel GetSimdLevel() {
+        static const SimdLevel level = [] {
+#if defined(IRIS_X86_TARGETS)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+            return SimdLevel::SSE;
+#elif defined(IRIS_X86)
+            return SimdLevel::SSE;
+#else
+            return SimdLevel::Scalar;
+#endif
+        }();
+        return level;
+    }
+
+    std::string_view ToString(SimdLevel level) {
+        switch (level) {
+            case SimdLevel::Scalar:
+                return "Scalar";
+            case SimdLevel::SSE:
+                return "SSE";
+            case SimdLevel::AVX2:
+                return "AVX2";
+            case SimdLevel::AVX512:
+                return "AVX-512";
+        }
+        return "Unknown";
+    }
+
+    void ComposeTransforms(const TransformBatch& batch, std::span<glm::mat4> world, std::span<glm::mat3x4> normals,
+                           SimdLevel level) {
+        size_t count = batch.Size();
+        if (world.size() < count || (!normals.empty() && normals.size() < count)) {
+            Log::Core::Error("ComposeTransforms: output holds fewer than {} matrices", count);
+            return;
+        }
+        glm::mat3x4* n = normals.empty() ? nullptr : normals.data();
+
+        switch (std::min(level, GetSimdLevel())) {
+#ifdef IRIS_X86_TARGETS
+            case SimdLevel::AVX512:
+                ComposeAVX512(batch, 0, count, world.data(), n);
+                return;
+            case SimdLevel::AVX2:
+                ComposeAVX2(batch, 0, count, world.data(), n);
+                return;
+#endif
+#ifdef IRIS_X86
+            case SimdLevel::SSE:
+                ComposeSSE(batch, 0, count, world.data(), n);
+                return;
+#endif
+            default:
+                ComposeScalar(batch, 0, count, world.data(), n);
+                return;
+        }
+    }
+
+    static float MaxDifference(const float* a, const float* b, size_t count) {
+        float error = 0.f;
+        for (size_t i = 0; i < count; ++i) error = std::max(error, std::abs(a[i] - b[i]));
+        return error;
+    }
+
+    void BenchmarkTransforms(size_t count, uint32_t iterations) {
+        TransformBatch batch;
+        batch.Resize(count);
+
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-100.f, 100.f);
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.f);
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 axis = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.f, 0.f, 1e-3f));
+            batch.Set(i, { position(rng), position(rng), position(rng) }, glm::angleAxis(unit(rng) * 3.14159f, axis),
+                      { scale(rng), scale(rng), scale(rng) });
+        }
+
+        std::vector<glm::mat4> reference(count), world(count);
+        std::vector<glm::mat3x4> referenceNormals(count), normals(count);
+        ComposeTransforms(batch, reference, referenceNormals, SimdLevel::Scalar);
+
+        Log::Core::Info("Composing {} transforms with normal matrices, {} iterations on one thread", count,
+                        iterations);
+        for (auto level: { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+            if (level > GetSimdLevel()) break;
+
+            ComposeTransforms(batch, world, normals, level);
+            float error = std::max(
+                    MaxDifference(glm::value_ptr(world[0]), glm::value_ptr(reference[0]), count * 16),
+                    MaxDifference(glm::value_ptr(normals[0]), glm::value_ptr(referenceNormals[0]), count * 12));
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (uint32_t i = 0; i < iterations; ++i) {
+                ComposeTransforms(batch, world, normals, level);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start)
+                                .count() / iterations;
+            Log::Core::Info("{:>8}: {:.3f}ms ({:.1f}M transforms/s), max difference to scalar {:.2e}",
+                            ToString(level), ms, static_cast<double>(count) / ms / 1000.0, error);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace Iris::Math {
+    // Translations, rotations and scales of many transforms, one array per component so the kernels can load
+    // a full register of each at once
+    struct TransformBatch {
+        std::vector<float> tx, ty, tz;
+        std::vector<float> qx, qy, qz, qw;
+        std::vector<float> sx, sy, sz;
+
+        void Resize(size_t count);
+        [[nodiscard]] size_t Size() const { return tx.size(); }
+        void Set(size_t i, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+    };
+
+    enum class SimdLevel {
+        Scalar,
+        SSE,
+        AVX2,
+        AVX512
+    };
+
+    // Widest instruction set the CPU supports and this build has a kernel for
+    SimdLevel GetSimdLevel();
+    std::string_view ToString(SimdLevel level);
+
+    // world[i] = T * R * S. When normals isn't empty normals[i] is the inverse transpose of the upper 3x3, with
+    // the columns padded to vec4 like a mat3 in std140/std430. Levels above GetSimdLevel() are clamped.
+    void ComposeTransforms(const TransformBatch& batch, std::span<glm::mat4> world,
+                           std::span<glm::mat3x4> normals = {}, SimdLevel level = GetSimdLevel());
+
+    // Times every supported kernel on count random transforms and checks them against the scalar one
+    void BenchmarkTransforms(size_t count, uint32_t iterations = 20);
+}
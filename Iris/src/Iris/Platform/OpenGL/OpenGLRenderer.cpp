@@ -69,7 +69,7 @@ namespace Iris {
         for (GLMesh& obj: m_Meshes) {
             auto& object = m_Scene->GetEntity(obj.GetParentId());
 
-            if (!object.GetComponents<Material>().empty()) {
+            if (object.HasComponent<Material>()) {
                 m_ShaderProgram2->Use();
 
                 m_ShaderProgram2->SetUniform("view", camera.GetViewMatrix());
@@ -114,16 +114,20 @@ namespace Iris {
     void OpenGLRenderer::TransferObjects() {
         std::scoped_lock l(m_QueueMutex);
         for (uint32_t i = 0; i < m_EntityQueue.size(); ++i) {
-            for (auto& mesh: m_Scene->GetEntity(m_EntityQueue[i]).GetComponents<Mesh>()) {
+            auto& object = m_Scene->GetEntity(m_EntityQueue[i]);
+            if (object.HasComponent<Mesh>()) {
+                auto& mesh = object.GetComponent<Mesh>();
                 auto temp = GLMesh(GL_TRIANGLES, m_EntityQueue[i]);
-                temp.SetVertices(mesh.GetVertices());
-                temp.SetIndices(mesh.GetIndices());
+                auto vertices = mesh.GetVertices();
+                auto indices = mesh.GetIndices();
+                temp.SetVertices({ vertices.begin(), vertices.end() });
+                temp.SetIndices({ indices.begin(), indices.end() });
                 m_Meshes.emplace_back(temp);
             }
 
-            for (auto& material: m_Scene->GetEntity(m_EntityQueue[i]).GetComponents<Material>()) {
+            if (object.HasComponent<Material>()) {
                 m_Textures.emplace_back();
-                m_Textures[m_Textures.size() - 1].loadFromFile(material.getTexture());
+                m_Textures[m_Textures.size() - 1].loadFromFile(object.GetComponent<Material>().getTexture());
             }
         }
         m_EntityQueue.clear();
@@ -167,8 +171,8 @@ namespace Iris {
     void OpenGLRenderer::SetScene(const std::shared_ptr<Scene>& scene) {
         Renderer::SetScene(scene);
         m_Scene->on<ObjectAdd>([this](uint32_t entityId) {
-            if (!m_Scene->GetEntity(entityId).GetComponents<Mesh>().empty()
-                || !m_Scene->GetEntity(entityId).GetComponents<Material>().empty()) {
+            if (m_Scene->GetEntity(entityId).HasComponent<Mesh>()
+                || m_Scene->GetEntity(entityId).HasComponent<Material>()) {
                 std::scoped_lock l(m_QueueMutex);
                 m_EntityQueue.emplace_back(entityId);
             }
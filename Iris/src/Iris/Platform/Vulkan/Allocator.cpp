@@ -0,0 +1,314 @@
+#include "Allocator.hpp"
+
+namespace Iris::Vulkan {
+    static constexpr vk::DeviceSize MinBuddySize = 256;
+    static constexpr vk::DeviceSize MaxBlockSize = 64ull * 1024 * 1024;
+    static constexpr vk::DeviceSize MinBlockSize = 1ull * 1024 * 1024;
+
+    struct MemoryBlock {
+        vk::DeviceMemory memory;
+        vk::DeviceSize size = 0;
+        uint32_t memoryType = 0;
+        AllocationKind kind = AllocationKind::Linear;
+        AllocationStrategy strategy = AllocationStrategy::Buddy;
+
+        vk::DeviceSize used = 0;
+        uint32_t allocationCount = 0;
+
+        // Buddy: free offsets for every order, order 0 being MinBuddySize
+        std::vector<std::set<vk::DeviceSize>> freeLists;
+        // Linear: bump pointer, rewound once every allocation in the block is freed
+        vk::DeviceSize head = 0;
+
+        void* mapped = nullptr;
+        uint32_t mapCount = 0;
+    };
+
+    static vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    static vk::DeviceSize RoundUpPow2(vk::DeviceSize value) {
+        vk::DeviceSize result = MinBuddySize;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    static uint32_t BuddyOrder(vk::DeviceSize size) {
+        uint32_t order = 0;
+        while ((MinBuddySize << order) < size) order++;
+        return order;
+    }
+
+    static float ToMiB(vk::DeviceSize bytes) {
+        return static_cast<float>(bytes) / (1024.f * 1024.f);
+    }
+
+    Allocator::Allocator(vk::PhysicalDevice physDevice, vk::Device device) : m_Device(device) {
+        m_MemoryProperties = physDevice.getMemoryProperties();
+        auto limits = physDevice.getProperties().limits;
+        m_BufferImageGranularity = limits.bufferImageGranularity;
+        m_MaxAllocationCount = limits.maxMemoryAllocationCount;
+    }
+
+    Allocation Allocator::Allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags flags,
+                                   AllocationKind kind, AllocationStrategy strategy) {
+        std::lock_guard lock(m_Mutex);
+
+        uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, flags);
+        vk::DeviceSize blockSize = GetBlockSize(memoryType);
+
+        // Without a granularity restriction buffers and images can share blocks
+        if (m_BufferImageGranularity <= 1) kind = AllocationKind::Linear;
+
+        Allocation allocation;
+        allocation.size = requirements.size;
+
+        if (strategy == AllocationStrategy::Dedicated || requirements.size > blockSize / 2) {
+            MemoryBlock* block = CreateBlock(requirements.size, memoryType, kind, AllocationStrategy::Dedicated);
+            block->used = requirements.size;
+            block->allocationCount = 1;
+
+            allocation.memory = block->memory;
+            allocation.block = block;
+            allocation.reserved = requirements.size;
+            return allocation;
+        }
+
+        if (strategy == AllocationStrategy::Linear) {
+            for (auto& block: m_Blocks) {
+                if (block->strategy != strategy || block->memoryType != memoryType || block->kind != kind) continue;
+                vk::DeviceSize offset = AlignUp(block->head, requirements.alignment);
+                if (offset + requirements.size > block->size) continue;
+
+                allocation.offset = offset;
+                allocation.block = block.get();
+                break;
+            }
+            if (!allocation.block) {
+                allocation.block = CreateBlock(blockSize, memoryType, kind, strategy);
+                allocation.offset = 0;
+            }
+            allocation.reserved = allocation.offset + requirements.size - allocation.block->head;
+            allocation.block->head = allocation.offset + requirements.size;
+        } else {
+            // Buddy offsets are aligned to their own size, which covers the alignment requirement
+            vk::DeviceSize size = RoundUpPow2(std::max(requirements.size, requirements.alignment));
+            for (auto& block: m_Blocks) {
+                if (block->strategy != strategy || block->memoryType != memoryType || block->kind != kind) continue;
+                if (auto offset = BuddyAllocate(*block, size)) {
+                    allocation.offset = *offset;
+                    allocation.block = block.get();
+                    break;
+                }
+            }
+            if (!allocation.block) {
+                allocation.block = CreateBlock(blockSize, memoryType, kind, strategy);
+                allocation.offset = *BuddyAllocate(*allocation.block, size);
+            }
+            allocation.reserved = size;
+        }
+
+        allocation.memory = allocation.block->memory;
+        allocation.block->used += allocation.reserved;
+        allocation.block->allocationCount++;
+        return allocation;
+    }
+
+    Allocation Allocator::AllocateBuffer(vk::Buffer buffer, vk::MemoryPropertyFlags flags,
+                                         AllocationStrategy strategy) {
+        auto allocation = Allocate(m_Device.getBufferMemoryRequirements(buffer), flags, AllocationKind::Linear,
+                                   strategy);
+        m_Device.bindBufferMemory(buffer, allocation.memory, allocation.offset);
+        return allocation;
+    }
+
+    Allocation Allocator::AllocateImage(vk::Image image, vk::ImageTiling tiling, vk::MemoryPropertyFlags flags,
+                                        AllocationStrategy strategy) {
+        auto kind = tiling == vk::ImageTiling::eOptimal ? AllocationKind::Optimal : AllocationKind::Linear;
+        auto allocation = Allocate(m_Device.getImageMemoryRequirements(image), flags, kind, strategy);
+        m_Device.bindImageMemory(image, allocation.memory, allocation.offset);
+        return allocation;
+    }
+
+    void Allocator::Free(Allocation& allocation) {
+        if (!allocation) return;
+        std::lock_guard lock(m_Mutex);
+
+        MemoryBlock* block = allocation.block;
+        block->used -= allocation.reserved;
+        block->allocationCount--;
+
+        switch (block->strategy) {
+            case AllocationStrategy::Dedicated:
+                DestroyBlock(block);
+                break;
+            case AllocationStrategy::Linear:
+                if (block->allocationCount == 0) block->head = 0;
+                break;
+            case AllocationStrategy::Buddy: {
+                BuddyFree(*block, allocation.offset, allocation.reserved);
+
+                // Keep one empty block per memory type around so alloc/free patterns don't thrash the driver
+                if (block->allocationCount != 0 || block->mapCount != 0) break;
+                bool hasSibling = std::any_of(m_Blocks.begin(), m_Blocks.end(), [&](const auto& other) {
+                    return other.get() != block && other->strategy == block->strategy &&
+                           other->memoryType == block->memoryType && other->kind == block->kind;
+                });
+                if (hasSibling) DestroyBlock(block);
+                break;
+            }
+        }
+
+        allocation = {};
+    }
+
+    void* Allocator::Map(const Allocation& allocation) {
+        std::lock_guard lock(m_Mutex);
+
+        MemoryBlock* block = allocation.block;
+        if (block->mapCount++ == 0) {
+            block->mapped = m_Device.mapMemory(block->memory, 0, VK_WHOLE_SIZE);
+        }
+        return static_cast<uint8_t*>(block->mapped) + allocation.offset;
+    }
+
+    void Allocator::Unmap(const Allocation& allocation) {
+        std::lock_guard lock(m_Mutex);
+
+        MemoryBlock* block = allocation.block;
+        assert(block->mapCount > 0);
+        if (--block->mapCount == 0) {
+            m_Device.unmapMemory(block->memory);
+            block->mapped = nullptr;
+        }
+    }
+
+    std::vector<HeapStats> Allocator::GetHeapStats() const {
+        std::lock_guard lock(m_Mutex);
+
+        std::vector<HeapStats> stats(m_MemoryProperties.memoryHeapCount);
+        for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++) {
+            stats[i].heapSize = m_MemoryProperties.memoryHeaps[i].size;
+        }
+        for (const auto& block: m_Blocks) {
+            auto& heap = stats[m_MemoryProperties.memoryTypes[block->memoryType].heapIndex];
+            heap.blockBytes += block->size;
+            heap.usedBytes += block->used;
+            heap.blockCount++;
+            heap.allocationCount += block->allocationCount;
+        }
+        return stats;
+    }
+
+    void Allocator::LogStats() const {
+        auto stats = GetHeapStats();
+        for (size_t i = 0; i < stats.size(); i++) {
+            if (stats[i].blockCount == 0) continue;
+            Log::Core::Info("Heap {}: {} allocations in {} blocks, {:.1f}/{:.1f} MiB used, heap size {:.0f} MiB",
+                            i, stats[i].allocationCount, stats[i].blockCount, ToMiB(stats[i].usedBytes),
+                            ToMiB(stats[i].blockBytes), ToMiB(stats[i].heapSize));
+        }
+        Log::Core::Info("{} device memory allocations (limit {})", m_DeviceAllocationCount, m_MaxAllocationCount);
+    }
+
+    MemoryBlock* Allocator::CreateBlock(vk::DeviceSize size, uint32_t memoryType, AllocationKind kind,
+                                        AllocationStrategy strategy) {
+        if (m_DeviceAllocationCount >= m_MaxAllocationCount) {
+            Log::Core::Critical("Exceeded maxMemoryAllocationCount ({})", m_MaxAllocationCount);
+            std::exit(1);
+        }
+
+        auto block = std::make_unique<MemoryBlock>();
+        block->memory = m_Device.allocateMemory(vk::MemoryAllocateInfo(size, memoryType));
+        block->size = size;
+        block->memoryType = memoryType;
+        block->kind = kind;
+        block->strategy = strategy;
+
+        if (strategy == AllocationStrategy::Buddy) {
+            uint32_t maxOrder = BuddyOrder(size);
+            block->freeLists.resize(maxOrder + 1);
+            block->freeLists[maxOrder].insert(0);
+        }
+
+        m_DeviceAllocationCount++;
+        return m_Blocks.emplace_back(std::move(block)).get();
+    }
+
+    void Allocator::DestroyBlock(MemoryBlock* block) {
+        if (block->mapCount != 0) m_Device.unmapMemory(block->memory);
+        m_Device.freeMemory(block->memory);
+        m_DeviceAllocationCount--;
+
+        std::erase_if(m_Blocks, [&](const auto& other) { return other.get() == block; });
+    }
+
+    bool Allocator::HasMemoryType(uint32_t typeBits, vk::MemoryPropertyFlags flags) const {
+        for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++) {
+            if ((typeBits & (1u << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t Allocator::FindMemoryType(uint32_t typeBits, vk::MemoryPropertyFlags flags) const {
+        for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++) {
+            if ((typeBits & (1u << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+                return i;
+            }
+        }
+        Log::Core::Critical("No memory type matches {}", vk::to_string(flags));
+        std::exit(1);
+    }
+
+    vk::DeviceSize Allocator::GetBlockSize(uint32_t memoryType) const {
+        // Small heaps (e.g. host visible device memory) get smaller blocks so a few of them don't exhaust it
+        vk::DeviceSize heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryType].heapIndex].size;
+        vk::DeviceSize size = MaxBlockSize;
+        while (size > MinBlockSize && size > heapSize / 8) size >>= 1;
+        return size;
+    }
+
+    std::optional<vk::DeviceSize> Allocator::BuddyAllocate(MemoryBlock& block, vk::DeviceSize size) {
+        uint32_t order = BuddyOrder(size);
+        if (order >= block.freeLists.size()) return std::nullopt;
+
+        uint32_t current = order;
+        while (current < block.freeLists.size() && block.freeLists[current].empty()) current++;
+        if (current == block.freeLists.size()) return std::nullopt;
+
+        auto offsetIt = block.freeLists[current].begin();
+        vk::DeviceSize offset = *offsetIt;
+        block.freeLists[current].erase(offsetIt);
+
+        // Split down to the requested order, putting the upper halves on the free lists
+        while (current > order) {
+            current--;
+            block.freeLists[current].insert(offset + (MinBuddySize << current));
+        }
+        return offset;
+    }
+
+    void Allocator::BuddyFree(MemoryBlock& block, vk::DeviceSize offset, vk::DeviceSize size) {
+        uint32_t order = BuddyOrder(size);
+        while (order + 1 < block.freeLists.size()) {
+            vk::DeviceSize buddy = offset ^ (MinBuddySize << order);
+            if (block.freeLists[order].erase(buddy) == 0) break;
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        block.freeLists[order].insert(offset);
+    }
+
+    Allocator::~Allocator() {
+        for (const auto& block: m_Blocks) {
+            if (block->allocationCount != 0) {
+                Log::Core::Warn("Freeing memory block with {} live allocations", block->allocationCount);
+            }
+            if (block->mapCount != 0) m_Device.unmapMemory(block->memory);
+            m_Device.freeMemory(block->memory);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+namespace Iris::Vulkan {
+    // Buffers and linear images must not share a block with optimal images, see bufferImageGranularity
+    enum class AllocationKind : uint8_t {
+        Linear,
+        Optimal
+    };
+
+    enum class AllocationStrategy : uint8_t {
+        Buddy,      // general purpose, freed individually
+        Linear,     // bump allocated, for resources that live as long as the renderer
+        Dedicated   // own vk::DeviceMemory, picked automatically for large resources
+    };
+
+    class Allocator;
+    struct MemoryBlock;
+
+    struct Allocation {
+        vk::DeviceMemory memory;
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize size = 0;
+
+        explicit operator bool() const { return static_cast<bool>(memory); }
+
+    private:
+        MemoryBlock* block = nullptr;
+        vk::DeviceSize reserved = 0;    // size taken from the block, including buddy rounding
+        friend Allocator;
+    };
+
+    struct HeapStats {
+        vk::DeviceSize heapSize = 0;
+        vk::DeviceSize blockBytes = 0;  // allocated from the driver
+        vk::DeviceSize usedBytes = 0;   // handed out to resources
+        uint32_t blockCount = 0;
+        uint32_t allocationCount = 0;
+    };
+
+    class Allocator final {
+    public:
+        Allocator(vk::PhysicalDevice physDevice, vk::Device device);
+        ~Allocator();
+
+        Allocation Allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags flags,
+                            AllocationKind kind, AllocationStrategy strategy = AllocationStrategy::Buddy);
+        Allocation AllocateBuffer(vk::Buffer buffer, vk::MemoryPropertyFlags flags,
+                                  AllocationStrategy strategy = AllocationStrategy::Buddy);
+        Allocation AllocateImage(vk::Image image, vk::ImageTiling tiling, vk::MemoryPropertyFlags flags,
+                                 AllocationStrategy strategy = AllocationStrategy::Buddy);
+        void Free(Allocation& allocation);
+
+        // Whether some memory type allowed by typeBits has all of flags, e.g. lazily allocated memory on tilers
+        [[nodiscard]] bool HasMemoryType(uint32_t typeBits, vk::MemoryPropertyFlags flags) const;
+
+        // Mapping is reference counted per block, every Map needs a matching Unmap
+        void* Map(const Allocation& allocation);
+        void Unmap(const Allocation& allocation);
+
+        [[nodiscard]] std::vector<HeapStats> GetHeapStats() const;
+        void LogStats() const;
+    private:
+        MemoryBlock* CreateBlock(vk::DeviceSize size, uint32_t memoryType, AllocationKind kind,
+                           AllocationStrategy strategy);
+        void DestroyBlock(MemoryBlock* block);
+
+        uint32_t FindMemoryType(uint32_t typeBits, vk::MemoryPropertyFlags flags) const;
+        [[nodiscard]] vk::DeviceSize GetBlockSize(uint32_t memoryType) const;
+
+        static std::optional<vk::DeviceSize> BuddyAllocate(MemoryBlock& block, vk::DeviceSize size);
+        static void BuddyFree(MemoryBlock& block, vk::DeviceSize offset, vk::DeviceSize size);
+    private:
+        vk::Device m_Device;
+        vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+        vk::DeviceSize m_BufferImageGranularity;
+        uint32_t m_MaxAllocationCount;
+
+        std::vector<std::unique_ptr<MemoryBlock>> m_Blocks;
+        uint32_t m_DeviceAllocationCount = 0;
+        mutable std::mutex m_Mutex;
+    };
+}
@@ -13,18 +13,19 @@ namespace Iris::Vulkan {
         Buffer(std::shared_ptr<Context> ctx, vk::BufferUsageFlags flags,
                const T& data) : Buffer(ctx, flags, &data) {}
 
+        // Passing more than one distinct queue family shares the buffer concurrently between them
         explicit Buffer(std::shared_ptr<Context> ctx, vk::BufferUsageFlags flags,
-                        size_t count = 1) : m_Ctx(std::move(ctx)), m_Size(count * sizeof(T)) {
-            m_Buffer = m_Ctx->GetDevice().createBuffer(vk::BufferCreateInfo(vk::BufferCreateFlags(), m_Size, flags));
-
-            m_MemoryRequirements = m_Ctx->GetDevice().getBufferMemoryRequirements(m_Buffer);
-            uint32_t typeIndex = findMemoryType(m_Ctx->GetPhysDevice().getMemoryProperties(),
-                                                m_MemoryRequirements.memoryTypeBits,
-                                                vk::MemoryPropertyFlagBits::eHostVisible |
-                                                vk::MemoryPropertyFlagBits::eHostCoherent);
-            m_Memory = m_Ctx->GetDevice().allocateMemory(vk::MemoryAllocateInfo(m_MemoryRequirements.size, typeIndex));
-
-            m_Ctx->GetDevice().bindBufferMemory(m_Buffer, m_Memory, 0);
+                        size_t count = 1, std::vector<uint32_t> queueFamilies = {})
+                : m_Ctx(std::move(ctx)), m_Size(count * sizeof(T)) {
+            vk::BufferCreateInfo createInfo(vk::BufferCreateFlags(), m_Size, flags);
+            std::sort(queueFamilies.begin(), queueFamilies.end());
+            queueFamilies.erase(std::unique(queueFamilies.begin(), queueFamilies.end()), queueFamilies.end());
+            if (queueFamilies.size() > 1) {
+                createInfo.setSharingMode(vk::SharingMode::eConcurrent).setQueueFamilyIndices(queueFamilies);
+            }
+            m_Buffer = m_Ctx->GetDevice().createBuffer(createInfo);
+            m_Allocation = m_Ctx->GetAllocator().AllocateBuffer(m_Buffer, vk::MemoryPropertyFlagBits::eHostVisible |
+                                                                          vk::MemoryPropertyFlagBits::eHostCoherent);
         }
 
         Buffer(std::shared_ptr<Context> ctx, vk::BufferUsageFlags flags,
@@ -39,16 +40,29 @@ namespace Iris::Vulkan {
         }
 
         T* Map() {
-            return static_cast<T*>(m_Ctx->GetDevice().mapMemory(m_Memory, 0, m_MemoryRequirements.size));
+            if (m_Persistent) return m_Persistent;
+            return static_cast<T*>(m_Ctx->GetAllocator().Map(m_Allocation));
         }
 
         void Unmap() {
-            m_Ctx->GetDevice().unmapMemory(m_Memory);
+            if (m_Persistent) return;
+            m_Ctx->GetAllocator().Unmap(m_Allocation);
+        }
+
+        // Keeps the buffer mapped until it is destroyed, Map() and Unmap() become free after this
+        T* MapPersistent() {
+            if (!m_Persistent) m_Persistent = static_cast<T*>(m_Ctx->GetAllocator().Map(m_Allocation));
+            return m_Persistent;
+        }
+
+        [[nodiscard]] size_t GetSize() const {
+            return m_Size;
         }
 
         ~Buffer() {
-            m_Ctx->GetDevice().freeMemory(m_Memory);
+            if (m_Persistent) m_Ctx->GetAllocator().Unmap(m_Allocation);
             m_Ctx->GetDevice().destroyBuffer(m_Buffer);
+            m_Ctx->GetAllocator().Free(m_Allocation);
         }
 
     public:
@@ -56,7 +70,7 @@ namespace Iris::Vulkan {
     private:
         std::shared_ptr<Context> m_Ctx{};
         size_t m_Size{};
-        vk::DeviceMemory m_Memory;
-        vk::MemoryRequirements m_MemoryRequirements;
+        Allocation m_Allocation;
+        T* m_Persistent = nullptr;
     };
 }
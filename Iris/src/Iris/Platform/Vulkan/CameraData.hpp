@@ -7,5 +7,6 @@ namespace Iris::Vulkan {
         glm::mat4 view = glm::mat4(1.f);
         glm::mat4 projection = glm::mat4(1.f);
         glm::mat4 viewProjection = glm::mat4(1.f); // pre-computed once per frame instead of once per vertex
+        glm::mat4 inverseViewProjection = glm::mat4(1.f); // depth to world position for deferred lighting
     };
 }
\ No newline at end of file
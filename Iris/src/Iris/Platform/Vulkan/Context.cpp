@@ -5,16 +5,21 @@
 
 namespace Iris::Vulkan {
     Context::Context(const std::shared_ptr<Window>& window) {
-        CreateInstance();
+        CreateInstance(window == nullptr);
         CreateSurface(window);
         SelectDevice();
         CreateQueues();
+
+        m_Allocator = std::make_unique<Allocator>(m_PhysicalDevice, m_Device);
+        m_SamplerCache = std::make_unique<SamplerCache>(m_Device, m_PhysicalDevice, m_SamplerAnisotropy);
+        m_PipelineCache = std::make_unique<PipelineCache>(m_Device, m_PhysicalDevice, m_PipelineCreationFeedback);
     }
 
-    void Context::CreateInstance() {
+    void Context::CreateInstance(bool headless) {
         vkb::InstanceBuilder instanceBuilder;
 
         auto instance = instanceBuilder
+                .set_headless(headless)
                 .set_app_name("Iris")
                 .set_engine_name("Iris")
                 .set_debug_callback([](VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -62,16 +67,21 @@ namespace Iris::Vulkan {
                     "glfwCreateWindowSurface");
             m_Surface = vk::SurfaceKHR(surface);
         } else {
-            // Headless
+            // Headless, rendering goes to offscreen images and nothing is presented
+            Log::Core::Info("Vulkan context created without a surface (headless)");
         }
     }
 
     void Context::SelectDevice() {
         VkPhysicalDeviceFeatures features{};
         features.independentBlend = true;
+        features.multiDrawIndirect = true;
+        features.drawIndirectFirstInstance = true;
 
         VkPhysicalDeviceVulkan12Features features12{};
         features12.runtimeDescriptorArray = true;
+        features12.timelineSemaphore = true;
+        features12.drawIndirectCount = true;
         features12.descriptorBindingPartiallyBound = true;
 
         features12.shaderUniformBufferArrayNonUniformIndexing = true;
@@ -84,11 +94,12 @@ namespace Iris::Vulkan {
         features12.descriptorBindingSampledImageUpdateAfterBind = true;
         features12.descriptorBindingStorageImageUpdateAfterBind = true;
 
+        // Dedicated transfer/compute queues are used when present, but not required: software
+        // implementations such as lavapipe only expose a single queue family
         vkb::PhysicalDeviceSelector selector{ m_VKBInstance };
+        if (m_Surface) selector.set_surface(m_Surface);
         auto phys = selector
-                .set_surface(m_Surface)
                 .set_minimum_version(1, 2)
-                .require_dedicated_transfer_queue()
                 .set_required_features_12(features12)
                 .set_required_features(features)
                 .select();
@@ -97,8 +108,23 @@ namespace Iris::Vulkan {
             std::exit(1);
         }
         m_PhysicalDevice = vk::PhysicalDevice(phys.value());
-
-        vkb::DeviceBuilder device_builder{ phys.value() };
+        Log::Core::Info("Using Vulkan device {}", phys.value().name);
+
+        // BC textures and anisotropic filtering are optional, images stay uncompressed and samplers isotropic
+        // on devices without them
+        auto physical = phys.value();
+        auto available = m_PhysicalDevice.getFeatures();
+        m_BlockCompression = available.textureCompressionBC;
+        m_SamplerAnisotropy = available.samplerAnisotropy;
+        physical.features.textureCompressionBC = m_BlockCompression;
+        physical.features.samplerAnisotropy = m_SamplerAnisotropy;
+        if (!m_BlockCompression) Log::Core::Warn("Device can't sample BC textures, textures stay uncompressed");
+
+        // Only used to tell pipeline cache hits from misses
+        m_PipelineCreationFeedback = physical.enable_extension_if_present(
+                VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+
+        vkb::DeviceBuilder device_builder{ physical };
         auto dev = device_builder.build();
         if (!dev) {
             Log::Core::Critical("Failed to select Vulkan Device. Error: {}\n", dev.error().message());
@@ -118,32 +144,41 @@ namespace Iris::Vulkan {
         m_GraphicsQueue = gq.value();
         m_GraphicsQueueFamilyIndex = gqi.value();
 
-        auto pq = m_VKBDevice.get_queue(vkb::QueueType::present);
-        auto pqi = m_VKBDevice.get_queue_index(vkb::QueueType::present);
-        if (!pq.has_value() || !pqi.has_value()) {
-            Log::Core::Error("failed to get present queue: {}", pq.error().message());
-            exit(1);
+        // Everything else falls back to the graphics queue when the device has no separate family for it
+        m_PresentQueue = m_GraphicsQueue;
+        m_PresentQueueFamilyIndex = m_GraphicsQueueFamilyIndex;
+        if (m_Surface) {
+            auto pq = m_VKBDevice.get_queue(vkb::QueueType::present);
+            auto pqi = m_VKBDevice.get_queue_index(vkb::QueueType::present);
+            if (!pq.has_value() || !pqi.has_value()) {
+                Log::Core::Error("failed to get present queue: {}", pq.error().message());
+                exit(1);
+            }
+            m_PresentQueue = pq.value();
+            m_PresentQueueFamilyIndex = pqi.value();
         }
-        m_PresentQueue = pq.value();
-        m_PresentQueueFamilyIndex = pqi.value();
 
         auto cq = m_VKBDevice.get_queue(vkb::QueueType::compute);
         auto cqi = m_VKBDevice.get_queue_index(vkb::QueueType::compute);
-        if (!cq.has_value() || !cqi.has_value()) {
-            Log::Core::Error("failed to get compute queue: {}", cq.error().message());
-            exit(1);
+        if (cq.has_value() && cqi.has_value()) {
+            m_ComputeQueue = cq.value();
+            m_ComputeQueueFamilyIndex = cqi.value();
+        } else {
+            Log::Core::Warn("No separate compute queue, using the graphics queue");
+            m_ComputeQueue = m_GraphicsQueue;
+            m_ComputeQueueFamilyIndex = m_GraphicsQueueFamilyIndex;
         }
-        m_ComputeQueue = cq.value();
-        m_ComputeQueueFamilyIndex = cqi.value();
 
         auto tq = m_VKBDevice.get_queue(vkb::QueueType::transfer);
         auto tqi = m_VKBDevice.get_queue_index(vkb::QueueType::transfer);
-        if (!tq.has_value() || !tqi.has_value()) {
-            Log::Core::Error("failed to get transfer queue: {}", tq.error().message());
-            exit(1);
+        if (tq.has_value() && tqi.has_value()) {
+            m_TransferQueue = tq.value();
+            m_TransferQueueFamilyIndex = tqi.value();
+        } else {
+            Log::Core::Warn("No separate transfer queue, using the graphics queue");
+            m_TransferQueue = m_GraphicsQueue;
+            m_TransferQueueFamilyIndex = m_GraphicsQueueFamilyIndex;
         }
-        m_TransferQueue = tq.value();
-        m_TransferQueueFamilyIndex = tqi.value();
     }
 
     vk::Instance Context::GetInstance() const {
@@ -195,6 +230,10 @@ namespace Iris::Vulkan {
     }
 
     Context::~Context() {
+        m_Allocator->LogStats();
+        m_SamplerCache.reset();
+        m_PipelineCache.reset();
+        m_Allocator.reset();
         vkb::destroy_device(m_VKBDevice);
         vkb::destroy_surface(m_VKBInstance, m_Surface);
         vkb::destroy_instance(m_VKBInstance);
@@ -2,6 +2,9 @@
 #include <VkBootstrap.h>
 #include <vulkan/vulkan.hpp>
 #include "Iris/Core/Window.hpp"
+#include "Iris/Platform/Vulkan/Allocator.hpp"
+#include "Iris/Platform/Vulkan/SamplerCache.hpp"
+#include "Iris/Platform/Vulkan/PipelineCache.hpp"
 
 namespace Iris::Vulkan {
     class Context final {
@@ -13,6 +16,11 @@ namespace Iris::Vulkan {
         [[nodiscard]] vk::SurfaceKHR GetSurface() const;
         [[nodiscard]] vk::PhysicalDevice GetPhysDevice() const;
         [[nodiscard]] vk::Device GetDevice() const;
+        [[nodiscard]] bool IsHeadless() const { return !m_Surface; };
+        [[nodiscard]] Allocator& GetAllocator() const { return *m_Allocator; };
+        [[nodiscard]] SamplerCache& GetSamplerCache() const { return *m_SamplerCache; };
+        [[nodiscard]] PipelineCache& GetPipelineCache() const { return *m_PipelineCache; };
+        [[nodiscard]] bool SupportsBlockCompression() const { return m_BlockCompression; }
 
         [[nodiscard]] uint32_t GetGraphicsQueueFamilyIndex() const;
         [[nodiscard]] uint32_t GetComputeQueueFamilyIndex() const;
@@ -23,7 +31,7 @@ namespace Iris::Vulkan {
         [[nodiscard]] const vk::Queue& GetPresentQueue() const;
         [[nodiscard]] const vk::Queue& GetTransferQueue() const;
     private:
-        void CreateInstance();
+        void CreateInstance(bool headless);
         void CreateSurface(const std::shared_ptr<Window>& window);
         void SelectDevice();
         void CreateQueues();
@@ -36,6 +44,12 @@ namespace Iris::Vulkan {
         vk::SurfaceKHR m_Surface;
         vk::PhysicalDevice m_PhysicalDevice;
         vk::Device m_Device;
+        std::unique_ptr<Allocator> m_Allocator;
+        std::unique_ptr<SamplerCache> m_SamplerCache;
+        std::unique_ptr<PipelineCache> m_PipelineCache;
+        bool m_BlockCompression = false;
+        bool m_SamplerAnisotropy = false;
+        bool m_PipelineCreationFeedback = false;
 
         uint32_t m_GraphicsQueueFamilyIndex = 0;
         uint32_t m_ComputeQueueFamilyIndex = 0;
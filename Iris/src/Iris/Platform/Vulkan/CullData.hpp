@@ -0,0 +1,17 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace Iris::Vulkan {
+    // Inputs of the culling compute pass. Matches CullData in common.glsl
+    struct CullData {
+        glm::mat4 viewProjection = glm::mat4(1.f);
+        glm::mat4 prevViewProjection = glm::mat4(1.f);
+        glm::vec4 frustum[6]{};
+        glm::vec2 hizSize{ 0.f };
+        uint32_t instanceCount = 0;
+        uint32_t drawCount = 0;
+        uint32_t occlusion = 0;
+        uint32_t pad[3]{};
+        glm::uvec4 bucketEnds{ 0 };     // draws are sorted by material bucket, end of every bucket's range
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include "Iris/Platform/Vulkan/Allocator.hpp"
+#include "Iris/Platform/Vulkan/Buffer.hpp"
+#include "Iris/Platform/Vulkan/InstanceData.hpp"
+
+namespace Iris::Vulkan {
+    // Per-frame command recording, sync and readback state, one copy per frame in flight
+    struct FrameData {
+        vk::CommandPool commandPool;
+        vk::CommandBuffer commandBuffer;
+
+        // Culling runs on the compute queue, the graphics submission of the same frame waits on it
+        vk::CommandPool computeCommandPool;
+        vk::CommandBuffer computeCommandBuffer;
+
+        vk::Fence renderFence;
+        vk::Semaphore renderSemaphore;
+        vk::Semaphore presentSemaphore;
+
+        // Persistently mapped, grown when a frame has more instances than fit
+        std::unique_ptr<Buffer<InstanceData>> instanceBuffer;
+        InstanceData* instanceData = nullptr;
+        std::unique_ptr<Buffer<vk::DrawIndexedIndirectCommand>> indirectBuffer;
+        vk::DrawIndexedIndirectCommand* indirectCommands = nullptr;
+
+        // GPU culling: bounding sphere per draw, surviving instance indices and the compacted draws. All of them
+        // are shared between the graphics and compute queues.
+        std::unique_ptr<Buffer<glm::vec4>> drawBoundsBuffer;
+        glm::vec4* drawBounds = nullptr;
+        std::unique_ptr<Buffer<uint32_t>> visibleBuffer;
+        uint32_t* visibleInstances = nullptr;
+        std::unique_ptr<Buffer<vk::DrawIndexedIndirectCommand>> compactedBuffer;
+        vk::DrawIndexedIndirectCommand* compactedCommands = nullptr;
+        std::unique_ptr<Buffer<uint32_t>> visibleDrawCountBuffer;
+        uint32_t* visibleDrawCount = nullptr;
+
+        // Light indices per cluster, written by this frame's light culling and read by its shading
+        std::unique_ptr<Buffer<uint32_t>> clusterBuffer;
+
+        // Max depth pyramid of this frame's depth buffer, built at the end of its graphics submission. The next
+        // frame to use this slot culls against it, so culling never waits on the frame rendering right before it.
+        vk::Image hizImage;
+        Allocation hizMemory;
+        vk::ImageView hizView;
+        std::vector<vk::ImageView> hizLevelViews;
+        glm::mat4 hizViewProjection{ 1.f };     // of the frame the pyramid was built from
+
+        // Headless only: the finished frame is copied here and stays mapped for the renderer's lifetime
+        std::unique_ptr<Buffer<uint8_t>> readbackBuffer;
+        uint8_t* readbackData = nullptr;
+        std::optional<uint64_t> readbackFrame;
+    };
+}
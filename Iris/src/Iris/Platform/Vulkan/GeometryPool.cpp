@@ -0,0 +1,162 @@
+#include "GeometryPool.hpp"
+#include "Iris/Platform/Vulkan/Buffer.hpp"
+
+namespace Iris::Vulkan {
+    static constexpr vk::BufferUsageFlags VertexUsage = vk::BufferUsageFlagBits::eVertexBuffer;
+    static constexpr vk::BufferUsageFlags IndexUsage = vk::BufferUsageFlagBits::eIndexBuffer;
+
+    GeometryPool::GeometryPool(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx,
+                               uint32_t vertexCapacity, uint32_t indexCapacity)
+            : m_Ctx(std::move(ctx)), m_UCtx(std::move(uctx)),
+              m_VertexAllocator(vertexCapacity), m_IndexAllocator(indexCapacity) {
+        m_Vertices = CreateBuffer(vertexCapacity * sizeof(Vertex), VertexUsage);
+        m_Positions = CreateBuffer(vertexCapacity * sizeof(glm::vec3), VertexUsage);
+        m_Indices = CreateBuffer(indexCapacity * sizeof(uint32_t), IndexUsage);
+    }
+
+    GeometryRange GeometryPool::Allocate(std::span<const Vertex> vertices, std::span<const uint32_t> indices) {
+        GeometryRange range{
+                .vertexCount = static_cast<uint32_t>(vertices.size()),
+                .indexCount = static_cast<uint32_t>(indices.size())
+        };
+        if (vertices.empty() || indices.empty()) return {};
+
+        auto vertexOffset = m_VertexAllocator.Allocate(range.vertexCount);
+        if (!vertexOffset) {
+            uint32_t capacity = m_VertexAllocator.GetCapacity();
+            uint32_t newCapacity = std::max(capacity * 2, capacity + range.vertexCount);
+            Grow(m_Vertices, capacity, newCapacity, sizeof(Vertex), VertexUsage);
+            Grow(m_Positions, capacity, newCapacity, sizeof(glm::vec3), VertexUsage);
+            m_VertexAllocator.Grow(newCapacity);
+            vertexOffset = m_VertexAllocator.Allocate(range.vertexCount);
+        }
+        auto firstIndex = m_IndexAllocator.Allocate(range.indexCount);
+        if (!firstIndex) {
+            uint32_t capacity = m_IndexAllocator.GetCapacity();
+            uint32_t newCapacity = std::max(capacity * 2, capacity + range.indexCount);
+            Grow(m_Indices, capacity, newCapacity, sizeof(uint32_t), IndexUsage);
+            m_IndexAllocator.Grow(newCapacity);
+            firstIndex = m_IndexAllocator.Allocate(range.indexCount);
+        }
+        range.vertexOffset = *vertexOffset;
+        range.firstIndex = *firstIndex;
+
+        Upload(m_Vertices, range.vertexOffset * sizeof(Vertex), vertices.data(), vertices.size() * sizeof(Vertex));
+        std::vector<glm::vec3> positions(vertices.size());
+        std::transform(vertices.begin(), vertices.end(), positions.begin(),
+                       [](const Vertex& vertex) { return glm::vec3(vertex.position); });
+        Upload(m_Positions, range.vertexOffset * sizeof(glm::vec3), positions.data(),
+               positions.size() * sizeof(glm::vec3));
+        Upload(m_Indices, range.firstIndex * sizeof(uint32_t), indices.data(), indices.size() * sizeof(uint32_t));
+        return range;
+    }
+
+    void GeometryPool::Free(const GeometryRange& range) {
+        if (range.vertexCount == 0) return;
+        m_VertexAllocator.Free(range.vertexOffset, range.vertexCount);
+        m_IndexAllocator.Free(range.firstIndex, range.indexCount);
+    }
+
+    void GeometryPool::Bind(vk::CommandBuffer& cmdBuf) const {
+        cmdBuf.bindVertexBuffers(0, m_Vertices.buffer, { 0 });
+        cmdBuf.bindIndexBuffer(m_Indices.buffer, 0, vk::IndexType::eUint32);
+    }
+
+    void GeometryPool::BindPositions(vk::CommandBuffer& cmdBuf) const {
+        cmdBuf.bindVertexBuffers(0, m_Positions.buffer, { 0 });
+        cmdBuf.bindIndexBuffer(m_Indices.buffer, 0, vk::IndexType::eUint32);
+    }
+
+    GeometryPool::PoolBuffer GeometryPool::CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage) {
+        // Concurrent sharing avoids ownership transfers of the whole pool for every upload
+        std::vector<uint32_t> families{ m_Ctx->GetGraphicsQueueFamilyIndex(), m_Ctx->GetTransferQueueFamilyIndex() };
+        families.erase(std::unique(families.begin(), families.end()), families.end());
+
+        vk::BufferCreateInfo createInfo(vk::BufferCreateFlags(), size,
+                                        usage | vk::BufferUsageFlagBits::eTransferDst |
+                                        vk::BufferUsageFlagBits::eTransferSrc);
+        if (families.size() > 1) {
+            createInfo.setSharingMode(vk::SharingMode::eConcurrent).setQueueFamilyIndices(families);
+        }
+
+        PoolBuffer out;
+        out.buffer = m_Ctx->GetDevice().createBuffer(createInfo);
+        out.allocation = m_Ctx->GetAllocator().AllocateBuffer(out.buffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        return out;
+    }
+
+    void GeometryPool::DestroyBuffer(PoolBuffer& buffer) {
+        m_Ctx->GetDevice().destroyBuffer(buffer.buffer);
+        m_Ctx->GetAllocator().Free(buffer.allocation);
+    }
+
+    void GeometryPool::Grow(PoolBuffer& buffer, uint32_t capacity, uint32_t newCapacity, vk::DeviceSize stride,
+                            vk::BufferUsageFlags usage) {
+        Log::Core::Warn("Growing geometry pool buffer from {} to {} elements", capacity, newCapacity);
+
+        // Rare, so simply let every frame and upload touching the old buffer finish
+        m_UCtx->Wait(m_UCtx->Flush());
+        m_Ctx->GetDevice().waitIdle();
+
+        PoolBuffer grown = CreateBuffer(newCapacity * stride, usage);
+        m_UCtx->SubmitCommand([&](vk::CommandBuffer& cmdBuf) {
+            cmdBuf.copyBuffer(buffer.buffer, grown.buffer, vk::BufferCopy(0, 0, capacity * stride));
+        });
+        DestroyBuffer(buffer);
+        buffer = grown;
+    }
+
+    void GeometryPool::Upload(const PoolBuffer& buffer, vk::DeviceSize offset, const void* data,
+                              vk::DeviceSize size) {
+        auto staging = std::make_shared<Buffer<uint8_t>>(m_Ctx, vk::BufferUsageFlagBits::eTransferSrc,
+                                                         static_cast<size_t>(size));
+        memcpy(staging->Map(), data, size);
+        staging->Unmap();
+
+        m_UCtx->Enqueue([&](vk::CommandBuffer& cmdBuf) {
+            cmdBuf.copyBuffer(staging->m_Buffer, buffer.buffer, vk::BufferCopy(0, offset, size));
+        });
+        m_UCtx->KeepAlive(std::move(staging));
+    }
+
+    GeometryPool::~GeometryPool() {
+        DestroyBuffer(m_Vertices);
+        DestroyBuffer(m_Positions);
+        DestroyBuffer(m_Indices);
+    }
+
+    std::optional<uint32_t> GeometryPool::RangeAllocator::Allocate(uint32_t count) {
+        for (auto it = m_Free.begin(); it != m_Free.end(); ++it) {
+            if (it->second < count) continue;
+
+            auto [offset, size] = *it;
+            m_Free.erase(it);
+            if (size > count) m_Free[offset + count] = size - count;
+            return offset;
+        }
+        return std::nullopt;
+    }
+
+    void GeometryPool::RangeAllocator::Free(uint32_t offset, uint32_t count) {
+        auto it = m_Free.emplace(offset, count).first;
+
+        auto next = std::next(it);
+        if (next != m_Free.end() && it->first + it->second == next->first) {
+            it->second += next->second;
+            m_Free.erase(next);
+        }
+        if (it != m_Free.begin()) {
+            auto prev = std::prev(it);
+            if (prev->first + prev->second == it->first) {
+                prev->second += it->second;
+                m_Free.erase(it);
+            }
+        }
+    }
+
+    void GeometryPool::RangeAllocator::Grow(uint32_t capacity) {
+        uint32_t added = capacity - m_Capacity;
+        Free(m_Capacity, added);
+        m_Capacity = capacity;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include "Iris/Renderer/Vertex.hpp"
+#include "Iris/Platform/Vulkan/Context.hpp"
+#include "Iris/Platform/Vulkan/UploadContext.hpp"
+
+namespace Iris::Vulkan {
+    // Region of the pool's buffers owned by one mesh, in vertices and indices
+    struct GeometryRange {
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+    };
+
+    // One device local vertex buffer and one index buffer that all meshes sub-allocate from, so the whole scene
+    // is drawn with a single vertex/index buffer binding. Both buffers are shared concurrently between the
+    // transfer and graphics queues, uploads go through the UploadContext. A second vertex buffer holds only the
+    // positions, at the same offsets, for passes that need nothing else.
+    class GeometryPool final {
+    public:
+        GeometryPool(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx,
+                     uint32_t vertexCapacity = 1 << 20, uint32_t indexCapacity = 1 << 22);
+
+        GeometryRange Allocate(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+        // The caller makes sure no frame in flight still draws the range
+        void Free(const GeometryRange& range);
+
+        void Bind(vk::CommandBuffer& cmdBuf) const;
+        // Binds the tightly packed vec3 positions as vertex buffer 0 instead
+        void BindPositions(vk::CommandBuffer& cmdBuf) const;
+
+        ~GeometryPool();
+    private:
+        // First fit over a sorted free list, neighbours are merged on free
+        class RangeAllocator {
+        public:
+            explicit RangeAllocator(uint32_t capacity) : m_Capacity(capacity) { m_Free[0] = capacity; }
+
+            std::optional<uint32_t> Allocate(uint32_t count);
+            void Free(uint32_t offset, uint32_t count);
+            void Grow(uint32_t capacity);
+            [[nodiscard]] uint32_t GetCapacity() const { return m_Capacity; }
+        private:
+            uint32_t m_Capacity;
+            std::map<uint32_t, uint32_t> m_Free; // offset -> count
+        };
+
+        struct PoolBuffer {
+            vk::Buffer buffer;
+            Allocation allocation;
+        };
+
+        PoolBuffer CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage);
+        void DestroyBuffer(PoolBuffer& buffer);
+        // Only the buffer, the allocator is grown once all of its buffers are
+        void Grow(PoolBuffer& buffer, uint32_t capacity, uint32_t newCapacity, vk::DeviceSize stride,
+                  vk::BufferUsageFlags usage);
+        void Upload(const PoolBuffer& buffer, vk::DeviceSize offset, const void* data, vk::DeviceSize size);
+    private:
+        std::shared_ptr<Context> m_Ctx;
+        std::shared_ptr<UploadContext> m_UCtx;
+
+        PoolBuffer m_Vertices;
+        PoolBuffer m_Positions;
+        PoolBuffer m_Indices;
+        RangeAllocator m_VertexAllocator;
+        RangeAllocator m_IndexAllocator;
+    };
+}
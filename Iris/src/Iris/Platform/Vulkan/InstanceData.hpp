@@ -0,0 +1,14 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace Iris::Vulkan {
+    // Per-instance data, read in the vertex shader with gl_InstanceIndex. Matches InstanceData in common.glsl
+    struct InstanceData {
+        glm::mat4 modelMat;
+        glm::mat3x4 normalMat;  // mat3 in std430, columns padded to vec4
+        uint32_t objectID;
+        uint32_t textureID;
+        uint32_t drawID;    // indirect command the instance is culled into
+        uint32_t pad;
+    };
+}
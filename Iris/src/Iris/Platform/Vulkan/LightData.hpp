@@ -2,15 +2,28 @@
 #include <glm/glm.hpp>
 
 namespace Iris::Vulkan {
+    // Froxel grid of the clustered lighting, matches ClusterGrid and MaxClusterLights in common.glsl
+    inline constexpr uint32_t ClusterGridX = 16;    // screen tiles
+    inline constexpr uint32_t ClusterGridY = 9;
+    inline constexpr uint32_t ClusterGridZ = 24;    // depth slices
+    inline constexpr uint32_t ClusterCount = ClusterGridX * ClusterGridY * ClusterGridZ;
+    inline constexpr uint32_t MaxClusterLights = 127;
+    inline constexpr uint32_t ClusterStride = MaxClusterLights + 1;    // light count, then the light indices
+
     struct Light {
-        glm::vec4 position;
+        glm::vec4 position;     // w: range of point and spot lights
         glm::vec4 rotation;
         glm::vec4 color;
         glm::uvec4 flags;
     };
 
+    // Matches LightData in common.glsl
     struct LightData {
-        uint32_t lightCount;
-        char pad[12];
+        uint32_t lightCount;        // directional lights come first, the rest are clustered
+        uint32_t directionalCount;
+        float zNear;
+        float zFar;
+        glm::vec2 screenSize;
+        glm::vec2 projectionScale;  // projection[0][0] and [1][1]
     };
-}
\ No newline at end of file
+}
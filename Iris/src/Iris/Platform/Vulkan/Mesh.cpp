@@ -1,25 +1,24 @@
 #include "Mesh.hpp"
 
 namespace Iris::Vulkan {
-    Mesh::Mesh(const std::shared_ptr<Context>& ctx, size_t parentID,
-               const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
-            : m_ParentID(parentID), m_VertexCount(vertices.size()), m_IndexCount(indices.size()) {
-        m_VertexBuffer = std::make_unique<Buffer<Vertex>>(ctx, vk::BufferUsageFlagBits::eVertexBuffer, vertices);
-        m_IndexBuffer = std::make_unique<Buffer<uint32_t>>(ctx, vk::BufferUsageFlagBits::eIndexBuffer, indices);
-    }
+    Mesh::Mesh(GeometryPool& pool, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+               const Bounds& bounds)
+            : m_Pool(&pool), m_Range(pool.Allocate(vertices, indices)), m_Bounds(bounds) {}
 
-    Mesh::Mesh(Mesh&& other) noexcept: m_VertexCount(other.m_VertexCount), m_IndexCount(other.m_IndexCount),
-                                       m_ParentID(other.m_ParentID), m_VertexBuffer(std::move(other.m_VertexBuffer)),
-                                       m_IndexBuffer(std::move(other.m_IndexBuffer)) {}
+    Mesh::Mesh(Mesh&& other) noexcept: m_Pool(other.m_Pool), m_Range(other.m_Range), m_Bounds(other.m_Bounds) {
+        other.m_Pool = nullptr;
+    }
 
-    size_t Mesh::GetParentID() const {
-        return m_ParentID;
+    vk::DrawIndexedIndirectCommand Mesh::GetDrawCommand(uint32_t instanceCount, uint32_t firstInstance) const {
+        return { m_Range.indexCount, instanceCount, m_Range.firstIndex, static_cast<int32_t>(m_Range.vertexOffset),
+                 firstInstance };
     }
 
-    void Mesh::Draw(vk::CommandBuffer& cmdBuf) const {
-        cmdBuf.bindVertexBuffers(0, m_VertexBuffer->m_Buffer, { 0 });
-        cmdBuf.bindIndexBuffer(m_IndexBuffer->m_Buffer, 0, vk::IndexType::eUint32);
+    const Bounds& Mesh::GetBounds() const {
+        return m_Bounds;
+    }
 
-        cmdBuf.drawIndexed(m_IndexCount, 1, 0, 0, 1);
+    Mesh::~Mesh() {
+        if (m_Pool) m_Pool->Free(m_Range);
     }
 }
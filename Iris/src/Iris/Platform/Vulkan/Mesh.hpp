@@ -1,23 +1,25 @@
 #pragma once
 #include "Iris/Renderer/Vertex.hpp"
-#include "Iris/Platform/Vulkan/Context.hpp"
-#include "Iris/Platform/Vulkan/Buffer.hpp"
+#include "Iris/Renderer/Bounds.hpp"
+#include "Iris/Platform/Vulkan/GeometryPool.hpp"
 
 namespace Iris::Vulkan {
     class Mesh final {
     public:
-        Mesh(const std::shared_ptr<Context>& ctx, size_t parentID,
-             const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+        Mesh(GeometryPool& pool, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+             const Bounds& bounds);
 
         Mesh(Mesh&& other) noexcept;
 
-        [[nodiscard]] size_t GetParentID() const;
-        void Draw(vk::CommandBuffer& cmdBuf) const;
+        // Geometry is shared between entities, instance data comes from the instance buffer
+        [[nodiscard]] vk::DrawIndexedIndirectCommand GetDrawCommand(uint32_t instanceCount,
+                                                                    uint32_t firstInstance) const;
+        [[nodiscard]] const Bounds& GetBounds() const;
+
+        ~Mesh();
     private:
-        size_t m_ParentID;
-        size_t m_VertexCount;
-        size_t m_IndexCount;
-        std::unique_ptr<Buffer<Vertex>> m_VertexBuffer;
-        std::unique_ptr<Buffer<uint32_t>> m_IndexBuffer;
+        GeometryPool* m_Pool;
+        GeometryRange m_Range;
+        Bounds m_Bounds;
     };
 }
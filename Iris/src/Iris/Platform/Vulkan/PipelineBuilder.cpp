@@ -1,26 +1,32 @@
 #include "PipelineBuilder.hpp"
+#include "Iris/Platform/Vulkan/Util.hpp"
 
 namespace Iris::Vulkan {
-    PipelineBuilder::PipelineBuilder(const vk::Device& mDevice) : m_Device(mDevice) {
-        std::vector<vk::DescriptorPoolSize> poolSizes = {
-                { vk::DescriptorType::eSampler,              65536 },
-                { vk::DescriptorType::eCombinedImageSampler, 65536 },
-                { vk::DescriptorType::eSampledImage,         65536 },
-                { vk::DescriptorType::eStorageImage,         65536 },
-                { vk::DescriptorType::eUniformTexelBuffer,   65536 },
-                { vk::DescriptorType::eStorageTexelBuffer,   65536 },
-                { vk::DescriptorType::eUniformBuffer,        65536 },
-                { vk::DescriptorType::eStorageBuffer,        65536 },
-                { vk::DescriptorType::eUniformBufferDynamic, 65536 },
-                { vk::DescriptorType::eStorageBufferDynamic, 65536 },
-                { vk::DescriptorType::eInputAttachment,      65536 },
-        };
-
-        m_DescriptorPool = m_Device.createDescriptorPool(
-                vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet |
-                                             vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, 128, poolSizes));
+    // Descriptors per type and sets of every pool, larger allocations get a pool of their own size
+    static constexpr uint32_t PoolDescriptors = 4096;
+    static constexpr uint32_t PoolSets = 256;
+
+    // Creates the pipeline through the shared cache, timed and with creation feedback chained in when available
+    template <typename CreateInfo, typename F>
+    static vk::ResultValue<vk::Pipeline> CreateCached(PipelineCache& cache, std::string_view name,
+                                                      CreateInfo& createInfo, F&& create) {
+        vk::PipelineCreationFeedbackEXT feedback;
+        vk::PipelineCreationFeedbackCreateInfoEXT feedbackInfo(&feedback, 0, nullptr);
+        if (cache.HasCreationFeedback()) createInfo.setPNext(&feedbackInfo);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        vk::ResultValue<vk::Pipeline> result = create(cache.Get(), createInfo);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start)
+                .count();
+
+        createInfo.setPNext(nullptr);
+        cache.Record(name, feedback, ms);
+        return result;
     }
 
+    PipelineBuilder::PipelineBuilder(const vk::Device& mDevice, PipelineCache& cache)
+            : m_Device(mDevice), m_Cache(cache) {}
+
     PipelineBuilder& PipelineBuilder::SetVertexInputAttributes(const vk::VertexInputBindingDescription&& description,
                                                                const std::vector<vk::VertexInputAttributeDescription>&& attributes) {
         m_AttributeDescriptions = attributes;
@@ -31,90 +37,85 @@ namespace Iris::Vulkan {
 
     PipelineBuilder& PipelineBuilder::AddVertexShader(std::string path) {
         auto&& shader = loadShaderModule(std::move(path));
-        if (shader) m_VertexShaders.emplace_back(*shader);
+        if (shader) m_VertexShaders.emplace_back(std::move(*shader));
         return *this;
     }
 
     PipelineBuilder& PipelineBuilder::AddFragmentShader(std::string path) {
         auto&& shader = loadShaderModule(std::move(path));
-        if (shader) m_FragmentShaders.emplace_back(*shader);
+        if (shader) m_FragmentShaders.emplace_back(std::move(*shader));
         return *this;
     }
 
-    PipelineBuilder&
-    PipelineBuilder::AddUniform(uint32_t set, uint32_t binding, vk::ShaderStageFlags stage, uint32_t count) {
-        m_DescriptorSetLayoutBindings[set][binding] = vk::DescriptorSetLayoutBinding(
-                binding, vk::DescriptorType::eUniformBuffer, count, stage);
-
+    PipelineBuilder& PipelineBuilder::AddComputeShader(std::string path) {
+        if (m_ComputeShader) m_Device.destroyShaderModule(m_ComputeShader->module);
+        m_Name.clear();
+        m_ComputeShader = loadShaderModule(std::move(path));
         return *this;
     }
 
-    PipelineBuilder&
-    PipelineBuilder::AddStorageBuffer(uint32_t set, uint32_t binding, vk::ShaderStageFlags stage, uint32_t count) {
-        m_DescriptorSetLayoutBindings[set][binding] = vk::DescriptorSetLayoutBinding(
-                binding, vk::DescriptorType::eStorageBuffer, count, stage);
-
+    PipelineBuilder& PipelineBuilder::SetDynamic(uint32_t set, uint32_t binding) {
+        m_DynamicBindings.emplace(set, binding);
         return *this;
     }
 
-    PipelineBuilder&
-    PipelineBuilder::AddImage(uint32_t set, uint32_t binding, vk::ShaderStageFlags stage, uint32_t count) {
-        m_DescriptorSetLayoutBindings[set][binding] = vk::DescriptorSetLayoutBinding(
-                binding, vk::DescriptorType::eCombinedImageSampler, count, stage);
-
+    PipelineBuilder& PipelineBuilder::SetArraySize(uint32_t set, uint32_t binding, uint32_t count) {
+        m_ArraySizes[{ set, binding }] = count;
         return *this;
     }
 
-    PipelineBuilder& PipelineBuilder::AddPushConstant(vk::ShaderStageFlags stage, size_t size) {
-        m_PushConstants.emplace_back(stage, m_PushConstantOffset, size);
-        m_PushConstantOffset += size;
+    PipelineBuilder& PipelineBuilder::ShareDescriptorSets(const Pipeline& pipeline) {
+        m_SharedPipeline = &pipeline;
         return *this;
     }
 
-    std::unique_ptr<PipelineBuilder::Pipeline> PipelineBuilder::Build(vk::RenderPass& renderPass) {
-        auto out = std::unique_ptr<Pipeline>(new Pipeline(m_Device, m_DescriptorPool, m_DescriptorSetLayoutBindings));
+    PipelineBuilder& PipelineBuilder::SetSpecialization(uint32_t constantId, uint32_t value) {
+        m_Specialization[constantId] = value;
+        return *this;
+    }
 
-        for (auto [set, bindings]: m_DescriptorSetLayoutBindings) {
-            std::vector<vk::DescriptorSetLayoutBinding> temp;
-            vk::DescriptorSetLayoutBindingFlagsCreateInfo setLayoutBindingsFlags = {};
-            std::vector<vk::DescriptorBindingFlags> bindingFlags{};
+    PipelineBuilder& PipelineBuilder::SetSubpass(uint32_t subpass) {
+        m_Subpass = subpass;
+        return *this;
+    }
 
-            for (auto [binding, layout]: bindings) {
-                if (layout.descriptorType == vk::DescriptorType::eUniformBuffer) {
-                    bindingFlags.emplace_back(vk::DescriptorBindingFlagBits::ePartiallyBound);
-                } else {
-                    bindingFlags.emplace_back(vk::DescriptorBindingFlagBits::ePartiallyBound |
-                                              vk::DescriptorBindingFlagBits::eUpdateAfterBind);
-                }
-                temp.emplace_back(layout);
-            }
-            setLayoutBindingsFlags.setBindingFlags(bindingFlags);
+    PipelineBuilder& PipelineBuilder::SetColorOutputs(std::vector<ColorOutput> outputs) {
+        m_ColorOutputs = std::move(outputs);
+        return *this;
+    }
 
-            out->descriptorSetLayouts.emplace_back(m_Device.createDescriptorSetLayout(
-                    vk::DescriptorSetLayoutCreateInfo(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
-                                                      temp).setPNext(&setLayoutBindingsFlags)));
-        }
+    PipelineBuilder& PipelineBuilder::SetDepth(bool test, bool write, vk::CompareOp compare) {
+        m_DepthTest = test;
+        m_DepthWrite = write;
+        m_DepthCompare = compare;
+        return *this;
+    }
 
-        out->pipelineLayout = m_Device.createPipelineLayout(vk::PipelineLayoutCreateInfo(
-                vk::PipelineLayoutCreateFlags(), out->descriptorSetLayouts, m_PushConstants));
+    std::unique_ptr<PipelineBuilder::Pipeline> PipelineBuilder::Build(vk::RenderPass& renderPass, uint32_t copies) {
+        auto out = CreateLayout(copies);
 
         {
+            std::vector<vk::SpecializationMapEntry> specializationEntries;
+            std::vector<uint32_t> specializationData;
+            auto specializationInfo = GetSpecializationInfo(specializationEntries, specializationData);
+
             std::vector<vk::PipelineShaderStageCreateInfo> pipelineShaderStageCreateInfos;
             for (auto& shader: m_VertexShaders) {
                 pipelineShaderStageCreateInfos.emplace_back(
                         vk::PipelineShaderStageCreateFlags(),
-                        vk::ShaderStageFlagBits::eVertex, shader, "main");
+                        vk::ShaderStageFlagBits::eVertex, shader.module, "main", &specializationInfo);
             }
             for (auto& shader: m_FragmentShaders) {
                 pipelineShaderStageCreateInfos.emplace_back(
                         vk::PipelineShaderStageCreateFlags(),
-                        vk::ShaderStageFlagBits::eFragment, shader, "main");
+                        vk::ShaderStageFlagBits::eFragment, shader.module, "main", &specializationInfo);
             }
 
+            vk::VertexInputBindingDescription vertexBinding;
+            auto attributes = GatherVertexInput(vertexBinding);
             auto pipelineVertexInputStateCreateInfo = vk::PipelineVertexInputStateCreateInfo(
-                    vk::PipelineVertexInputStateCreateFlags(),
-                    m_VertexInputBindingDescription, m_AttributeDescriptions
-            );
+                    vk::PipelineVertexInputStateCreateFlags(), {}, attributes);
+            if (!attributes.empty()) pipelineVertexInputStateCreateInfo.setVertexBindingDescriptions(vertexBinding);
 
             vk::PipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo(
                     vk::PipelineInputAssemblyStateCreateFlags(),
@@ -147,9 +148,9 @@ namespace Iris::Vulkan {
                     vk::StencilOp::eKeep, vk::StencilOp::eKeep, vk::StencilOp::eKeep, vk::CompareOp::eAlways);
             vk::PipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo(
                     vk::PipelineDepthStencilStateCreateFlags(),  // flags
-                    true,                                        // depthTestEnable
-                    true,                                        // depthWriteEnable
-                    vk::CompareOp::eLessOrEqual,                 // depthCompareOp
+                    m_DepthTest,                                 // depthTestEnable
+                    m_DepthWrite,                                // depthWriteEnable
+                    m_DepthCompare,                              // depthCompareOp
                     false,                                       // depthBoundTestEnable
                     false,                                       // stencilTestEnable
                     stencilOpState,                              // front
@@ -182,8 +183,13 @@ namespace Iris::Vulkan {
                     colorComponentFlags      // colorWriteMask
             );
 
-            std::array<vk::PipelineColorBlendAttachmentState, 2> pipelineColorBlendAttachments = {
-                    pipelineColorBlendAttachmentStateEnabled, pipelineColorBlendAttachmentStateDisabled };
+            std::vector<vk::PipelineColorBlendAttachmentState> pipelineColorBlendAttachments;
+            for (auto output: m_ColorOutputs) {
+                pipelineColorBlendAttachments.push_back(output == ColorOutput::Blended
+                                                        ? pipelineColorBlendAttachmentStateEnabled
+                                                        : pipelineColorBlendAttachmentStateDisabled);
+                if (output == ColorOutput::Unused) pipelineColorBlendAttachments.back().colorWriteMask = {};
+            }
 
             vk::PipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo(
                     vk::PipelineColorBlendStateCreateFlags(),  // flags
@@ -211,11 +217,15 @@ namespace Iris::Vulkan {
                     &pipelineColorBlendStateCreateInfo,     // pColorBlendState
                     &pipelineDynamicStateCreateInfo,        // pDynamicState
                     out->pipelineLayout,                    // layout
-                    renderPass                              // renderPass
+                    renderPass,                             // renderPass
+                    m_Subpass                               // subpass
             );
 
             vk::Result result;
-            std::tie(result, out->pipeline) = m_Device.createGraphicsPipeline(nullptr, graphicsPipelineCreateInfo);
+            std::tie(result, out->pipeline) = CreateCached(
+                    m_Cache, m_Name, graphicsPipelineCreateInfo, [&](vk::PipelineCache cache, const auto& info) {
+                        return m_Device.createGraphicsPipeline(cache, info);
+                    });
             switch (result) {
                 case vk::Result::eSuccess:
                     break;
@@ -227,37 +237,331 @@ namespace Iris::Vulkan {
             }
         }
 
-        vk::DescriptorSetAllocateInfo descriptorSetAllocateInfo(m_DescriptorPool, out->descriptorSetLayouts);
-        out->descriptorSets = m_Device.allocateDescriptorSets(descriptorSetAllocateInfo);
+        return out;
+    }
+
+    std::unique_ptr<PipelineBuilder::Pipeline> PipelineBuilder::BuildCompute(uint32_t copies) {
+        if (!m_ComputeShader) {
+            Log::Core::Critical("Compute pipeline built without a compute shader");
+            std::exit(1);
+        }
+        auto out = CreateLayout(copies);
+
+        std::vector<vk::SpecializationMapEntry> specializationEntries;
+        std::vector<uint32_t> specializationData;
+        auto specializationInfo = GetSpecializationInfo(specializationEntries, specializationData);
+
+        vk::ComputePipelineCreateInfo computePipelineCreateInfo(
+                vk::PipelineCreateFlags(),
+                vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(),
+                                                  vk::ShaderStageFlagBits::eCompute, m_ComputeShader->module, "main",
+                                                  &specializationInfo),
+                out->pipelineLayout);
+
+        vk::Result result;
+        std::tie(result, out->pipeline) = CreateCached(
+                m_Cache, m_Name, computePipelineCreateInfo, [&](vk::PipelineCache cache, const auto& info) {
+                    return m_Device.createComputePipeline(cache, info);
+                });
+        if (result != vk::Result::eSuccess) {
+            Log::Core::Error("Failed to create compute pipeline: {}", vk::to_string(result));
+        }
+
+        return out;
+    }
+
+    vk::SpecializationInfo PipelineBuilder::GetSpecializationInfo(std::vector<vk::SpecializationMapEntry>& entries,
+                                                                  std::vector<uint32_t>& data) const {
+        for (auto [id, value]: m_Specialization) {
+            entries.emplace_back(id, static_cast<uint32_t>(data.size() * sizeof(uint32_t)), sizeof(uint32_t));
+            data.push_back(value);
+        }
+        return vk::SpecializationInfo(static_cast<uint32_t>(entries.size()), entries.data(),
+                                      data.size() * sizeof(uint32_t), data.data());
+    }
+
+    std::map<uint32_t, PipelineBuilder::SetBindings> PipelineBuilder::GatherBindings() const {
+        std::vector<const Shader*> shaders;
+        for (const auto& shader: m_VertexShaders) shaders.push_back(&shader);
+        for (const auto& shader: m_FragmentShaders) shaders.push_back(&shader);
+        if (m_ComputeShader) shaders.push_back(&*m_ComputeShader);
+
+        // Bindings used by several stages have to agree on what they are
+        std::map<uint32_t, SetBindings> out;
+        for (const auto* shader: shaders) {
+            for (const auto& [set, bindings]: shader->reflection.bindings) {
+                for (auto [binding, layout]: bindings) {
+                    if (m_DynamicBindings.contains({ set, binding })) {
+                        if (layout.descriptorType == vk::DescriptorType::eUniformBuffer) {
+                            layout.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+                        } else if (layout.descriptorType == vk::DescriptorType::eStorageBuffer) {
+                            layout.descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+                        }
+                    }
+                    if (auto size = m_ArraySizes.find({ set, binding }); size != m_ArraySizes.end()) {
+                        layout.descriptorCount = size->second;
+                    }
+                    if (layout.descriptorCount == 0) {
+                        Log::Core::Critical("{}: runtime array at set {} binding {} needs SetArraySize", m_Name, set,
+                                            binding);
+                        std::exit(1);
+                    }
+
+                    auto [it, inserted] = out[set].emplace(binding, layout);
+                    if (!inserted && (it->second.descriptorType != layout.descriptorType ||
+                                      it->second.descriptorCount != layout.descriptorCount)) {
+                        Log::Core::Critical("{}: stages disagree about set {} binding {}", m_Name, set, binding);
+                        std::exit(1);
+                    }
+                    it->second.stageFlags |= layout.stageFlags;
+                }
+            }
+        }
+        return out;
+    }
+
+    std::vector<vk::VertexInputAttributeDescription>
+    PipelineBuilder::GatherVertexInput(vk::VertexInputBindingDescription& binding) {
+        std::vector<ShaderReflection::Input> inputs;
+        for (const auto& shader: m_VertexShaders) {
+            inputs.insert(inputs.end(), shader.reflection.inputs.begin(), shader.reflection.inputs.end());
+        }
+
+        if (m_VertexInputBindingDescription) {
+            for (const auto& input: inputs) {
+                bool covered = std::any_of(m_AttributeDescriptions.begin(), m_AttributeDescriptions.end(),
+                                           [&](const auto& attribute) { return attribute.location == input.location; });
+                if (!covered) {
+                    Log::Core::Critical("{}: vertex input at location {} has no attribute", m_Name, input.location);
+                    std::exit(1);
+                }
+            }
+            binding = *m_VertexInputBindingDescription;
+            return m_AttributeDescriptions;
+        }
+
+        // Without a layout of its own the vertex buffer is assumed to hold the inputs tightly packed
+        std::vector<vk::VertexInputAttributeDescription> out;
+        binding = vk::VertexInputBindingDescription(0, 0);
+        for (const auto& input: inputs) {
+            out.emplace_back(input.location, 0, input.format, binding.stride);
+            binding.stride += input.size;
+        }
+        return out;
+    }
+
+    vk::DescriptorSetLayout PipelineBuilder::GetSetLayout(const SetBindings& bindings) {
+        std::vector<uint32_t> key;
+        for (const auto& [binding, layout]: bindings) {
+            key.insert(key.end(), { binding, static_cast<uint32_t>(layout.descriptorType), layout.descriptorCount,
+                                    static_cast<uint32_t>(layout.stageFlags) });
+        }
+        if (auto it = m_SetLayouts.find(key); it != m_SetLayouts.end()) return it->second;
+
+        std::vector<vk::DescriptorSetLayoutBinding> temp;
+        vk::DescriptorSetLayoutBindingFlagsCreateInfo setLayoutBindingsFlags = {};
+        std::vector<vk::DescriptorBindingFlags> bindingFlags{};
+
+        // Dynamic buffers and input attachments can't be updated after bind, and a set containing them can't use
+        // an update after bind layout at all
+        bool updateAfterBind = true;
+        for (auto [binding, layout]: bindings) {
+            switch (layout.descriptorType) {
+                case vk::DescriptorType::eUniformBufferDynamic:
+                case vk::DescriptorType::eStorageBufferDynamic:
+                case vk::DescriptorType::eInputAttachment:
+                    updateAfterBind = false;
+                    [[fallthrough]];
+                case vk::DescriptorType::eUniformBuffer:
+                    bindingFlags.emplace_back(vk::DescriptorBindingFlagBits::ePartiallyBound);
+                    break;
+                default:
+                    bindingFlags.emplace_back(vk::DescriptorBindingFlagBits::ePartiallyBound |
+                                              vk::DescriptorBindingFlagBits::eUpdateAfterBind);
+                    break;
+            }
+            temp.emplace_back(layout);
+        }
+        if (!updateAfterBind) {
+            for (auto& flags: bindingFlags) flags &= ~vk::DescriptorBindingFlagBits::eUpdateAfterBind;
+        }
+        setLayoutBindingsFlags.setBindingFlags(bindingFlags);
+
+        auto layoutFlags = updateAfterBind ? vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool
+                                           : vk::DescriptorSetLayoutCreateFlags();
+        auto layout = m_Device.createDescriptorSetLayout(
+                vk::DescriptorSetLayoutCreateInfo(layoutFlags, temp).setPNext(&setLayoutBindingsFlags));
+        m_SetLayouts.emplace(std::move(key), layout);
+        return layout;
+    }
+
+    vk::PipelineLayout PipelineBuilder::GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts,
+                                                          const std::vector<vk::PushConstantRange>& pushConstants) {
+        // Set layouts are unique handles thanks to the set layout cache, so they identify their contents
+        std::vector<uint32_t> key;
+        for (auto layout: setLayouts) {
+            auto handle = reinterpret_cast<uint64_t>(static_cast<VkDescriptorSetLayout>(layout));
+            key.insert(key.end(), { static_cast<uint32_t>(handle), static_cast<uint32_t>(handle >> 32) });
+        }
+        for (const auto& range: pushConstants) {
+            key.insert(key.end(), { static_cast<uint32_t>(range.stageFlags), range.offset, range.size });
+        }
+        if (auto it = m_PipelineLayouts.find(key); it != m_PipelineLayouts.end()) return it->second;
+
+        auto layout = m_Device.createPipelineLayout(vk::PipelineLayoutCreateInfo(
+                vk::PipelineLayoutCreateFlags(), setLayouts, pushConstants));
+        m_PipelineLayouts.emplace(std::move(key), layout);
+        return layout;
+    }
+
+    std::shared_ptr<PipelineBuilder::DescriptorSets>
+    PipelineBuilder::AllocateSets(vk::DescriptorSetLayout layout, const SetBindings& bindings, uint32_t copies) {
+        auto out = std::make_shared<DescriptorSets>();
+        out->device = m_Device;
+        out->copies.resize(copies);
+        if (copies == 0) return out;
+        std::vector<vk::DescriptorSetLayout> layouts(copies, layout);
+        vk::DescriptorSetAllocateInfo allocateInfo({}, layouts);
+
+        if (!m_DescriptorPools.empty()) {
+            allocateInfo.descriptorPool = m_DescriptorPools.back();
+            if (m_Device.allocateDescriptorSets(&allocateInfo, out->copies.data()) == vk::Result::eSuccess) {
+                out->pool = allocateInfo.descriptorPool;
+                return out;
+            }
+        }
+
+        // The last pool is full, the next one is made large enough for at least this allocation
+        std::map<vk::DescriptorType, uint32_t> needed;
+        for (const auto& [binding, info]: bindings) needed[info.descriptorType] += info.descriptorCount * copies;
+        std::vector<vk::DescriptorPoolSize> poolSizes;
+        for (auto type: { vk::DescriptorType::eSampler, vk::DescriptorType::eCombinedImageSampler,
+                          vk::DescriptorType::eSampledImage, vk::DescriptorType::eStorageImage,
+                          vk::DescriptorType::eUniformTexelBuffer, vk::DescriptorType::eStorageTexelBuffer,
+                          vk::DescriptorType::eUniformBuffer, vk::DescriptorType::eStorageBuffer,
+                          vk::DescriptorType::eUniformBufferDynamic, vk::DescriptorType::eStorageBufferDynamic,
+                          vk::DescriptorType::eInputAttachment }) {
+            poolSizes.emplace_back(type, std::max(PoolDescriptors, needed[type]));
+        }
+        m_DescriptorPools.push_back(m_Device.createDescriptorPool(
+                vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet |
+                                             vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+                                             std::max(PoolSets, copies), poolSizes)));
+
+        allocateInfo.descriptorPool = m_DescriptorPools.back();
+        VkCheck(m_Device.allocateDescriptorSets(&allocateInfo, out->copies.data()), "Allocate descriptor sets");
+        out->pool = allocateInfo.descriptorPool;
+        return out;
+    }
+
+    std::unique_ptr<PipelineBuilder::Pipeline> PipelineBuilder::CreateLayout(uint32_t copies) {
+        auto out = std::unique_ptr<Pipeline>(new Pipeline(m_Device));
+        out->descriptorSetLayoutBindings = GatherBindings();
+        uint32_t setCount = out->descriptorSetLayoutBindings.empty()
+                            ? 0 : out->descriptorSetLayoutBindings.rbegin()->first + 1;
+
+        for (uint32_t set = 0; set < setCount; ++set) {
+            // Set numbers a pipeline skips still need a (empty) layout
+            auto& bindings = out->descriptorSetLayoutBindings[set];
+
+            const auto* shared = m_SharedPipeline;
+            if (shared && set < shared->sets.size()) {
+                const auto& sharedBindings = shared->descriptorSetLayoutBindings.at(set);
+                bool compatible = shared->descriptorSets.size() == copies &&
+                                  std::all_of(bindings.begin(), bindings.end(), [&](const auto& entry) {
+                                      auto it = sharedBindings.find(entry.first);
+                                      return it != sharedBindings.end() &&
+                                             it->second.descriptorType == entry.second.descriptorType &&
+                                             it->second.descriptorCount == entry.second.descriptorCount &&
+                                             (it->second.stageFlags & entry.second.stageFlags) ==
+                                             entry.second.stageFlags;
+                                  });
+                if (!compatible) {
+                    Log::Core::Critical("{}: set {} can't be shared, its bindings differ", m_Name, set);
+                    std::exit(1);
+                }
+                bindings = sharedBindings;
+                out->descriptorSetLayouts.push_back(shared->descriptorSetLayouts[set]);
+                out->sets.push_back(shared->sets[set]);
+                continue;
+            }
+
+            auto layout = GetSetLayout(bindings);
+            out->descriptorSetLayouts.push_back(layout);
+            out->sets.push_back(AllocateSets(layout, bindings, copies));
+        }
+
+        // One range covering every stage with push constants
+        std::vector<vk::PushConstantRange> pushConstants;
+        vk::PushConstantRange range({}, 0, 0);
+        for (const auto* shaders: { &m_VertexShaders, &m_FragmentShaders }) {
+            for (const auto& shader: *shaders) {
+                if (shader.reflection.pushConstantSize == 0) continue;
+                range.stageFlags |= shader.reflection.stage;
+                range.size = std::max(range.size, shader.reflection.pushConstantSize);
+            }
+        }
+        if (m_ComputeShader && m_ComputeShader->reflection.pushConstantSize > 0) {
+            range.stageFlags |= vk::ShaderStageFlagBits::eCompute;
+            range.size = m_ComputeShader->reflection.pushConstantSize;
+        }
+        if (range.size > 0) pushConstants.push_back(range);
+
+        out->pipelineLayout = GetPipelineLayout(out->descriptorSetLayouts, pushConstants);
 
+        out->descriptorSets.resize(copies);
+        for (uint32_t copy = 0; copy < copies; ++copy) {
+            for (const auto& sets: out->sets) out->descriptorSets[copy].push_back(sets->copies[copy]);
+        }
         return out;
     }
 
     PipelineBuilder& PipelineBuilder::Clear() {
-        m_VertexInputBindingDescription = vk::VertexInputBindingDescription();
+        m_VertexInputBindingDescription.reset();
         m_AttributeDescriptions.clear();
 
         for (auto& shader: m_VertexShaders) {
-            m_Device.destroyShaderModule(shader);
+            m_Device.destroyShaderModule(shader.module);
         }
         for (auto& shader: m_FragmentShaders) {
-            m_Device.destroyShaderModule(shader);
+            m_Device.destroyShaderModule(shader.module);
         }
+        if (m_ComputeShader) m_Device.destroyShaderModule(m_ComputeShader->module);
         m_FragmentShaders.clear();
         m_VertexShaders.clear();
-        m_PushConstants.clear();
-        m_PushConstantOffset = 0u;
-        m_DescriptorSetLayoutBindings.clear();
+        m_ComputeShader.reset();
+        m_DynamicBindings.clear();
+        m_ArraySizes.clear();
+        m_SharedPipeline = nullptr;
+        m_Specialization.clear();
+        m_Subpass = 0;
+        m_ColorOutputs = { ColorOutput::Blended, ColorOutput::Opaque };
+        m_DepthTest = true;
+        m_DepthWrite = true;
+        m_DepthCompare = vk::CompareOp::eLessOrEqual;
+        m_Name.clear();
 
         return *this;
     }
 
     PipelineBuilder::~PipelineBuilder() {
         Clear();
-        m_Device.destroyDescriptorPool(m_DescriptorPool);
+        for (auto& [key, layout]: m_PipelineLayouts) m_Device.destroyPipelineLayout(layout);
+        for (auto& [key, layout]: m_SetLayouts) m_Device.destroyDescriptorSetLayout(layout);
+        for (auto& pool: m_DescriptorPools) m_Device.destroyDescriptorPool(pool);
+    }
+
+    size_t PipelineBuilder::KeyHash::operator()(const std::vector<uint32_t>& key) const {
+        size_t hash = key.size();
+        for (uint32_t value: key) hash = hash * 31 + value;
+        return hash;
     }
 
-    std::optional<vk::ShaderModule> PipelineBuilder::loadShaderModule(std::string path) {
+    PipelineBuilder::DescriptorSets::~DescriptorSets() {
+        if (!copies.empty()) device.freeDescriptorSets(pool, copies);
+    }
+
+    std::optional<PipelineBuilder::Shader> PipelineBuilder::loadShaderModule(std::string path) {
         std::ifstream file(path.data(), std::ios::ate | std::ios::binary);
 
         if (!file.is_open()) {
@@ -271,40 +575,53 @@ namespace Iris::Vulkan {
         file.seekg(0);
         file.read((char*)buffer.data(), (std::streamsize)fileSize);
         file.close();
+        if (m_Name.empty()) m_Name = std::filesystem::path(path).filename().string();
+
+        auto reflection = ReflectShader(buffer, path);
+        if (!reflection) return {};
 
-        return m_Device
-                .createShaderModule(vk::ShaderModuleCreateInfo({}, buffer.size() * sizeof(uint32_t), buffer.data()));
+        return Shader{ m_Device.createShaderModule(
+                vk::ShaderModuleCreateInfo({}, buffer.size() * sizeof(uint32_t), buffer.data())), *reflection };
     }
 
-    PipelineBuilder::Pipeline::Pipeline(const vk::Device& device, const vk::DescriptorPool& descriptorPool,
-                                        const std::map<uint32_t, std::map<uint32_t, vk::DescriptorSetLayoutBinding>>& descriptorSetLayoutBindings)
-            : device(device), descriptorPool(descriptorPool),
-              descriptorSetLayoutBindings(descriptorSetLayoutBindings) {}
+    PipelineBuilder::Pipeline::Pipeline(const vk::Device& device) : device(device) {}
 
     void PipelineBuilder::Pipeline::UpdateBuffer(uint32_t set, uint32_t binding, vk::DescriptorBufferInfo info,
                                                  uint32_t index) {
-        vk::WriteDescriptorSet writeDescriptorSet(
-                descriptorSets[set], binding, index, descriptorSetLayoutBindings.at(set).at(binding).descriptorType,
-                {}, info);
-        device.updateDescriptorSets(writeDescriptorSet, nullptr);
+        for (uint32_t copy = 0; copy < descriptorSets.size(); ++copy) {
+            UpdateFrameBuffer(copy, set, binding, info, index);
+        }
     }
 
     void PipelineBuilder::Pipeline::UpdateImage(uint32_t set, uint32_t binding, vk::DescriptorImageInfo info,
                                                 uint32_t index) {
+        std::vector<vk::WriteDescriptorSet> writeDescriptorSets;
+        for (auto& sets: descriptorSets) {
+            writeDescriptorSets.push_back(vk::WriteDescriptorSet(
+                    sets[set], binding, index, descriptorSetLayoutBindings.at(set).at(binding).descriptorType,
+                    info, {}));
+        }
+        device.updateDescriptorSets(writeDescriptorSets, nullptr);
+    }
+
+    void PipelineBuilder::Pipeline::UpdateFrameBuffer(uint32_t copy, uint32_t set, uint32_t binding,
+                                                      vk::DescriptorBufferInfo info, uint32_t index) {
         vk::WriteDescriptorSet writeDescriptorSet(
-                descriptorSets[set], binding, index, descriptorSetLayoutBindings.at(set).at(binding).descriptorType,
-                info, {});
+                descriptorSets[copy][set], binding, index,
+                descriptorSetLayoutBindings.at(set).at(binding).descriptorType, {}, info);
         device.updateDescriptorSets(writeDescriptorSet, nullptr);
     }
 
-    PipelineBuilder::Pipeline::~Pipeline() {
-        device.freeDescriptorSets(descriptorPool, descriptorSets);
+    void PipelineBuilder::Pipeline::UpdateFrameImage(uint32_t copy, uint32_t set, uint32_t binding,
+                                                     vk::DescriptorImageInfo info, uint32_t index) {
+        vk::WriteDescriptorSet writeDescriptorSet(
+                descriptorSets[copy][set], binding, index,
+                descriptorSetLayoutBindings.at(set).at(binding).descriptorType, info, {});
+        device.updateDescriptorSets(writeDescriptorSet, nullptr);
+    }
 
+    PipelineBuilder::Pipeline::~Pipeline() {
+        // Layouts belong to the builder, descriptor sets are freed with the last pipeline sharing them
         device.destroyPipeline(pipeline);
-        device.destroyPipelineLayout(pipelineLayout);
-
-        for (auto& layout: descriptorSetLayouts) {
-            device.destroyDescriptorSetLayout(layout);
-        }
     }
 }
\ No newline at end of file
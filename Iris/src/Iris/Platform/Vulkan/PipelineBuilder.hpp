@@ -1,59 +1,132 @@
 #pragma once
 #include <vulkan/vulkan.hpp>
+#include "Iris/Platform/Vulkan/PipelineCache.hpp"
+#include "Iris/Platform/Vulkan/ShaderReflection.hpp"
 
 namespace Iris::Vulkan {
+    // Descriptor set layouts, push constant ranges and vertex inputs are reflected from the shaders' SPIR-V.
+    // Identical set and pipeline layouts are created once and shared by every pipeline using them.
     class PipelineBuilder final {
     public:
         class Pipeline;
 
-        explicit PipelineBuilder(const vk::Device& mDevice);
+        // How a graphics pipeline writes each color attachment of its subpass, by fragment output location
+        enum class ColorOutput {
+            Blended,    // alpha blended
+            Opaque,
+            Unused      // write mask 0, the attachment keeps its contents
+        };
+
+        PipelineBuilder(const vk::Device& mDevice, PipelineCache& cache);
+        // Replaces the reflected vertex input (tightly packed in location order) for vertex buffers with a
+        // layout of their own. Every input of the vertex shader still has to be covered.
         PipelineBuilder& SetVertexInputAttributes(const vk::VertexInputBindingDescription&& description,
                                                   const std::vector<vk::VertexInputAttributeDescription>&& attributes);
         PipelineBuilder& AddVertexShader(std::string path);
         PipelineBuilder& AddFragmentShader(std::string path);
-        PipelineBuilder& AddUniform(uint32_t set, uint32_t binding, vk::ShaderStageFlags stage, uint32_t count = 1);
-        PipelineBuilder&
-        AddStorageBuffer(uint32_t set, uint32_t binding, vk::ShaderStageFlags stage, uint32_t count = 1);
-        PipelineBuilder& AddImage(uint32_t set, uint32_t binding, vk::ShaderStageFlags stage, uint32_t count = 1);
-        PipelineBuilder& AddPushConstant(vk::ShaderStageFlags stage, size_t size);
-        std::unique_ptr<Pipeline> Build(vk::RenderPass& renderPass);
+        PipelineBuilder& AddComputeShader(std::string path);
+        // The two things SPIR-V can't tell: buffers bound with a dynamic offset and the size of runtime arrays
+        PipelineBuilder& SetDynamic(uint32_t set, uint32_t binding);
+        PipelineBuilder& SetArraySize(uint32_t set, uint32_t binding, uint32_t count);
+        // Sets the next pipeline has in common with this one use its layout and descriptor sets, so they are
+        // written and bound once for both
+        PipelineBuilder& ShareDescriptorSets(const Pipeline& pipeline);
+        // 32 bit specialization constant given to every stage, stages that don't declare the id ignore it
+        PipelineBuilder& SetSpecialization(uint32_t constantId, uint32_t value);
+        // Graphics only, default to subpass 0, a blended color and an opaque ID output, depth test and write
+        PipelineBuilder& SetSubpass(uint32_t subpass);
+        PipelineBuilder& SetColorOutputs(std::vector<ColorOutput> outputs);
+        PipelineBuilder& SetDepth(bool test, bool write, vk::CompareOp compare = vk::CompareOp::eLessOrEqual);
+        std::unique_ptr<Pipeline> Build(vk::RenderPass& renderPass, uint32_t copies = 1);
+        std::unique_ptr<Pipeline> BuildCompute(uint32_t copies = 1);
+
+        [[nodiscard]] size_t GetSetLayoutCount() const { return m_SetLayouts.size(); }
+        [[nodiscard]] size_t GetPipelineLayoutCount() const { return m_PipelineLayouts.size(); }
 
         PipelineBuilder& Clear();
         ~PipelineBuilder();
     private:
-        std::optional<vk::ShaderModule> loadShaderModule(std::string path);
+        using SetBindings = std::map<uint32_t, vk::DescriptorSetLayoutBinding>;
+
+        struct Shader {
+            vk::ShaderModule module;
+            ShaderReflection reflection;
+        };
+
+        // One set allocated for every copy, freed once the last pipeline using it is gone
+        struct DescriptorSets {
+            vk::Device device;
+            vk::DescriptorPool pool;
+            std::vector<vk::DescriptorSet> copies;
+
+            ~DescriptorSets();
+        };
+
+        struct KeyHash {
+            size_t operator()(const std::vector<uint32_t>& key) const;
+        };
+
+        std::optional<Shader> loadShaderModule(std::string path);
+        std::map<uint32_t, SetBindings> GatherBindings() const;
+        std::vector<vk::VertexInputAttributeDescription> GatherVertexInput(vk::VertexInputBindingDescription& binding);
+        vk::DescriptorSetLayout GetSetLayout(const SetBindings& bindings);
+        vk::PipelineLayout GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts,
+                                             const std::vector<vk::PushConstantRange>& pushConstants);
+        std::shared_ptr<DescriptorSets> AllocateSets(vk::DescriptorSetLayout layout, const SetBindings& bindings,
+                                                     uint32_t copies);
+        std::unique_ptr<Pipeline> CreateLayout(uint32_t copies);
+        vk::SpecializationInfo GetSpecializationInfo(std::vector<vk::SpecializationMapEntry>& entries,
+                                                     std::vector<uint32_t>& data) const;
     private:
         vk::Device m_Device;
-        vk::DescriptorPool m_DescriptorPool;
-        size_t m_PushConstantOffset = 0u;
+        PipelineCache& m_Cache;
+        std::vector<vk::DescriptorPool> m_DescriptorPools;  // a new one is added whenever the last one is full
+        std::string m_Name;     // first shader added, for the creation stats
 
-        vk::VertexInputBindingDescription m_VertexInputBindingDescription;
+        std::optional<vk::VertexInputBindingDescription> m_VertexInputBindingDescription;
         std::vector<vk::VertexInputAttributeDescription> m_AttributeDescriptions;
 
-        std::map<uint32_t, std::map<uint32_t, vk::DescriptorSetLayoutBinding>> m_DescriptorSetLayoutBindings;
+        std::set<std::pair<uint32_t, uint32_t>> m_DynamicBindings;
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> m_ArraySizes;
+        const Pipeline* m_SharedPipeline = nullptr;
+        std::map<uint32_t, uint32_t> m_Specialization;  // constant id -> value
+        uint32_t m_Subpass = 0;
+        std::vector<ColorOutput> m_ColorOutputs{ ColorOutput::Blended, ColorOutput::Opaque };
+        bool m_DepthTest = true;
+        bool m_DepthWrite = true;
+        vk::CompareOp m_DepthCompare = vk::CompareOp::eLessOrEqual;
+
+        std::vector<Shader> m_VertexShaders;
+        std::vector<Shader> m_FragmentShaders;
+        std::optional<Shader> m_ComputeShader;
 
-        std::vector<vk::ShaderModule> m_VertexShaders;
-        std::vector<vk::ShaderModule> m_FragmentShaders;
-        std::vector<vk::PushConstantRange> m_PushConstants;
+        std::unordered_map<std::vector<uint32_t>, vk::DescriptorSetLayout, KeyHash> m_SetLayouts;
+        std::unordered_map<std::vector<uint32_t>, vk::PipelineLayout, KeyHash> m_PipelineLayouts;
     public:
         class Pipeline final {
         public:
-            vk::PipelineLayout pipelineLayout;
+            vk::PipelineLayout pipelineLayout;                          // owned by the builder's layout cache
             vk::Pipeline pipeline;
-            std::vector<vk::DescriptorSetLayout> descriptorSetLayouts;
-            std::vector<vk::DescriptorSet> descriptorSets;
+            std::vector<vk::DescriptorSetLayout> descriptorSetLayouts;  // owned by the builder's layout cache
+            std::vector<std::vector<vk::DescriptorSet>> descriptorSets; // one copy of every set per frame in flight
 
+            // Writes the descriptor into every copy
             void UpdateBuffer(uint32_t set, uint32_t binding, vk::DescriptorBufferInfo info, uint32_t index = 0);
             void UpdateImage(uint32_t set, uint32_t binding, vk::DescriptorImageInfo info, uint32_t index = 0);
 
+            // Writes the descriptor into a single copy, for per-frame resources
+            void UpdateFrameBuffer(uint32_t copy, uint32_t set, uint32_t binding, vk::DescriptorBufferInfo info,
+                                   uint32_t index = 0);
+            void UpdateFrameImage(uint32_t copy, uint32_t set, uint32_t binding, vk::DescriptorImageInfo info,
+                                  uint32_t index = 0);
+
             ~Pipeline();
         private:
-            Pipeline(const vk::Device& device, const vk::DescriptorPool& descriptorPool,
-                     const std::map<uint32_t, std::map<uint32_t, vk::DescriptorSetLayoutBinding>>& descriptorSetLayoutBindings);
+            explicit Pipeline(const vk::Device& device);
 
             vk::Device device;
-            vk::DescriptorPool descriptorPool;
-            const std::map<uint32_t, std::map<uint32_t, vk::DescriptorSetLayoutBinding>> descriptorSetLayoutBindings; // This has to be a copy
+            std::map<uint32_t, SetBindings> descriptorSetLayoutBindings;
+            std::vector<std::shared_ptr<DescriptorSets>> sets;  // per set number, possibly shared
 
             friend PipelineBuilder;
         };
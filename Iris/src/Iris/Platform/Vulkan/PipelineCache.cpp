@@ -0,0 +1,100 @@
+#include "PipelineCache.hpp"
+
+namespace Iris::Vulkan {
+    // VkPipelineCacheHeaderVersionOne, read by hand so a stale or foreign file never reaches the driver
+    static constexpr size_t HeaderSize = 16 + VK_UUID_SIZE;
+
+    static bool MatchesDevice(std::span<const std::byte> data, const vk::PhysicalDeviceProperties& properties) {
+        if (data.size() < HeaderSize) return false;
+
+        std::array<uint32_t, 4> header{};
+        std::memcpy(header.data(), data.data(), sizeof(header));
+        return header[0] >= HeaderSize && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header[2] == properties.vendorID && header[3] == properties.deviceID &&
+               std::memcmp(data.data() + 16, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+    }
+
+    PipelineCache::PipelineCache(vk::Device device, vk::PhysicalDevice physicalDevice, bool creationFeedback)
+            : m_Device(device), m_Properties(physicalDevice.getProperties()), m_CreationFeedback(creationFeedback) {
+        std::string uuid;
+        for (uint8_t byte: m_Properties.pipelineCacheUUID) uuid += fmt::format("{:02x}", byte);
+        m_Path = fmt::format("pipelines-{:04x}-{:04x}-{}.vkcache", m_Properties.vendorID, m_Properties.deviceID,
+                             uuid);
+
+        std::vector<std::byte> data;
+        if (std::ifstream file(m_Path, std::ios::binary | std::ios::ate); file) {
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file || !MatchesDevice(data, m_Properties)) {
+                Log::Core::Warn("Pipeline cache {} doesn't match this device or driver, rebuilding it",
+                                m_Path.string());
+                data.clear();
+            }
+        }
+        m_LoadedBytes = data.size();
+        m_Cache = m_Device.createPipelineCache(vk::PipelineCacheCreateInfo({}, data.size(), data.data()));
+        Log::Core::Info("Pipeline cache {}: {} KiB loaded", m_Path.string(), m_LoadedBytes >> 10);
+    }
+
+    void PipelineCache::Record(std::string_view name, const vk::PipelineCreationFeedbackEXT& feedback, double ms) {
+        std::lock_guard lock(m_Mutex);
+        m_CreationMs += ms;
+
+        const char* source = "no feedback";
+        if (!m_CreationFeedback || !(feedback.flags & vk::PipelineCreationFeedbackFlagBitsEXT::eValid)) {
+            ++m_Unknown;
+        } else if (feedback.flags & vk::PipelineCreationFeedbackFlagBitsEXT::eApplicationPipelineCacheHit) {
+            ++m_Hits;
+            source = "cache hit";
+        } else {
+            ++m_Misses;
+            source = "cache miss";
+        }
+        Log::Core::Trace("Pipeline {} created in {:.2f}ms ({})", name, ms, source);
+    }
+
+    void PipelineCache::LogStats() const {
+        std::lock_guard lock(m_Mutex);
+        if (m_CreationFeedback) {
+            Log::Core::Info("Pipelines: {} cache hits, {} misses, created in {:.2f}ms", m_Hits, m_Misses,
+                            m_CreationMs);
+        } else {
+            Log::Core::Info("Pipelines: {} created in {:.2f}ms (no creation feedback, hits unknown)",
+                            m_Hits + m_Misses + m_Unknown, m_CreationMs);
+        }
+    }
+
+    bool PipelineCache::Save() const {
+        std::lock_guard lock(m_Mutex);
+        auto data = m_Device.getPipelineCacheData(m_Cache);
+        // Without feedback nothing counts as a miss, a changed size is then the only sign of new pipelines
+        if (m_Misses == 0 && data.size() == m_LoadedBytes) return true;
+
+        // Written under a temporary name first, a crash mid write must not leave a cache the driver chokes on
+        auto temporary = m_Path;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                Log::Core::Warn("Failed to write pipeline cache {}", temporary.string());
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary, m_Path, error);
+        if (error) {
+            Log::Core::Warn("Failed to write pipeline cache {}: {}", m_Path.string(), error.message());
+            return false;
+        }
+        Log::Core::Info("Pipeline cache {}: {} KiB saved", m_Path.string(), data.size() >> 10);
+        return true;
+    }
+
+    PipelineCache::~PipelineCache() {
+        Save();
+        m_Device.destroyPipelineCache(m_Cache);
+    }
+}
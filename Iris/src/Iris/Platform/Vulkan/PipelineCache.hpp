@@ -0,0 +1,36 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+namespace Iris::Vulkan {
+    // Driver pipeline cache shared by every pipeline build, so shaders compiled by an earlier run are reused.
+    // It's stored per device and driver (keyed by their pipeline cache UUID), loaded on creation and written
+    // back when destroyed if new pipelines were added.
+    class PipelineCache final {
+    public:
+        // creationFeedback: VK_EXT_pipeline_creation_feedback is enabled, without it hits can't be told apart
+        PipelineCache(vk::Device device, vk::PhysicalDevice physicalDevice, bool creationFeedback);
+
+        [[nodiscard]] vk::PipelineCache Get() const { return m_Cache; }
+        [[nodiscard]] bool HasCreationFeedback() const { return m_CreationFeedback; }
+
+        // Counts one pipeline creation, feedback is only looked at when the extension is enabled
+        void Record(std::string_view name, const vk::PipelineCreationFeedbackEXT& feedback, double ms);
+        void LogStats() const;
+        bool Save() const;
+
+        ~PipelineCache();
+    private:
+        vk::Device m_Device;
+        vk::PhysicalDeviceProperties m_Properties;
+        std::filesystem::path m_Path;
+        bool m_CreationFeedback;
+        vk::PipelineCache m_Cache;
+        size_t m_LoadedBytes = 0;
+
+        mutable std::mutex m_Mutex;
+        uint32_t m_Hits = 0;
+        uint32_t m_Misses = 0;
+        uint32_t m_Unknown = 0;     // created without feedback
+        double m_CreationMs = 0.0;
+    };
+}
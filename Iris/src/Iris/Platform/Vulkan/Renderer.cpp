@@ -6,33 +6,94 @@
 #include "Iris/Renderer/Vertex.hpp"
 #include "Iris/Platform/Vulkan/Util.hpp"
 #include "Iris/Platform/Vulkan/Texture.hpp"
-#include "Iris/Platform/Vulkan/PushConstants.hpp"
+#include "Iris/Platform/Vulkan/InstanceData.hpp"
 #include "Iris/Util/Input.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "Iris/Math/Math.hpp"
+#include "Iris/Platform/Vulkan/CullData.hpp"
+#include "Iris/Core/JobSystem.hpp"
 
 namespace Iris::Vulkan {
-    Renderer::Renderer(const std::shared_ptr<Window>& window) : Iris::Renderer(window) {
+    static constexpr uint32_t MaxLights = 500;
+    static constexpr uint32_t MaxTextures = 1024;   // size of the bindless texture arrays
+    static constexpr uint32_t CullGroupSize = 64;   // local_size_x of the culling shaders
+    static constexpr uint32_t HiZGroupSize = 8;     // local_size_x/y of HiZ.comp
+    // Layout the main pass leaves the stored depth in, where the Hi-Z build right after it picks it up
+    static constexpr vk::ImageLayout DepthFinalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+    // G-buffer of the deferred path, the world position is rebuilt from depth
+    static constexpr vk::Format GBufferAlbedoFormat = vk::Format::eR8G8B8A8Srgb;
+    static constexpr vk::Format GBufferNormalFormat = vk::Format::eR16G16B16A16Sfloat;
+
+    // Feature bits of the UberShader.frag variants, bit n is specialization constant n
+    enum ShaderFeature : uint32_t {
+        Textured = 1 << 0,
+        AlphaTest = 1 << 1,
+        PointLights = 1 << 2,       // the light bits follow LightType's order
+        DirectionalLights = 1 << 3,
+        SpotLights = 1 << 4,
+        AllFeatures = (1 << 5) - 1,
+    };
+    // Material features are picked per renderable and each combination is a draw bucket, light features are
+    // the same for the whole frame
+    static constexpr uint32_t MaterialFeatures = Textured | AlphaTest;
+    static constexpr uint32_t BucketCount = MaterialFeatures + 1;  // size of bucketEnds in CullData
+    static constexpr uint32_t DepthKeyBits = 30;    // view depth precision of the draw sort keys
+
+    // Grows a persistently mapped per-frame buffer, returns true when it had to be recreated
+    template <typename T>
+    static bool ReserveMapped(const std::shared_ptr<Context>& ctx, std::unique_ptr<Buffer<T>>& buffer, T*& data,
+                              size_t count, vk::BufferUsageFlags usage,
+                              const std::vector<uint32_t>& queueFamilies = {}) {
+        if (buffer && buffer->GetSize() >= count * sizeof(T)) return false;
+
+        // Only called once the frame's fence has been waited on, so the old buffer is no longer in use
+        size_t capacity = buffer ? buffer->GetSize() / sizeof(T) : 0;
+        buffer = std::make_unique<Buffer<T>>(ctx, usage, std::max(count, capacity * 2), queueFamilies);
+        data = buffer->MapPersistent();
+        return true;
+    }
+
+    Renderer::Renderer(const std::shared_ptr<Window>& window, const RendererOptions& options)
+            : Iris::Renderer(window, options), m_Headless(window == nullptr),
+              m_Deferred(options.Deferred), m_DepthPrepass(options.DepthPrepass),
+              m_Frames(glm::max(options.FramesInFlight, 1u)) {
         m_Ctx = std::make_shared<Context>(window);
+        ImageData::SetBlockCompression(m_Ctx->SupportsBlockCompression());
+        m_MaterialSampler.maxAnisotropy = options.MaxAnisotropy;
+        m_MaterialSampler.lodBias = options.TextureLodBias;
+        m_CullQueueFamilies = { m_Ctx->GetGraphicsQueueFamilyIndex(), m_Ctx->GetComputeQueueFamilyIndex() };
         m_UploadContext = std::make_shared<UploadContext>(m_Ctx);
-
-        InitSwapchain();
+        m_GeometryPool = std::make_unique<GeometryPool>(m_Ctx, m_UploadContext);
+        m_TextureStreamer = std::make_unique<TextureStreamer>(m_Ctx, m_UploadContext, options.TextureBudget,
+                                                              m_MaterialSampler);
+        m_TextureSwaps.resize(m_Frames.size());
+
+        if (m_Headless) {
+            InitOffscreenTargets();
+            InitReadbackBuffers();
+        } else {
+            InitSwapchain();
+        }
         InitDepthBuffer();
+        InitHiZBuffer();
         InitIDBuffer();
+        InitGBuffer();
         InitRenderPass();
         InitFramebuffers();
         InitCommandBuffers();
         InitSyncStructures();
         InitUniformBuffer();
         InitPipelines();
-        InitImGui();
+        if (!m_Headless) InitImGui();
 
-        Input::Get().on<Key>([&](int button, KeyMods mods) {
+        if (!m_Headless) Input::Get().on<Key>([&](int button, KeyMods mods) {
             if (ImGui::GetIO().WantCaptureMouse) return;
             if (Input::IsKeyPressed(GLFW_KEY_LEFT_ALT)) return;
             if (button == GLFW_MOUSE_BUTTON_1) {
                 glm::uvec2 pos = Input::GetMousePos();
 
+                // the ID buffer is shared by all frames in flight, let them finish before reading it back
+                m_Ctx->GetGraphicsQueue().waitIdle();
                 m_IDTexture->CopyToStagingBuffer();
                 auto data = m_IDTexture->MapStagingBuffer();
                 uint32_t id = data[pos.y * m_Size.x + pos.x];
@@ -48,12 +109,15 @@ namespace Iris::Vulkan {
                 gizmoMode = 2;
         });
 
-        m_Textures.emplace_back(m_Ctx, m_UploadContext, "../Assets/Icons/LightPoint.png", 4);
-        m_Textures.emplace_back(m_Ctx, m_UploadContext, "../Assets/Icons/LightDirectional.png", 4);
-        m_Textures.emplace_back(m_Ctx, m_UploadContext, "../Assets/Icons/LightSpot.png", 4);
-        m_BillboardPipeline->UpdateImage(1, 0, m_Textures[m_Textures.size() - 3].GetDescriptor(), 0);
-        m_BillboardPipeline->UpdateImage(1, 0, m_Textures[m_Textures.size() - 2].GetDescriptor(), 1);
-        m_BillboardPipeline->UpdateImage(1, 0, m_Textures[m_Textures.size() - 1].GetDescriptor(), 2);
+        // Billboards always face the camera, anisotropy wouldn't change a thing
+        SamplerDesc iconSampler{ .addressMode = vk::SamplerAddressMode::eClampToEdge, .maxAnisotropy = 1.f };
+        for (auto icon: { "LightPoint", "LightDirectional", "LightSpot" }) {
+            m_Icons.emplace_back(m_Ctx, m_UploadContext, fmt::format("../Assets/Icons/{}.png", icon),
+                                 ImageUsage::Icon, iconSampler);
+        }
+        for (uint32_t i = 0; i < m_Icons.size(); ++i) {
+            m_BillboardPipeline->UpdateImage(1, 0, m_Icons[i].GetDescriptor(), i);
+        }
     }
 
     void Renderer::InitSwapchain() {
@@ -136,16 +200,49 @@ namespace Iris::Vulkan {
         }
     }
 
-    void Renderer::InitDepthBuffer() {
-        vk::FormatProperties formatProperties = m_Ctx->GetPhysDevice().getFormatProperties(m_DepthFormat);
+    void Renderer::InitOffscreenTargets() {
+        // One color target per frame in flight, each frame renders into and reads back from its own image
+        m_SwapchainFormat = vk::Format::eR8G8B8A8Unorm;
+        m_SwapchainExtent = vk::Extent2D(m_Size.x, m_Size.y);
 
-        vk::ImageTiling tiling;
-        if (formatProperties.linearTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment) {
-            tiling = vk::ImageTiling::eLinear;
-        } else if (formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment) {
-            tiling = vk::ImageTiling::eOptimal;
-        } else {
-            Log::Core::Critical("DepthStencilAttachment is not supported for D16Unorm depth format.");
+        vk::ImageViewCreateInfo imageViewCreateInfo({}, {}, vk::ImageViewType::e2D, m_SwapchainFormat, {},
+                                                    { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 });
+        for (size_t i = 0; i < m_Frames.size(); ++i) {
+            auto& target = m_OffscreenTargets.emplace_back(std::make_unique<Texture<uint8_t>>(
+                    m_Ctx, m_UploadContext, m_Size, m_SwapchainFormat,
+                    vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc));
+            m_SwapchainImages.push_back(target->GetImage());
+            m_SwapchainImageViews.push_back(target->GetDescriptor().imageView);
+        }
+    }
+
+    void Renderer::InitReadbackBuffers() {
+        for (auto& frame: m_Frames) {
+            frame.readbackBuffer = std::make_unique<Buffer<uint8_t>>(
+                    m_Ctx, vk::BufferUsageFlagBits::eTransferDst, static_cast<size_t>(m_Size.x * m_Size.y * 4));
+            frame.readbackData = frame.readbackBuffer->MapPersistent();
+        }
+    }
+
+    void Renderer::InitDepthBuffer() {
+        // The culling pass samples last frame's depth to build the Hi-Z pyramid. The deferred lighting rebuilds
+        // positions from it, which needs more precision than 16 bits where the device has it.
+        auto features = vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage;
+        std::optional<vk::ImageTiling> tiling;
+        for (auto format: { vk::Format::eD32Sfloat, vk::Format::eD16Unorm }) {
+            vk::FormatProperties formatProperties = m_Ctx->GetPhysDevice().getFormatProperties(format);
+            m_DepthFormat = format;
+            if ((formatProperties.optimalTilingFeatures & features) == features) {
+                tiling = vk::ImageTiling::eOptimal;
+                break;
+            }
+            if ((formatProperties.linearTilingFeatures & features) == features) {
+                tiling = vk::ImageTiling::eLinear;
+                break;
+            }
+        }
+        if (!tiling) {
+            Log::Core::Critical("DepthStencilAttachment is not supported for D32Sfloat or D16Unorm depth format.");
             std::exit(1);
         }
         vk::ImageCreateInfo imageCreateInfo(vk::ImageCreateFlags(),
@@ -155,33 +252,59 @@ namespace Iris::Vulkan {
                                             1,
                                             1,
                                             vk::SampleCountFlagBits::e1,
-                                            tiling,
-                                            vk::ImageUsageFlagBits::eDepthStencilAttachment);
+                                            *tiling,
+                                            vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                                            vk::ImageUsageFlagBits::eInputAttachment |
+                                            vk::ImageUsageFlagBits::eSampled);
         m_DepthImage = m_Ctx->GetDevice().createImage(imageCreateInfo);
 
-        vk::PhysicalDeviceMemoryProperties memoryProperties = m_Ctx->GetPhysDevice().getMemoryProperties();
-        vk::MemoryRequirements memoryRequirements = m_Ctx->GetDevice().getImageMemoryRequirements(m_DepthImage);
-        uint32_t typeBits = memoryRequirements.memoryTypeBits;
-        auto typeIndex = uint32_t(~0);
-        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
-            if ((typeBits & 1) &&
-                ((memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) ==
-                 vk::MemoryPropertyFlagBits::eDeviceLocal)) {
-                typeIndex = i;
-                break;
-            }
-            typeBits >>= 1;
-        }
-        assert(typeIndex != uint32_t(~0));
-        m_DepthMemory = m_Ctx->GetDevice().allocateMemory(vk::MemoryAllocateInfo(memoryRequirements.size, typeIndex));
-
-        m_Ctx->GetDevice().bindImageMemory(m_DepthImage, m_DepthMemory, 0);
+        // Lives as long as the renderer, so it is bump allocated next to the other render targets
+        m_DepthMemory = m_Ctx->GetAllocator().AllocateImage(m_DepthImage, *tiling,
+                                                            vk::MemoryPropertyFlagBits::eDeviceLocal,
+                                                            AllocationStrategy::Linear);
 
         m_DepthImageView = m_Ctx->GetDevice().createImageView(vk::ImageViewCreateInfo(
                 vk::ImageViewCreateFlags(), m_DepthImage, vk::ImageViewType::e2D, m_DepthFormat, {},
                 { vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1 }));
     }
 
+    void Renderer::InitHiZBuffer() {
+        // Level 0 is half the depth buffer, every level keeps the max of the 2x2 texels below it
+        m_HiZSize = glm::max(m_Size / 2u, glm::uvec2(1));
+        m_HiZLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(m_HiZSize.x, m_HiZSize.y)))) + 1;
+
+        // Built on the graphics queue, read by culling on the compute queue
+        vk::ImageCreateInfo imageCreateInfo(
+                vk::ImageCreateFlags(), vk::ImageType::e2D, vk::Format::eR32Sfloat,
+                vk::Extent3D(m_HiZSize.x, m_HiZSize.y, 1), m_HiZLevels, 1, vk::SampleCountFlagBits::e1,
+                vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled);
+        if (m_CullQueueFamilies[0] != m_CullQueueFamilies[1]) {
+            imageCreateInfo.setSharingMode(vk::SharingMode::eConcurrent).setQueueFamilyIndices(m_CullQueueFamilies);
+        }
+
+        for (auto& frame: m_Frames) {
+            frame.hizImage = m_Ctx->GetDevice().createImage(imageCreateInfo);
+            frame.hizMemory = m_Ctx->GetAllocator().AllocateImage(frame.hizImage, vk::ImageTiling::eOptimal,
+                                                                  vk::MemoryPropertyFlagBits::eDeviceLocal,
+                                                                  AllocationStrategy::Linear);
+
+            vk::ImageViewCreateInfo viewCreateInfo({}, frame.hizImage, vk::ImageViewType::e2D,
+                                                   vk::Format::eR32Sfloat, {},
+                                                   { vk::ImageAspectFlagBits::eColor, 0, m_HiZLevels, 0, 1 });
+            frame.hizView = m_Ctx->GetDevice().createImageView(viewCreateInfo);
+            for (uint32_t level = 0; level < m_HiZLevels; ++level) {
+                viewCreateInfo.subresourceRange.setBaseMipLevel(level).setLevelCount(1);
+                frame.hizLevelViews.push_back(m_Ctx->GetDevice().createImageView(viewCreateInfo));
+            }
+        }
+
+        m_HiZSampler = m_Ctx->GetSamplerCache().Get({ .magFilter = vk::Filter::eNearest,
+                                                       .minFilter = vk::Filter::eNearest,
+                                                       .mipmapMode = vk::SamplerMipmapMode::eNearest,
+                                                       .addressMode = vk::SamplerAddressMode::eClampToEdge,
+                                                       .maxAnisotropy = 1.f });
+    }
+
     void Renderer::InitIDBuffer() {
         m_IDTexture = std::make_shared<Texture<uint32_t>>(m_Ctx, m_UploadContext, m_Size,
                                                           vk::Format::eR32Uint,
@@ -189,8 +312,17 @@ namespace Iris::Vulkan {
                                                           vk::ImageUsageFlagBits::eTransferSrc);
     }
 
+    void Renderer::InitGBuffer() {
+        auto usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eInputAttachment |
+                     vk::ImageUsageFlagBits::eTransientAttachment;
+        m_GBufferAlbedo = std::make_unique<Texture<uint8_t>>(m_Ctx, m_UploadContext, m_Size, GBufferAlbedoFormat,
+                                                             usage);
+        m_GBufferNormal = std::make_unique<Texture<uint8_t>>(m_Ctx, m_UploadContext, m_Size, GBufferNormalFormat,
+                                                             usage);
+    }
+
     void Renderer::InitRenderPass() {
-        std::array<vk::AttachmentDescription, 3> attachmentDescriptions;
+        std::array<vk::AttachmentDescription, 5> attachmentDescriptions;
         attachmentDescriptions[0] = vk::AttachmentDescription(vk::AttachmentDescriptionFlags(),
                                                               m_SwapchainFormat,
                                                               vk::SampleCountFlagBits::e1,
@@ -199,16 +331,18 @@ namespace Iris::Vulkan {
                                                               vk::AttachmentLoadOp::eDontCare,
                                                               vk::AttachmentStoreOp::eDontCare,
                                                               vk::ImageLayout::eUndefined,
-                                                              vk::ImageLayout::ePresentSrcKHR);
+                                                              m_Headless ? vk::ImageLayout::eTransferSrcOptimal
+                                                                         : vk::ImageLayout::ePresentSrcKHR);
+        // Stored for the Hi-Z pyramid, culling against discarded depth would drop visible objects
         attachmentDescriptions[1] = vk::AttachmentDescription(vk::AttachmentDescriptionFlags(),
                                                               m_DepthFormat,
                                                               vk::SampleCountFlagBits::e1,
                                                               vk::AttachmentLoadOp::eClear,
-                                                              vk::AttachmentStoreOp::eDontCare,
+                                                              vk::AttachmentStoreOp::eStore,
                                                               vk::AttachmentLoadOp::eDontCare,
                                                               vk::AttachmentStoreOp::eDontCare,
                                                               vk::ImageLayout::eUndefined,
-                                                              vk::ImageLayout::eDepthStencilAttachmentOptimal);
+                                                              DepthFinalLayout);
 
         attachmentDescriptions[2] = vk::AttachmentDescription(vk::AttachmentDescriptionFlags(),
                                                               vk::Format::eR32Uint,
@@ -220,25 +354,88 @@ namespace Iris::Vulkan {
                                                               vk::ImageLayout::eUndefined,
                                                               vk::ImageLayout::eColorAttachmentOptimal);
 
+        // The G-buffer is only read by the lighting subpass, so it never has to leave tile memory
+        for (uint32_t attachment: { 3u, 4u }) {
+            attachmentDescriptions[attachment] = vk::AttachmentDescription(
+                    vk::AttachmentDescriptionFlags(),
+                    attachment == 3 ? GBufferAlbedoFormat : GBufferNormalFormat,
+                    vk::SampleCountFlagBits::e1,
+                    vk::AttachmentLoadOp::eDontCare,
+                    vk::AttachmentStoreOp::eDontCare,
+                    vk::AttachmentLoadOp::eDontCare,
+                    vk::AttachmentStoreOp::eDontCare,
+                    vk::ImageLayout::eUndefined,
+                    vk::ImageLayout::eShaderReadOnlyOptimal);
+        }
+
         vk::AttachmentReference colorReference(0, vk::ImageLayout::eColorAttachmentOptimal);
         vk::AttachmentReference depthReference(1, vk::ImageLayout::eDepthStencilAttachmentOptimal);
         vk::AttachmentReference idReference(2, vk::ImageLayout::eColorAttachmentOptimal);
+        vk::AttachmentReference albedoReference(3, vk::ImageLayout::eColorAttachmentOptimal);
+        vk::AttachmentReference normalReference(4, vk::ImageLayout::eColorAttachmentOptimal);
+        vk::AttachmentReference depthReadReference(1, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+
+        // Subpass 0 draws the geometry, shaded (forward) or into the G-buffer (deferred). Subpass 1 runs the
+        // deferred lighting, then draws the billboards and the UI in both modes.
+        std::array<vk::AttachmentReference, 4> geometryAttachments = {
+                colorReference, idReference, albedoReference, normalReference };
+        std::array<vk::AttachmentReference, 2> lightingAttachments = { colorReference, idReference };
+        std::array<vk::AttachmentReference, 3> gbufferInputs = {
+                vk::AttachmentReference(3, vk::ImageLayout::eShaderReadOnlyOptimal),
+                vk::AttachmentReference(4, vk::ImageLayout::eShaderReadOnlyOptimal),
+                depthReadReference };
+
+        std::array<vk::SubpassDescription, 2> subpasses = {
+                vk::SubpassDescription(vk::SubpassDescriptionFlags(), vk::PipelineBindPoint::eGraphics, {},
+                                       geometryAttachments, {}, &depthReference),
+                vk::SubpassDescription(vk::SubpassDescriptionFlags(), vk::PipelineBindPoint::eGraphics,
+                                       gbufferInputs, lightingAttachments, {}, &depthReadReference)
+        };
 
-        std::array<vk::AttachmentReference, 2> colorAttachments = { colorReference, idReference };
-
-        vk::SubpassDescription subpass(vk::SubpassDescriptionFlags(), vk::PipelineBindPoint::eGraphics, {},
-                                       colorAttachments, {}, &depthReference);
+        // Depth and ID attachments are shared by all frames in flight, so a frame must not start writing them
+        // before the previous one is done, including the previous frame's Hi-Z build reading the depth. This also
+        // makes the swapchain image layout transition wait for the acquire semaphore.
+        auto attachmentStages = vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                                vk::PipelineStageFlagBits::eEarlyFragmentTests |
+                                vk::PipelineStageFlagBits::eLateFragmentTests;
+        auto attachmentAccess = vk::AccessFlagBits::eColorAttachmentWrite |
+                                vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+        std::vector<vk::SubpassDependency> dependencies;
+        dependencies.emplace_back(VK_SUBPASS_EXTERNAL, 0,
+                                  attachmentStages | vk::PipelineStageFlagBits::eFragmentShader |
+                                  vk::PipelineStageFlagBits::eComputeShader, attachmentStages,
+                                  attachmentAccess, attachmentAccess);
+        // The lighting reads the G-buffer and depth of the same pixel only, so tilers can keep it on chip
+        dependencies.emplace_back(0, 1,
+                                  attachmentStages,
+                                  attachmentStages | vk::PipelineStageFlagBits::eFragmentShader,
+                                  attachmentAccess,
+                                  vk::AccessFlagBits::eInputAttachmentRead | vk::AccessFlagBits::eColorAttachmentRead |
+                                  vk::AccessFlagBits::eColorAttachmentWrite |
+                                  vk::AccessFlagBits::eDepthStencilAttachmentRead,
+                                  vk::DependencyFlagBits::eByRegion);
+        if (m_Headless) {
+            // the offscreen color target is copied to the readback buffer right after the pass
+            dependencies.emplace_back(1, VK_SUBPASS_EXTERNAL,
+                                      vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                      vk::PipelineStageFlagBits::eTransfer,
+                                      vk::AccessFlagBits::eColorAttachmentWrite,
+                                      vk::AccessFlagBits::eTransferRead);
+        }
 
         m_MainRenderPass = m_Ctx->GetDevice().createRenderPass(
-                vk::RenderPassCreateInfo(vk::RenderPassCreateFlags(), attachmentDescriptions, subpass));
+                vk::RenderPassCreateInfo(vk::RenderPassCreateFlags(), attachmentDescriptions, subpasses,
+                                         dependencies));
     }
 
     void Renderer::InitFramebuffers() {
         m_Framebuffers.reserve(m_SwapchainImageViews.size());
 
-        std::array<vk::ImageView, 3> attachments;
+        std::array<vk::ImageView, 5> attachments;
         attachments[1] = m_DepthImageView;
         attachments[2] = m_IDTexture->GetDescriptor().imageView;
+        attachments[3] = m_GBufferAlbedo->GetDescriptor().imageView;
+        attachments[4] = m_GBufferNormal->GetDescriptor().imageView;
 
         auto framebuffer_info = vk::FramebufferCreateInfo(vk::FramebufferCreateFlags(), m_MainRenderPass, attachments,
                                                           m_SwapchainExtent.width, m_SwapchainExtent.height, 1);
@@ -250,156 +447,730 @@ namespace Iris::Vulkan {
     }
 
     void Renderer::InitCommandBuffers() {
-        m_CommandPool = m_Ctx->GetDevice()
-                .createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-                                                             m_Ctx->GetGraphicsQueueFamilyIndex()));
-        m_CommandBuffer = m_Ctx->GetDevice().allocateCommandBuffers(
-                vk::CommandBufferAllocateInfo(m_CommandPool, vk::CommandBufferLevel::ePrimary, 1)).front();
+        for (auto& frame: m_Frames) {
+            frame.commandPool = m_Ctx->GetDevice()
+                    .createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient,
+                                                                 m_Ctx->GetGraphicsQueueFamilyIndex()));
+            frame.commandBuffer = m_Ctx->GetDevice().allocateCommandBuffers(
+                    vk::CommandBufferAllocateInfo(frame.commandPool, vk::CommandBufferLevel::ePrimary, 1)).front();
+
+            frame.computeCommandPool = m_Ctx->GetDevice()
+                    .createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient,
+                                                                 m_Ctx->GetComputeQueueFamilyIndex()));
+            frame.computeCommandBuffer = m_Ctx->GetDevice().allocateCommandBuffers(
+                    vk::CommandBufferAllocateInfo(frame.computeCommandPool, vk::CommandBufferLevel::ePrimary,
+                                                  1)).front();
+        }
     }
 
     void Renderer::InitSyncStructures() {
-        m_RenderFence = m_Ctx->GetDevice().createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled));
-        m_PresentSemaphore = m_Ctx->GetDevice().createSemaphore(vk::SemaphoreCreateInfo());
-        m_RenderSemaphore = m_Ctx->GetDevice().createSemaphore(vk::SemaphoreCreateInfo());
+        for (auto& frame: m_Frames) {
+            frame.renderFence = m_Ctx->GetDevice()
+                    .createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled));
+            frame.presentSemaphore = m_Ctx->GetDevice().createSemaphore(vk::SemaphoreCreateInfo());
+            frame.renderSemaphore = m_Ctx->GetDevice().createSemaphore(vk::SemaphoreCreateInfo());
+        }
+
+        // Both count frames: culling of frame N signals N + 1, and so does rendering it
+        vk::SemaphoreTypeCreateInfo timelineCreateInfo(vk::SemaphoreType::eTimeline, 0);
+        m_ComputeTimeline = m_Ctx->GetDevice().createSemaphore(vk::SemaphoreCreateInfo().setPNext(&timelineCreateInfo));
+        m_GraphicsTimeline = m_Ctx->GetDevice().createSemaphore(vk::SemaphoreCreateInfo().setPNext(&timelineCreateInfo));
     }
 
     void Renderer::InitUniformBuffer() {
-        m_CameraDataBuffer = std::make_unique<Buffer<CameraData>>(
-                m_Ctx, vk::BufferUsageFlagBits::eUniformBuffer, CameraData{});
-        m_LightDataBuffer = std::make_unique<Buffer<LightData>>(
-                m_Ctx, vk::BufferUsageFlagBits::eUniformBuffer, LightData{});
-        m_LightStorageBuffer = std::make_unique<Buffer<Light>>(
-                m_Ctx, vk::BufferUsageFlagBits::eStorageBuffer, 500u);
+        m_TransientArena = std::make_unique<TransientArena>(m_Ctx, static_cast<uint32_t>(m_Frames.size()));
     }
 
     void Renderer::InitPipelines() {
-        m_PipelineBuilder = std::make_unique<PipelineBuilder>(m_Ctx->GetDevice());
-
-        auto shaderStagesVF = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
-
-        m_PipelineBuilder->SetVertexInputAttributes(
-                        vk::VertexInputBindingDescription(0, sizeof(Vertex)),
-                        parseVertexDescription(Vertex::GetDescription(), 0))
-                .AddVertexShader("./Shaders/UberShader.vert.spv")
-                .AddFragmentShader("./Shaders/UberShader.frag.spv")
-                .AddPushConstant(shaderStagesVF, sizeof(PushConstants))
-                .AddUniform(0, 0, shaderStagesVF)                            // camera data
-                .AddUniform(0, 1, shaderStagesVF)                            // light meta
-                .AddStorageBuffer(0, 2, shaderStagesVF)                            // light array
-                .AddImage(1, 0, vk::ShaderStageFlagBits::eFragment, 1024);   // textures
-        m_Pipeline = m_PipelineBuilder->Build(m_MainRenderPass);
+        m_PipelineBuilder = std::make_unique<PipelineBuilder>(m_Ctx->GetDevice(), m_Ctx->GetPipelineCache());
+
+        m_Pipeline = BuildUberPipeline(ShadingPass::Forward, AllFeatures);
+        m_LightingPipeline = BuildUberPipeline(ShadingPass::Lighting, AllFeatures & ~MaterialFeatures);
 
+        // Vertex stage only, reads the geometry pool's position stream
+        m_PipelineBuilder->Clear()
+                .AddVertexShader("./Shaders/Depth.vert.spv")
+                .SetDynamic(0, 0)                                            // camera data
+                .SetColorOutputs({ PipelineBuilder::ColorOutput::Unused, PipelineBuilder::ColorOutput::Unused,
+                                   PipelineBuilder::ColorOutput::Unused, PipelineBuilder::ColorOutput::Unused })
+                .ShareDescriptorSets(*m_Pipeline);
+        m_DepthPipeline = m_PipelineBuilder->Build(m_MainRenderPass, m_Frames.size());
+
+        // Drawn after the lighting, where depth is only tested
         m_PipelineBuilder->Clear()
                 .AddVertexShader("./Shaders/Billboard.vert.spv")
                 .AddFragmentShader("./Shaders/Billboard.frag.spv")
-                .AddPushConstant(shaderStagesVF, sizeof(PushConstants))
-                .AddUniform(0, 0, shaderStagesVF)                            // camera data
-                .AddImage(1, 0, vk::ShaderStageFlagBits::eFragment, 1024);   // textures
-        m_BillboardPipeline = m_PipelineBuilder->Build(m_MainRenderPass);
-
-        m_Pipeline->UpdateBuffer(0, 0, m_CameraDataBuffer->GetDescriptorBufferInfo());
-        m_Pipeline->UpdateBuffer(0, 1, m_LightDataBuffer->GetDescriptorBufferInfo());
-        m_Pipeline->UpdateBuffer(0, 2, m_LightStorageBuffer->GetDescriptorBufferInfo());
-        m_BillboardPipeline->UpdateBuffer(0, 0, m_CameraDataBuffer->GetDescriptorBufferInfo());
+                .SetDynamic(0, 0)                                            // camera data
+                .SetArraySize(1, 0, MaxTextures)                             // icons
+                .SetSubpass(1)
+                .SetDepth(true, false);
+        m_BillboardPipeline = m_PipelineBuilder->Build(m_MainRenderPass, m_Frames.size());
+
+        m_PipelineBuilder->Clear()
+                .AddComputeShader("./Shaders/HiZ.comp.spv");
+        m_HiZPipeline = m_PipelineBuilder->BuildCompute(m_HiZLevels * static_cast<uint32_t>(m_Frames.size()));
+
+        // Compaction uses a subset of the culling bindings, sharing the sets means a frame's buffers are
+        // written and bound once for both stages
+        m_PipelineBuilder->Clear()
+                .AddComputeShader("./Shaders/Cull.comp.spv")
+                .SetDynamic(0, 0);                                           // cull data
+        m_CullPipeline = m_PipelineBuilder->BuildCompute(m_Frames.size());
+        for (bool ordered: { false, true }) {
+            m_PipelineBuilder->Clear()
+                    .AddComputeShader("./Shaders/CullCompact.comp.spv")
+                    .SetDynamic(0, 0)
+                    .SetSpecialization(0, ordered)
+                    .ShareDescriptorSets(*m_CullPipeline);
+            (ordered ? m_OrderedCompactPipeline : m_CompactPipeline) = m_PipelineBuilder->BuildCompute(
+                    m_Frames.size());
+        }
+        m_PipelineBuilder->Clear()
+                .AddComputeShader("./Shaders/LightCull.comp.spv")
+                .SetDynamic(0, 0)                                            // camera data
+                .SetDynamic(0, 1)                                            // light meta
+                .SetDynamic(0, 2);                                           // light array
+        m_LightCullPipeline = m_PipelineBuilder->BuildCompute(m_Frames.size());
+        m_Ctx->GetPipelineCache().LogStats();
+        Log::Core::Info("Pipelines share {} set layouts and {} pipeline layouts",
+                        m_PipelineBuilder->GetSetLayoutCount(), m_PipelineBuilder->GetPipelineLayoutCount());
+
+        // Every frame binds the same arena buffer, its slice is picked with dynamic offsets
+        m_Pipeline->UpdateBuffer(0, 0, m_TransientArena->GetDescriptorBufferInfo(sizeof(CameraData)));
+        m_Pipeline->UpdateBuffer(0, 1, m_TransientArena->GetDescriptorBufferInfo(sizeof(LightData)));
+        m_Pipeline->UpdateBuffer(0, 2, m_TransientArena->GetDescriptorBufferInfo(sizeof(Light) * MaxLights));
+        m_BillboardPipeline->UpdateBuffer(0, 0, m_TransientArena->GetDescriptorBufferInfo(sizeof(CameraData)));
+
+        m_LightCullPipeline->UpdateBuffer(0, 0, m_TransientArena->GetDescriptorBufferInfo(sizeof(CameraData)));
+        m_LightCullPipeline->UpdateBuffer(0, 1, m_TransientArena->GetDescriptorBufferInfo(sizeof(LightData)));
+        m_LightCullPipeline->UpdateBuffer(0, 2, m_TransientArena->GetDescriptorBufferInfo(sizeof(Light) * MaxLights));
+
+        m_LightingPipeline->UpdateImage(2, 0, vk::DescriptorImageInfo({}, m_GBufferAlbedo->GetDescriptor().imageView,
+                                                                      vk::ImageLayout::eShaderReadOnlyOptimal));
+        m_LightingPipeline->UpdateImage(2, 1, vk::DescriptorImageInfo({}, m_GBufferNormal->GetDescriptor().imageView,
+                                                                      vk::ImageLayout::eShaderReadOnlyOptimal));
+        m_LightingPipeline->UpdateImage(2, 2, vk::DescriptorImageInfo({}, m_DepthImageView,
+                                                                      vk::ImageLayout::eDepthStencilReadOnlyOptimal));
+
+        m_CullPipeline->UpdateBuffer(0, 0, m_TransientArena->GetDescriptorBufferInfo(sizeof(CullData)));
+
+        for (uint32_t i = 0; i < m_Frames.size(); ++i) {
+            auto& frame = m_Frames[i];
+            frame.clusterBuffer = std::make_unique<Buffer<uint32_t>>(m_Ctx, vk::BufferUsageFlagBits::eStorageBuffer,
+                                                                     ClusterCount * ClusterStride,
+                                                                     m_CullQueueFamilies);
+            m_Pipeline->UpdateFrameBuffer(i, 0, 5, frame.clusterBuffer->GetDescriptorBufferInfo());
+            m_LightCullPipeline->UpdateFrameBuffer(i, 0, 5, frame.clusterBuffer->GetDescriptorBufferInfo());
+            m_CullPipeline->UpdateFrameImage(i, 0, 5, vk::DescriptorImageInfo(m_HiZSampler, frame.hizView,
+                                                                              vk::ImageLayout::eGeneral));
+
+            // Level 0 reduces the depth buffer, every other level the one before it
+            for (uint32_t level = 0; level < m_HiZLevels; ++level) {
+                vk::DescriptorImageInfo src = level == 0
+                        ? vk::DescriptorImageInfo(m_HiZSampler, m_DepthImageView,
+                                                  vk::ImageLayout::eDepthStencilReadOnlyOptimal)
+                        : vk::DescriptorImageInfo(m_HiZSampler, frame.hizLevelViews[level - 1],
+                                                  vk::ImageLayout::eGeneral);
+                m_HiZPipeline->UpdateFrameImage(i * m_HiZLevels + level, 0, 0, src);
+                m_HiZPipeline->UpdateFrameImage(i * m_HiZLevels + level, 0, 1,
+                                                vk::DescriptorImageInfo({}, frame.hizLevelViews[level],
+                                                                        vk::ImageLayout::eGeneral));
+            }
+        }
+
+        for (uint32_t i = 0; i < m_Frames.size(); ++i) {
+            ReserveInstances(i, 1024);
+        }
+    }
+
+    std::unique_ptr<PipelineBuilder::Pipeline> Renderer::BuildUberPipeline(ShadingPass pass, uint32_t features,
+                                                                           bool depthEqual) {
+        using Output = PipelineBuilder::ColorOutput;
+
+        // Bindings come from the shaders, only dynamic offsets and runtime array sizes are given here. The
+        // vertex buffer layout is the Vertex struct's. Outputs are color, ID and the two G-buffer targets.
+        m_PipelineBuilder->Clear();
+        if (pass == ShadingPass::Lighting) {
+            m_PipelineBuilder->AddVertexShader("./Shaders/Fullscreen.vert.spv")
+                    .AddFragmentShader("./Shaders/Lighting.frag.spv")
+                    .SetSubpass(1)
+                    .SetColorOutputs({ Output::Opaque, Output::Unused })
+                    .SetDepth(false, false);
+        } else {
+            bool forward = pass == ShadingPass::Forward;
+            m_PipelineBuilder->SetVertexInputAttributes(
+                            vk::VertexInputBindingDescription(0, sizeof(Vertex)),
+                            parseVertexDescription(Vertex::GetDescription(), 0))
+                    .AddVertexShader("./Shaders/UberShader.vert.spv")
+                    .AddFragmentShader(forward ? "./Shaders/UberShader.frag.spv" : "./Shaders/GBuffer.frag.spv")
+                    .SetColorOutputs(forward ? std::vector{ Output::Blended, Output::Opaque, Output::Unused,
+                                                            Output::Unused }
+                                             : std::vector{ Output::Unused, Output::Opaque, Output::Opaque,
+                                                            Output::Opaque });
+            if (depthEqual) m_PipelineBuilder->SetDepth(true, false, vk::CompareOp::eEqual);
+        }
+        m_PipelineBuilder->SetDynamic(0, 0)                                 // camera data
+                .SetDynamic(0, 1)                                            // light meta
+                .SetDynamic(0, 2)                                            // light array
+                .SetArraySize(1, 0, MaxTextures);                            // textures
+        for (uint32_t bit = 0; (AllFeatures >> bit) != 0; ++bit) {
+            m_PipelineBuilder->SetSpecialization(bit, (features >> bit) & 1);
+        }
+
+        // Everything shares the forward pipeline's sets, lighting variants also the G-buffer inputs of the first
+        const auto* shared = pass == ShadingPass::Lighting && m_LightingPipeline ? m_LightingPipeline.get()
+                                                                                : m_Pipeline.get();
+        if (shared) m_PipelineBuilder->ShareDescriptorSets(*shared);
+        return m_PipelineBuilder->Build(m_MainRenderPass, m_Frames.size());
+    }
+
+    const PipelineBuilder::Pipeline& Renderer::GetUberPipeline(ShadingPass pass, uint32_t features) {
+        // The G-buffer doesn't depend on the lights, the lighting not on the material
+        if (pass == ShadingPass::GBuffer) features &= MaterialFeatures;
+        if (pass == ShadingPass::Lighting) features &= ~MaterialFeatures;
+        if (pass == ShadingPass::Forward && features == AllFeatures) return *m_Pipeline;
+        if (pass == ShadingPass::Lighting && features == (AllFeatures & ~MaterialFeatures)) return *m_LightingPipeline;
+
+        // Alpha tested surfaces aren't in the depth prepass, their fragment shader decides about coverage
+        bool depthEqual = m_DepthPrepass && pass != ShadingPass::Lighting && !(features & AlphaTest);
+
+        // Usually a pipeline cache hit after the first run, so building on first use only costs a lookup
+        auto& pipeline = m_UberPipelines[(static_cast<uint32_t>(pass) << 1 | depthEqual) << 8 | features];
+        if (!pipeline) {
+            pipeline = BuildUberPipeline(pass, features, depthEqual);
+            Log::Core::Info("Built uber shader variant {}:{:05b}{} ({} variants)", static_cast<uint32_t>(pass),
+                            features, depthEqual ? " depth equal" : "", m_UberPipelines.size() + 2);
+        }
+        return *pipeline;
+    }
+
+    void Renderer::ReserveInstances(uint32_t frameIndex, size_t count) {
+        auto& frame = m_Frames[frameIndex];
+        count = std::max<size_t>(count, 1);
+        auto storage = vk::BufferUsageFlagBits::eStorageBuffer;
+        auto indirect = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer;
+        // The compaction stage shares the culling descriptor sets
+        auto updateCull = [&](uint32_t binding, vk::DescriptorBufferInfo info) {
+            m_CullPipeline->UpdateFrameBuffer(frameIndex, 0, binding, info);
+        };
+
+        if (ReserveMapped(m_Ctx, frame.instanceBuffer, frame.instanceData, count, storage, m_CullQueueFamilies)) {
+            m_Pipeline->UpdateFrameBuffer(frameIndex, 0, 3, frame.instanceBuffer->GetDescriptorBufferInfo());
+            m_BillboardPipeline->UpdateFrameBuffer(frameIndex, 0, 3, frame.instanceBuffer->GetDescriptorBufferInfo());
+            updateCull(1, frame.instanceBuffer->GetDescriptorBufferInfo());
+        }
+        if (ReserveMapped(m_Ctx, frame.drawBoundsBuffer, frame.drawBounds, count, storage, m_CullQueueFamilies)) {
+            updateCull(2, frame.drawBoundsBuffer->GetDescriptorBufferInfo());
+        }
+        if (ReserveMapped(m_Ctx, frame.indirectBuffer, frame.indirectCommands, count, storage,
+                          m_CullQueueFamilies)) {
+            updateCull(3, frame.indirectBuffer->GetDescriptorBufferInfo());
+        }
+        if (ReserveMapped(m_Ctx, frame.visibleBuffer, frame.visibleInstances, count, storage,
+                          m_CullQueueFamilies)) {
+            m_Pipeline->UpdateFrameBuffer(frameIndex, 0, 4, frame.visibleBuffer->GetDescriptorBufferInfo());
+            updateCull(4, frame.visibleBuffer->GetDescriptorBufferInfo());
+        }
+        if (ReserveMapped(m_Ctx, frame.compactedBuffer, frame.compactedCommands, count, indirect,
+                          m_CullQueueFamilies)) {
+            updateCull(6, frame.compactedBuffer->GetDescriptorBufferInfo());
+        }
+        if (ReserveMapped(m_Ctx, frame.visibleDrawCountBuffer, frame.visibleDrawCount, BucketCount, indirect,
+                          m_CullQueueFamilies)) {
+            updateCull(7, frame.visibleDrawCountBuffer->GetDescriptorBufferInfo());
+        }
+    }
+
+    void Renderer::RecordCulling(FrameData& frame, uint32_t cullOffset, uint32_t instanceCount,
+                                 uint32_t drawCount, const std::array<uint32_t, 3>& lightOffsets) {
+        auto& cmdBuf = frame.computeCommandBuffer;
+        cmdBuf.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        // Until this slot's first frame has rendered there is no pyramid to test against, occlusion culling is
+        // off then but the descriptor still has to be in the layout it was written with
+        if (m_FrameNr < m_Frames.size()) {
+            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader,
+                                   {}, {}, {},
+                                   vk::ImageMemoryBarrier({}, vk::AccessFlagBits::eShaderRead,
+                                                          vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                                          VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                                          frame.hizImage,
+                                                          { vk::ImageAspectFlagBits::eColor, 0, m_HiZLevels, 0, 1 }));
+        }
+
+        cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, m_CullPipeline->pipeline);
+        cmdBuf.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_CullPipeline->pipelineLayout, 0,
+                                  m_CullPipeline->descriptorSets[m_FrameIndex], cullOffset);
+        cmdBuf.dispatch((instanceCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+        // Compaction reads the instance counts the culling stage accumulated
+        cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+                               {}, vk::MemoryBarrier(vk::AccessFlagBits::eShaderWrite,
+                                                     vk::AccessFlagBits::eShaderRead), {}, {});
+
+        // Same pipeline layout and sets as culling, so they stay bound. The front to back order only pays off
+        // with the depth prepass, keeping it takes a single workgroup, without it every draw gets an invocation.
+        if (m_DepthPrepass) {
+            cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, m_OrderedCompactPipeline->pipeline);
+            if (drawCount > 0) cmdBuf.dispatch(1, 1, 1);
+        } else {
+            cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, m_CompactPipeline->pipeline);
+            cmdBuf.dispatch((drawCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+        }
+
+        // One invocation per cluster, read by the fragment shader once the graphics submission waited on this one
+        cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, m_LightCullPipeline->pipeline);
+        cmdBuf.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_LightCullPipeline->pipelineLayout, 0,
+                                  m_LightCullPipeline->descriptorSets[m_FrameIndex], lightOffsets);
+        cmdBuf.dispatch((ClusterCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+        // The visible draw count is also shown in the UI once the frame's fence has signaled
+        cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eHost, {},
+                               vk::MemoryBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eHostRead),
+                               {}, {});
+        cmdBuf.end();
+    }
+
+    void Renderer::RecordHiZ(FrameData& frame) {
+        // Recorded right after the main pass, which wrote the depth. This frame's culling read the pyramid
+        // before (the submission waits on it). Every level is rewritten, so the old contents can be discarded.
+        auto& cmdBuf = frame.commandBuffer;
+        std::array<vk::ImageMemoryBarrier, 2> barriers = {
+                vk::ImageMemoryBarrier(vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+                                       vk::AccessFlagBits::eShaderRead, DepthFinalLayout,
+                                       vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+                                       VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, m_DepthImage,
+                                       { vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1 }),
+                vk::ImageMemoryBarrier({}, vk::AccessFlagBits::eShaderWrite,
+                                       vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                       VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, frame.hizImage,
+                                       { vk::ImageAspectFlagBits::eColor, 0, m_HiZLevels, 0, 1 })
+        };
+        cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eEarlyFragmentTests |
+                               vk::PipelineStageFlagBits::eLateFragmentTests |
+                               vk::PipelineStageFlagBits::eComputeShader,
+                               vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, barriers);
+
+        cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, m_HiZPipeline->pipeline);
+        for (uint32_t level = 0; level < m_HiZLevels; ++level) {
+            glm::uvec2 size = glm::max(m_HiZSize >> level, glm::uvec2(1));
+            cmdBuf.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_HiZPipeline->pipelineLayout, 0,
+                                      m_HiZPipeline->descriptorSets[m_FrameIndex * m_HiZLevels + level], {});
+            cmdBuf.dispatch((size.x + HiZGroupSize - 1) / HiZGroupSize, (size.y + HiZGroupSize - 1) / HiZGroupSize, 1);
+
+            // The next level reads what was just written, culling on the compute queue waits on the semaphore
+            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                   vk::PipelineStageFlagBits::eComputeShader, {}, {}, {},
+                                   vk::ImageMemoryBarrier(vk::AccessFlagBits::eShaderWrite,
+                                                          vk::AccessFlagBits::eShaderRead,
+                                                          vk::ImageLayout::eGeneral, vk::ImageLayout::eGeneral,
+                                                          VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                                          frame.hizImage,
+                                                          { vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 }));
+        }
     }
 
     void Renderer::Render(const Camera& camera) {
-        while (vk::Result::eTimeout == m_Ctx->GetDevice().waitForFences(m_RenderFence, VK_TRUE, 100000000));
-        VkCheck(m_Ctx->GetDevice().resetFences(1, &m_RenderFence), "Reset Draw Fence");
+        auto& frame = m_Frames[m_FrameIndex];
+        auto& cmdBuf = frame.commandBuffer;
+
+        m_FrameStats.BeginFrame();
+        m_FrameStats.BeginWait();
+        while (vk::Result::eTimeout == m_Ctx->GetDevice().waitForFences(frame.renderFence, VK_TRUE, 100000000));
+        m_FrameStats.EndWait();
+        EmitReadback(frame);
+        if (frame.visibleDrawCount) {
+            m_VisibleDraws = std::accumulate(frame.visibleDrawCount, frame.visibleDrawCount + BucketCount, 0u);
+        }
 
-        auto* cameraData = m_CameraDataBuffer->Map();
-        cameraData->position = glm::vec4(camera.GetPosition(), 1.f);
-        cameraData->view = camera.GetViewMatrix();
-        cameraData->projection = camera.GetProjectionMatrix();
-        cameraData->viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
-        m_CameraDataBuffer->Unmap();
+        // Meshes and textures nobody references anymore, once no submitted frame can still read them. This
+        // frame's descriptor copy is idle now, so swapped textures can be pointed at their new image first.
+        WriteTextureSwaps();
+        uint64_t completedFrame = m_Ctx->GetDevice().getSemaphoreCounterValue(m_GraphicsTimeline);
+        m_Meshes.Collect(completedFrame);
+        // Evicted slots may still be listed for another frame's descriptor copy
+        m_Textures.Collect(completedFrame, [&](uint32_t slot) {
+            m_TextureStreamer->Untrack(slot);
+            for (auto& swaps: m_TextureSwaps) std::erase(swaps, slot);
+        });
+        VkCheck(m_Ctx->GetDevice().resetFences(1, &frame.renderFence), "Reset Draw Fence");
+        m_Ctx->GetDevice().resetCommandPool(frame.commandPool);
+        m_Ctx->GetDevice().resetCommandPool(frame.computeCommandPool);
+
+        m_TransientArena->BeginFrame(m_FrameIndex);
+
+        auto cameraData = m_TransientArena->Allocate<CameraData>();
+        cameraData.data->position = glm::vec4(camera.GetPosition(), 1.f);
+        cameraData.data->view = camera.GetViewMatrix();
+        cameraData.data->projection = camera.GetProjectionMatrix();
+        cameraData.data->viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+        cameraData.data->inverseViewProjection = glm::inverse(cameraData.data->viewProjection);
+
+        uint32_t count = glm::min(static_cast<uint32_t>(m_Lights.size()), MaxLights);
+
+        // The whole descriptor range is allocated so the dynamic offset always stays inside the buffer
+        auto lightSlice = m_TransientArena->Allocate<Light>(MaxLights);
+        auto* lights = lightSlice.data;
+
+        // Directional lights first, the clustered point and spot lights after them. Only the light types present
+        // get a path in this frame's shader variants.
+        uint32_t directionalCount = 0;
+        uint32_t lightFeatures = 0;
+        for (bool directional: { true, false }) {
+            for (uint32_t i = 0, slot = directional ? 0 : directionalCount; i < count; ++i) {
+                auto& entity = m_Scene->GetEntity(m_Lights[i]);
+                auto& light = entity.GetComponent<Iris::Light>();
+                if ((light.type == LightType::DIRECTIONAL) != directional) continue;
+                lightFeatures |= PointLights << static_cast<uint32_t>(light.type);
+
+                // Range where the attenuation 1 / (d + 1)^2 of the brightest channel drops below 1/256
+                float range = 16.f * glm::sqrt(glm::max(glm::max(light.color.r, light.color.g), light.color.b)) - 1.f;
+                lights[slot].position = glm::vec4(entity.GetTransform().GetTranslation(), glm::max(range, 0.01f));
+                lights[slot].rotation = glm::vec4(glm::radians(entity.GetTransform().GetRotation()), 1.f);
+                lights[slot].color = glm::vec4(light.color, 1.f);
+                lights[slot].flags.x = static_cast<uint32_t>(light.type);
+                ++slot;
+                if (directional) ++directionalCount;
+            }
+        }
 
-        uint32_t count = glm::min(static_cast<uint32_t>(m_Lights.size()), 50u);
+        auto lightData = m_TransientArena->Allocate<LightData>();
+        lightData.data->lightCount = count;
+        lightData.data->directionalCount = directionalCount;
+        lightData.data->zNear = camera.GetNearClip();
+        lightData.data->zFar = camera.GetFarClip();
+        lightData.data->screenSize = glm::vec2(m_Size);
+        lightData.data->projectionScale = { cameraData.data->projection[0][0], cameraData.data->projection[1][1] };
+
+        // Instances are sorted so every (mesh, material) group is a contiguous range and the groups of a draw
+        // bucket are next to each other, lights follow the meshes
+        if (m_RenderablesDirty) {
+            std::stable_sort(m_Renderables.begin(), m_Renderables.end(), [](const auto& a, const auto& b) {
+                return std::tie(a.features, a.mesh, a.texture) < std::tie(b.features, b.mesh, b.texture);
+            });
+            m_RenderablesDirty = false;
+        }
 
-        auto* lightData = m_LightDataBuffer->Map();
-        lightData->lightCount = count;
-        m_LightDataBuffer->Unmap();
+        ReserveInstances(m_FrameIndex, m_Renderables.size() + m_Lights.size());
+        auto* instances = frame.instanceData;
+
+        // Picks up transforms edited outside of Scene::Update, e.g. by the gizmo
+        m_Scene->UpdateTransforms();
+        auto worldMatrices = m_Scene->GetWorldMatrices();
+        auto normalMatrices = m_Scene->GetWorldNormalMatrices();
+
+        // Every (mesh, material) group gets a sort key of its bucket (the pipeline), the view depth of its nearest
+        // instance, its material and its mesh, so every bucket is drawn front to back
+        const auto& view = cameraData.data->view;
+        glm::vec4 depthRow = -glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+        float depthScale = static_cast<float>((1u << DepthKeyBits) - 1) / camera.GetFarClip();
+        m_DrawGroups.clear();
+        m_DrawKeys.clear();
+        for (uint32_t first = 0; first < m_Renderables.size();) {
+            const auto& renderable = m_Renderables[first];
+            const auto& bounds = m_Meshes[renderable.mesh].GetBounds();
+            float nearest = std::numeric_limits<float>::max();
+            uint32_t last = first;
+            for (; last < m_Renderables.size() && m_Renderables[last].mesh == renderable.mesh &&
+                   m_Renderables[last].texture == renderable.texture; ++last) {
+                const auto& world = worldMatrices[m_Renderables[last].entity];
+                float scale = glm::sqrt(glm::max(glm::max(glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+                                                          glm::dot(glm::vec3(world[1]), glm::vec3(world[1]))),
+                                                 glm::dot(glm::vec3(world[2]), glm::vec3(world[2]))));
+                float depth = glm::dot(depthRow, world * glm::vec4(bounds.center, 1.f)) - bounds.radius * scale;
+                nearest = glm::min(nearest, depth);
+            }
 
-        auto* lights = m_LightStorageBuffer->Map();
+            auto depthKey = static_cast<uint64_t>(glm::clamp(nearest * depthScale, 0.f,
+                                                             static_cast<float>((1u << DepthKeyBits) - 1)));
+            uint64_t key = static_cast<uint64_t>(renderable.features) << 62 | depthKey << 32 |
+                           static_cast<uint64_t>(renderable.texture & 0xffff) << 16 | (renderable.mesh & 0xffff);
+            m_DrawKeys.push_back({ key, static_cast<uint32_t>(m_DrawGroups.size()) });
+            m_DrawGroups.emplace_back(first, last);
+            first = last;
+        }
+        RadixSort(m_DrawKeys, m_DrawKeysScratch);
+
+        // One indirect command per group in key order, the culling pass fills in the instance counts
+        uint32_t drawCount = 0;
+        glm::uvec4 bucketEnds{ 0 };
+        m_RenderableDraws.resize(m_Renderables.size());
+        for (const auto& item: m_DrawKeys) {
+            auto [first, last] = m_DrawGroups[item.value];
+            const auto& mesh = m_Meshes[m_Renderables[first].mesh];
+            frame.indirectCommands[drawCount] = mesh.GetDrawCommand(0, first);
+            frame.drawBounds[drawCount] = glm::vec4(mesh.GetBounds().center, mesh.GetBounds().radius);
+            std::fill(m_RenderableDraws.begin() + first, m_RenderableDraws.begin() + last, drawCount);
+            ++drawCount;
+            bucketEnds[m_Renderables[first].features] = drawCount;
+        }
+        for (uint32_t bucket = 1; bucket < BucketCount; ++bucket) {
+            bucketEnds[bucket] = glm::max(bucketEnds[bucket], bucketEnds[bucket - 1]);   // empty buckets
+        }
 
-        for (uint32_t i = 0; i < count; ++i) {
-            auto& entity = m_Scene->GetEntity(m_Lights[i]);
-            auto& light = entity.GetComponent<Iris::Light>();
+        // Every instance is written independently, so the copy is spread over all cores
+        JobSystem::Get().ParallelFor("Instance data", m_Renderables.size(), 1024, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                instances[i] = InstanceData{
+                        .modelMat = worldMatrices[m_Renderables[i].entity],
+                        .normalMat = normalMatrices[m_Renderables[i].entity],
+                        .objectID = static_cast<uint32_t>(m_Renderables[i].entity),
+                        .textureID = m_Renderables[i].texture,
+                        .drawID = m_RenderableDraws[i]
+                };
+            }
+        });
+        instances += m_Renderables.size();
+        std::fill_n(frame.visibleDrawCount, BucketCount, 0u);
+        m_TotalDraws = drawCount;
+
+        auto cullData = m_TransientArena->Allocate<CullData>();
+        cullData.data->viewProjection = cameraData.data->viewProjection;
+        cullData.data->prevViewProjection = frame.hizViewProjection;
+        auto planes = Math::ExtractFrustumPlanes(cameraData.data->viewProjection);
+        std::copy(planes.begin(), planes.end(), cullData.data->frustum);
+        cullData.data->hizSize = glm::vec2(m_HiZSize);
+        cullData.data->instanceCount = static_cast<uint32_t>(m_Renderables.size());
+        cullData.data->drawCount = drawCount;
+        cullData.data->occlusion = m_FrameNr >= m_Frames.size();   // this slot's pyramid has been built
+        cullData.data->bucketEnds = bucketEnds;
+        frame.hizViewProjection = cameraData.data->viewProjection;
+
+        // Finer mip levels for the textures that got bigger on screen, coarser ones for those that shrank
+        RequestTextureLevels(planes, cameraData.data->projection[1][1] * 0.5f * static_cast<float>(m_Size.y));
+        m_TextureStreamer->Update(m_Textures, m_FrameNr, [&](uint32_t slot) {
+            for (auto& swaps: m_TextureSwaps) swaps.push_back(slot);
+        });
+        WriteTextureSwaps();
+
+        RecordCulling(frame, cullData.offset, static_cast<uint32_t>(m_Renderables.size()), drawCount,
+                      { cameraData.offset, lightData.offset, lightSlice.offset });
+
+        // Culling of this frame waits for the Hi-Z pyramid of the last frame in this slot, not for the frames in
+        // between, so it overlaps the rendering of the previous frame
+        vk::PipelineStageFlags computeWaitStage = vk::PipelineStageFlagBits::eComputeShader;
+        uint64_t computeWaitValue = m_FrameNr >= m_Frames.size() ? m_FrameNr - m_Frames.size() + 1 : 0;
+        uint64_t computeSignalValue = m_FrameNr + 1;
+        vk::TimelineSemaphoreSubmitInfo computeTimelineInfo(computeWaitValue, computeSignalValue);
+        vk::SubmitInfo computeSubmitInfo(m_GraphicsTimeline, computeWaitStage, frame.computeCommandBuffer,
+                                         m_ComputeTimeline);
+        computeSubmitInfo.setPNext(&computeTimelineInfo);
+        m_Ctx->GetComputeQueue().submit(computeSubmitInfo);
 
-            lights[i].position = glm::vec4(entity.GetTransform().GetTranslation(), 1.f);
-            lights[i].rotation = glm::vec4(glm::radians(entity.GetTransform().GetRotation()), 1.f);
-            lights[i].color = glm::vec4(light.color, 1.f);
-            lights[i].flags.x = static_cast<uint32_t>(light.type);
+        for (auto& light: m_Lights) {
+            auto& entity = m_Scene->GetEntity(light);
+            *instances++ = InstanceData{
+                    .modelMat = glm::translate(glm::mat4(1.f), entity.GetTransform().GetTranslation()),
+                    .normalMat = glm::mat3x4(1.f),
+                    .objectID = static_cast<uint32_t>(entity.GetId()),
+                    .textureID = static_cast<uint32_t>(entity.GetComponent<Iris::Light>().type)
+            };
         }
 
-        m_LightStorageBuffer->Unmap();
+        if (!m_Headless) {
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            ImGuizmo::BeginFrame();
+        }
 
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        ImGuizmo::BeginFrame();
+        vk::Extent2D extent{ m_Size.x, m_Size.y };
+        uint32_t imageIndex = m_FrameIndex;
+        if (!m_Headless) {
+            imageIndex = m_Ctx->GetDevice()
+                    .acquireNextImageKHR(m_Swapchain, 100000000, frame.presentSemaphore, nullptr).value;
+        }
+        cmdBuf.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlags()));
 
-        vk::Extent2D extent{ m_Window->GetWidth(), m_Window->GetHeight() };
-        vk::ResultValue<uint32_t> currentBuffer = m_Ctx->GetDevice()
-                .acquireNextImageKHR(m_Swapchain, 100000000, m_PresentSemaphore, nullptr);
-        m_CommandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlags()));
+        // Takes ownership of everything uploaded since the last frame, the submit below waits for those uploads
+        UploadTicket uploadTicket = m_UploadContext->RecordAcquires(cmdBuf);
 
-        std::array<vk::ClearValue, 3> clearValues;
+        // The G-buffer is fully overwritten where there is geometry and never read elsewhere
+        std::array<vk::ClearValue, 5> clearValues;
         clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{ 0.2f, 0.2f, 0.2f, 1.f });
         clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
         clearValues[2].color = vk::ClearColorValue(std::array<uint32_t, 4>{ 0, 0, 0, 0 });
+        clearValues[3].color = vk::ClearColorValue(std::array<float, 4>{ 0.f, 0.f, 0.f, 0.f });
+        clearValues[4].color = vk::ClearColorValue(std::array<float, 4>{ 0.f, 0.f, 0.f, 0.f });
 
         vk::RenderPassBeginInfo renderPassBeginInfo(
-                m_MainRenderPass, m_Framebuffers[currentBuffer.value],
+                m_MainRenderPass, m_Framebuffers[imageIndex],
                 vk::Rect2D(vk::Offset2D(0, 0), extent), clearValues);
 
-        m_CommandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
-        m_CommandBuffer.setViewport( // Viewport is flipped
+        cmdBuf.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+        cmdBuf.setViewport( // Viewport is flipped
                 0, vk::Viewport(0.0f, static_cast<float>(extent.height),
                                 static_cast<float>(extent.width),
                                 -static_cast<float>(extent.height), 0.0f, 1.0f));
-        m_CommandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
+        cmdBuf.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
+
+        // Every variant shares the layout and sets, so they stay bound while the pipeline changes per bucket
+        cmdBuf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_Pipeline->pipelineLayout, 0,
+                                  m_Pipeline->descriptorSets[m_FrameIndex],
+                                  { cameraData.offset, lightData.offset, lightSlice.offset });
+
+        auto drawBucket = [&](uint32_t bucket, uint32_t first) {
+            cmdBuf.drawIndexedIndirectCount(frame.compactedBuffer->m_Buffer,
+                                            first * sizeof(vk::DrawIndexedIndirectCommand),
+                                            frame.visibleDrawCountBuffer->m_Buffer, bucket * sizeof(uint32_t),
+                                            bucketEnds[bucket] - first, sizeof(vk::DrawIndexedIndirectCommand));
+        };
+
+        // The opaque buckets lay down their depth first, so the shading below runs at most once per pixel for
+        // them. Set 0 stays bound, the depth pipeline's layout matches up to it.
+        if (m_DepthPrepass) {
+            m_GeometryPool->BindPositions(cmdBuf);
+            cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, m_DepthPipeline->pipeline);
+            for (uint32_t bucket = 0, first = 0; bucket < BucketCount; first = bucketEnds[bucket++]) {
+                if (bucketEnds[bucket] != first && !(bucket & AlphaTest)) drawBucket(bucket, first);
+            }
+        }
 
-        m_CommandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_Pipeline->pipeline);
-        m_CommandBuffer.bindDescriptorSets(
-                vk::PipelineBindPoint::eGraphics, m_Pipeline->pipelineLayout, 0, m_Pipeline->descriptorSets, nullptr);
+        auto geometryPass = m_Deferred ? ShadingPass::GBuffer : ShadingPass::Forward;
+        m_GeometryPool->Bind(cmdBuf);
+        for (uint32_t bucket = 0, first = 0; bucket < BucketCount; first = bucketEnds[bucket++]) {
+            if (bucketEnds[bucket] == first) continue;
+            cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                                GetUberPipeline(geometryPass, bucket | lightFeatures).pipeline);
+            drawBucket(bucket, first);
+        }
 
-        for (auto& mesh: m_Meshes) {
-            auto entityID = mesh.GetParentID();
-            m_CommandBuffer.pushConstants<PushConstants>(
-                    m_Pipeline->pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
-                    0u, PushConstants{
-                            .modelMat = m_Scene->GetEntity(entityID).GetComponent<Iris::Mesh>().GetModelMatrix(),
-                            .objectID = static_cast<uint32_t>(entityID),
-                            .textureID = static_cast<uint32_t>(entityID)
-                    });
-            mesh.Draw(m_CommandBuffer);
+        cmdBuf.nextSubpass(vk::SubpassContents::eInline);
+        if (m_Deferred) {
+            // Each pixel is lit once, however many surfaces were drawn over it
+            const auto& lighting = GetUberPipeline(ShadingPass::Lighting, lightFeatures);
+            cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, lighting.pipeline);
+            cmdBuf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, lighting.pipelineLayout, 0,
+                                      m_LightingPipeline->descriptorSets[m_FrameIndex],
+                                      { cameraData.offset, lightData.offset, lightSlice.offset });
+            cmdBuf.draw(3, 1, 0, 0);
         }
 
-        m_CommandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_BillboardPipeline->pipeline);
-        m_CommandBuffer.bindDescriptorSets(
-                vk::PipelineBindPoint::eGraphics, m_BillboardPipeline->pipelineLayout, 0,
-                m_BillboardPipeline->descriptorSets, nullptr);
+        cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, m_BillboardPipeline->pipeline);
+        cmdBuf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_BillboardPipeline->pipelineLayout, 0,
+                                  m_BillboardPipeline->descriptorSets[m_FrameIndex], cameraData.offset);
 
-        for (auto& light: m_Lights) {
-            auto& entity = m_Scene->GetEntity(light);
+        if (!m_Lights.empty()) {
+            cmdBuf.draw(6, static_cast<uint32_t>(m_Lights.size()), 0, static_cast<uint32_t>(m_Renderables.size()));
+        }
+
+        if (!m_Headless) {
+            RenderUI(camera);
+            ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmdBuf);
+        }
+
+        cmdBuf.endRenderPass();
+        RecordHiZ(frame);
+
+        if (m_Headless) {
+            cmdBuf.copyImageToBuffer(
+                    m_SwapchainImages[imageIndex], vk::ImageLayout::eTransferSrcOptimal,
+                    frame.readbackBuffer->m_Buffer,
+                    vk::BufferImageCopy(0, 0, 0, vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+                                        vk::Offset3D(0, 0, 0), vk::Extent3D(m_Size.x, m_Size.y, 1)));
+
+            vk::BufferMemoryBarrier hostBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+                                                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                                frame.readbackBuffer->m_Buffer, 0, VK_WHOLE_SIZE);
+            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+                                   vk::DependencyFlags(), {}, hostBarrier, {});
+            frame.readbackFrame = m_FrameNr;
+        }
+
+        cmdBuf.end();
+
+        std::vector<vk::Semaphore> waitSemaphores;
+        std::vector<vk::PipelineStageFlags> waitStages;
+        std::vector<uint64_t> waitValues;   // ignored for the binary present semaphore
+        if (!m_Headless) {
+            waitSemaphores.push_back(frame.presentSemaphore);
+            waitStages.emplace_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+            waitValues.push_back(0);
+        }
+        if (uploadTicket != 0) {
+            waitSemaphores.push_back(m_UploadContext->GetTimelineSemaphore());
+            waitStages.emplace_back(vk::PipelineStageFlagBits::eAllCommands);
+            waitValues.push_back(uploadTicket);
+        }
+        // Culling output is consumed by the indirect draw, the light clusters by the fragment shader, and the
+        // Hi-Z pyramid culling read is rebuilt at the end
+        waitSemaphores.push_back(m_ComputeTimeline);
+        waitStages.emplace_back(vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader |
+                                vk::PipelineStageFlagBits::eFragmentShader |
+                                vk::PipelineStageFlagBits::eComputeShader);
+        waitValues.push_back(m_FrameNr + 1);
+
+        std::vector<vk::Semaphore> signalSemaphores{ m_GraphicsTimeline };
+        std::vector<uint64_t> signalValues{ m_FrameNr + 1 };
+        if (!m_Headless) {
+            signalSemaphores.push_back(frame.renderSemaphore);
+            signalValues.push_back(0);
+        }
+
+        vk::TimelineSemaphoreSubmitInfo timelineInfo(waitValues, signalValues);
+        vk::SubmitInfo submitInfo(waitSemaphores, waitStages, cmdBuf, signalSemaphores);
+        submitInfo.setPNext(&timelineInfo);
+
+        m_Ctx->GetGraphicsQueue().submit(submitInfo, frame.renderFence);
+        m_FrameStats.EndRecord();
 
-            m_CommandBuffer.pushConstants<PushConstants>(
-                    m_Pipeline->pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
-                    0u, PushConstants{
-                            .modelMat = glm::translate(glm::mat4(1.f), entity.GetTransform().GetTranslation()),
-                            .objectID = static_cast<uint32_t>(entity.GetId()),
-                            .textureID = static_cast<uint32_t>(entity.GetComponent<Iris::Light>().type)
-                    });
-            m_CommandBuffer.draw(6, 1, 0, 0);
+        if (!m_Headless) {
+            VkCheck(m_Ctx->GetPresentQueue()
+                            .presentKHR(vk::PresentInfoKHR(frame.renderSemaphore, m_Swapchain, imageIndex)),
+                    "vk::Queue::presentKHR returned vk::Result::eSuboptimalKHR");
         }
 
+        m_FrameIndex = (m_FrameIndex + 1) % m_Frames.size();
+        Iris::Renderer::Present();
+    }
+
+    void Renderer::RequestTextureLevels(const std::array<glm::vec4, 6>& frustum, float pixelsPerUnit) {
+        auto worldMatrices = m_Scene->GetWorldMatrices();
+        for (const auto& renderable: m_Renderables) {
+            if (renderable.texture == 0) continue;
+
+            // Bounding sphere in world space, projected at its distance to the camera plane
+            const auto& model = worldMatrices[renderable.entity];
+            const auto& bounds = m_Meshes[renderable.mesh].GetBounds();
+            glm::vec3 center = model * glm::vec4(bounds.center, 1.f);
+            float scale = glm::max(glm::length(glm::vec3(model[0])),
+                                   glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            float radius = bounds.radius * scale;
+
+            bool visible = std::all_of(frustum.begin(), frustum.end(), [&](const glm::vec4& plane) {
+                return glm::dot(glm::vec3(plane), center) + plane.w >= -radius;
+            });
+            if (!visible) continue;
+
+            // The near plane is the distance to the camera plane, the sphere may also contain the camera
+            float distance = glm::max(glm::dot(glm::vec3(frustum[4]), center) + frustum[4].w - radius, 0.f) + radius;
+            m_TextureStreamer->Request(renderable.texture - 1, 2.f * radius / distance * pixelsPerUnit);
+        }
+    }
+
+    void Renderer::WriteTextureSwaps() {
+        for (uint32_t slot: m_TextureSwaps[m_FrameIndex]) {
+            m_Pipeline->UpdateFrameImage(m_FrameIndex, 1, 0, m_Textures[slot].GetDescriptor(), slot + 1);
+        }
+        m_TextureSwaps[m_FrameIndex].clear();
+    }
+
+    void Renderer::RenderUI(const Camera& camera) {
         ImGui::Begin("Selection");
         ImGui::Text("Selected entity: %zu", selectedEntity);
+        ImGui::Text("Frame: %.3fms, GPU wait: %.3fms (%zu in flight)",
+                    m_FrameStats.GetFrameTime(), m_FrameStats.GetWaitTime(), m_Frames.size());
+        ImGui::Text("Draws after culling: %u of %u", m_VisibleDraws, m_TotalDraws);
+        ImGui::Text("Uber shader variants: %zu", m_UberPipelines.size() + 2);
+        ImGui::Checkbox("Deferred shading", &m_Deferred);
+        ImGui::Checkbox("Depth prepass", &m_DepthPrepass);
+        ImGui::Text("Resident meshes: %zu, textures: %zu, samplers: %zu", m_Meshes.GetResidentCount(),
+                    m_Textures.GetResidentCount(), m_Ctx->GetSamplerCache().GetCount());
         //ImGui::Separator();
 
         // selectedEntity is index + 1
-        if (selectedEntity != 0 && selectedEntity <= m_Scene->GetObjects().size()) {
-            auto& entity = m_Scene->GetEntity(selectedEntity - 1);
+        auto* selected = selectedEntity != 0 ? m_Scene->TryGetObject(selectedEntity - 1) : nullptr;
+        if (selected) {
+            auto& entity = *selected;
             entity.RenderUI();
 
             if (gizmoMode != -1) {
@@ -411,7 +1182,7 @@ namespace Iris::Vulkan {
                 glm::mat4 view = camera.GetViewMatrix();
                 glm::mat4 proj = camera.GetProjectionMatrix();
                 auto& tc = entity.GetTransform();
-                glm::mat4 transform = tc.GetMatrix();
+                glm::mat4 transform = tc.GetWorldMatrix();
 
                 ImGuizmo::OPERATION op = gizmoMode == 0
                                          ? ImGuizmo::OPERATION::TRANSLATE : gizmoMode == 1
@@ -421,6 +1192,10 @@ namespace Iris::Vulkan {
                 ImGuizmo::Manipulate(glm::value_ptr(view), glm::value_ptr(proj),
                                      op, ImGuizmo::LOCAL, glm::value_ptr(transform));
                 if (ImGuizmo::IsUsing()) {
+                    // The gizmo works in world space, the transform stores the matrix relative to its parent
+                    if (tc.GetParentEntity() != Transform::NoParent) {
+                        transform = glm::inverse(m_Scene->GetWorldMatrix(tc.GetParentEntity())) * transform;
+                    }
                     glm::vec3 translate, rotate, scale;
                     Math::DecomposeTransform(transform, translate, rotate, scale);
                     tc.SetTranslation(translate);
@@ -431,39 +1206,77 @@ namespace Iris::Vulkan {
         }
 
         ImGui::End();
-        ImGui::Render();
-        ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), m_CommandBuffer);
 
-        m_CommandBuffer.endRenderPass();
-        m_CommandBuffer.end();
-
-        vk::PipelineStageFlags waitDestinationStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-        vk::SubmitInfo submitInfo(m_PresentSemaphore, waitDestinationStageMask, m_CommandBuffer, m_RenderSemaphore);
+        ImGui::Begin("Texture streaming");
+        ImGui::Text("Resident: %.1f of %.1f MiB",
+                    static_cast<double>(m_TextureStreamer->GetResidentBytes()) / (1 << 20),
+                    static_cast<double>(m_TextureStreamer->GetBudget()) / (1 << 20));
+        if (ImGui::BeginTable("Residency", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+            ImGui::TableSetupColumn("Texture");
+            ImGui::TableSetupColumn("Size");
+            ImGui::TableSetupColumn("Resident");
+            ImGui::TableSetupColumn("Wanted");
+            ImGui::TableSetupColumn("KiB");
+            ImGui::TableHeadersRow();
+            for (const auto& texture: m_TextureStreamer->GetResidency()) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(texture.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%ux%u", texture.size.x, texture.size.y);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u / %u", texture.residentLevel, texture.levelCount);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", texture.wantedLevel);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(texture.residentBytes >> 10));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+        ImGui::Render();
+    }
 
-        m_Ctx->GetGraphicsQueue().submit(submitInfo, m_RenderFence);
+    void Renderer::EmitReadback(FrameData& frame) {
+        if (!frame.readbackFrame) return;
+        emit<FrameReady>(*frame.readbackFrame, m_Size,
+                         std::span<const uint8_t>(frame.readbackData, m_Size.x * m_Size.y * 4));
+        frame.readbackFrame.reset();
+    }
 
-        VkCheck(m_Ctx->GetGraphicsQueue()
-                        .presentKHR(vk::PresentInfoKHR(m_RenderSemaphore, m_Swapchain, currentBuffer.value)),
-                "vk::Queue::presentKHR returned vk::Result::eSuboptimalKHR");
+    void Renderer::Flush() {
+        m_Ctx->GetDevice().waitIdle();
 
-        Iris::Renderer::Present();
+        // hand out the remaining readbacks oldest first
+        for (size_t i = 0; i < m_Frames.size(); ++i) {
+            EmitReadback(m_Frames[(m_FrameIndex + i) % m_Frames.size()]);
+        }
     }
 
     Renderer::~Renderer() {
         m_Ctx->GetDevice().waitIdle();
 
-        m_Meshes.clear();
-        m_Textures.clear();
+        m_Meshes.Clear();
+        m_GeometryPool.reset();
+        m_Textures.Clear();
+        m_TextureStreamer.reset();
+        m_Icons.clear();
 
-        ImGui_ImplVulkan_Shutdown();
-        m_Ctx->GetDevice().destroyDescriptorPool(m_ImGuiPool);
+        if (!m_Headless) {
+            ImGui_ImplVulkan_Shutdown();
+            m_Ctx->GetDevice().destroyDescriptorPool(m_ImGuiPool);
+        }
 
-        m_Ctx->GetDevice().destroySemaphore(m_PresentSemaphore);
-        m_Ctx->GetDevice().destroySemaphore(m_RenderSemaphore);
-        m_Ctx->GetDevice().destroyFence(m_RenderFence);
+        for (auto& frame: m_Frames) {
+            m_Ctx->GetDevice().destroySemaphore(frame.presentSemaphore);
+            m_Ctx->GetDevice().destroySemaphore(frame.renderSemaphore);
+            m_Ctx->GetDevice().destroyFence(frame.renderFence);
+            m_Ctx->GetDevice().freeCommandBuffers(frame.computeCommandPool, frame.computeCommandBuffer);
+            m_Ctx->GetDevice().destroyCommandPool(frame.computeCommandPool);
 
-        m_CameraDataBuffer.reset();
-        m_LightDataBuffer.reset();
+            frame.readbackBuffer.reset();
+            frame.clusterBuffer.reset();
+        }
 
         for (auto const& framebuffer: m_Framebuffers) {
             m_Ctx->GetDevice().destroyFramebuffer(framebuffer);
@@ -471,22 +1284,50 @@ namespace Iris::Vulkan {
 
         m_Ctx->GetDevice().destroyRenderPass(m_MainRenderPass);
 
+        m_Ctx->GetDevice().destroySemaphore(m_ComputeTimeline);
+        m_Ctx->GetDevice().destroySemaphore(m_GraphicsTimeline);
+
+        for (auto& frame: m_Frames) {
+            for (auto& view: frame.hizLevelViews) {
+                m_Ctx->GetDevice().destroyImageView(view);
+            }
+            m_Ctx->GetDevice().destroyImageView(frame.hizView);
+            m_Ctx->GetDevice().destroyImage(frame.hizImage);
+            m_Ctx->GetAllocator().Free(frame.hizMemory);
+        }
+
         m_Ctx->GetDevice().destroyImageView(m_DepthImageView);
-        m_Ctx->GetDevice().freeMemory(m_DepthMemory);
         m_Ctx->GetDevice().destroyImage(m_DepthImage);
+        m_Ctx->GetAllocator().Free(m_DepthMemory);
         m_IDTexture.reset();
+        m_GBufferAlbedo.reset();
+        m_GBufferNormal.reset();
 
-        for (auto& imageView: m_SwapchainImageViews) {
-            m_Ctx->GetDevice().destroyImageView(imageView);
+        if (m_Headless) {
+            m_OffscreenTargets.clear();
+        } else {
+            for (auto& imageView: m_SwapchainImageViews) {
+                m_Ctx->GetDevice().destroyImageView(imageView);
+            }
+            m_Ctx->GetDevice().destroySwapchainKHR(m_Swapchain);
         }
-        m_Ctx->GetDevice().destroySwapchainKHR(m_Swapchain);
 
         m_UploadContext.reset();
-        m_Ctx->GetDevice().freeCommandBuffers(m_CommandPool, m_CommandBuffer);
-        m_Ctx->GetDevice().destroyCommandPool(m_CommandPool);
+        for (auto& frame: m_Frames) {
+            m_Ctx->GetDevice().freeCommandBuffers(frame.commandPool, frame.commandBuffer);
+            m_Ctx->GetDevice().destroyCommandPool(frame.commandPool);
+        }
 
+        m_UberPipelines.clear();
+        m_LightingPipeline.reset();
+        m_DepthPipeline.reset();
         m_Pipeline.reset();
         m_BillboardPipeline.reset();
+        m_HiZPipeline.reset();
+        m_CullPipeline.reset();
+        m_CompactPipeline.reset();
+        m_OrderedCompactPipeline.reset();
+        m_LightCullPipeline.reset();
         m_PipelineBuilder.reset();
 
         m_Ctx.reset();
@@ -496,20 +1337,70 @@ namespace Iris::Vulkan {
         Iris::Renderer::SetScene(scene);
 
         m_Scene->on<ObjectAdd>([this](uint32_t entity) {
-            for (auto& mesh: m_Scene->GetEntity(entity).GetComponents<Iris::Mesh>()) {
-                m_Meshes.emplace_back(m_Ctx, entity, mesh.GetVertices(), mesh.GetIndices());
-            }
+            auto& object = m_Scene->GetEntity(entity);
+
+            // Entities referencing the same content share one copy of the geometry and get drawn instanced.
+            // Assets have finished loading by the time the scene announces an entity.
+            if (object.HasComponent<Iris::Mesh>() &&
+                object.GetComponent<Iris::Mesh>().GetState() == AssetState::Loaded) {
+                auto& mesh = object.GetComponent<Iris::Mesh>();
+                uint64_t key = mesh.GetContentHash();
+                if (key == 0) {
+                    // Built in code, nothing to share with
+                    auto handle = object.GetHandle();
+                    key = (uint64_t(handle.generation) << 32 | handle.id) ^ 0x9e3779b97f4a7c15ull;
+                }
+                auto [slot, created] = m_Meshes.Acquire(key, [&] {
+                    return Mesh(*m_GeometryPool, mesh.GetVertices(), mesh.GetIndices(), mesh.GetBounds());
+                });
+
+                uint32_t texture = 0;
+                uint32_t features = 0;
+                if (object.HasComponent<Material>()) {
+                    auto& material = object.GetComponent<Material>();
+                    texture = AcquireTexture(material);
+                    if (texture != 0) {
+                        bool alphaTest = material.IsAlphaTested() && material.GetImage()->hasAlpha;
+                        features = alphaTest ? Textured | AlphaTest : Textured;
+                    }
+                }
 
-            if (!m_Scene->GetEntity(entity).GetComponents<Material>().empty()) {
-                auto& material = m_Scene->GetEntity(entity).GetComponent<Material>();
-                m_Textures.emplace_back(m_Ctx, m_UploadContext, material.getTexture(), 4);
-                m_Pipeline->UpdateImage(1, 0, m_Textures[m_Textures.size() - 1].GetDescriptor(), entity);
+                m_Renderables.push_back({ .entity = entity, .mesh = slot, .texture = texture, .features = features });
+                m_RenderablesDirty = true;
             }
 
-            for (auto& light: m_Scene->GetEntity(entity).GetComponents<Iris::Light>()) {
-                m_Lights.emplace_back(light.GetParent().GetId());
+            if (object.HasComponent<Iris::Light>()) {
+                m_Lights.emplace_back(entity);
             }
         });
+
+        m_Scene->on<ObjectRemove>([this](uint32_t entity) {
+            std::erase_if(m_Renderables, [&](const Renderable& renderable) {
+                if (renderable.entity != entity) return false;
+                ReleaseResources(renderable.mesh, renderable.texture);
+                return true;
+            });
+            std::erase(m_Lights, entity);
+        });
+    }
+
+    uint32_t Renderer::AcquireTexture(const Material& material) {
+        // Slot 0 is left empty for entities without a (loadable) material
+        if (material.GetState() != AssetState::Loaded || !material.GetImage()) return 0;
+
+        const auto& image = *material.GetImage();
+        auto [slot, created] = m_Textures.Acquire(image.hash, [&] { return m_TextureStreamer->Create(image); });
+        if (created) {
+            m_Pipeline->UpdateImage(1, 0, m_Textures[slot].GetDescriptor(), slot + 1);
+            m_TextureStreamer->Track(slot, material.getTexture(), material.GetImage());
+        }
+        return slot + 1;
+    }
+
+    void Renderer::ReleaseResources(uint32_t mesh, uint32_t texture) {
+        // Frames submitted so far signal at most m_FrameNr, later ones no longer reference the renderable
+        m_Meshes.Release(mesh, m_FrameNr);
+        if (texture != 0) m_Textures.Release(texture - 1, m_FrameNr);
     }
 
     void Renderer::InitImGui() {
@@ -538,26 +1429,29 @@ namespace Iris::Vulkan {
         t.PhysicalDevice = &*m_Ctx->GetPhysDevice();
         t.Queue = &*m_Ctx->GetGraphicsQueue();
         t.MinImageCount = 2;
-        t.ImageCount = glm::max(2LLu, m_SwapchainImages.size());
+        // ImGui keeps its vertex buffers per image, there must be at least one for every frame in flight
+        t.ImageCount = glm::max<size_t>(glm::max<size_t>(2, m_Frames.size()), m_SwapchainImages.size());
         t.QueueFamily = m_Ctx->GetGraphicsQueueFamilyIndex();
         t.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+        t.Subpass = 1;  // after the lighting
 
         ImGui_ImplVulkan_Init(&t, &*m_MainRenderPass);
 
         {
-            m_CommandBuffer.begin(vk::CommandBufferBeginInfo(
+            auto& cmdBuf = m_Frames[0].commandBuffer;
+            cmdBuf.begin(vk::CommandBufferBeginInfo(
                     vk::CommandBufferUsageFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
 
-            ImGui_ImplVulkan_CreateFontsTexture(&*m_CommandBuffer);
+            ImGui_ImplVulkan_CreateFontsTexture(&*cmdBuf);
 
-            m_CommandBuffer.end();
+            cmdBuf.end();
 
-            vk::SubmitInfo submitInfo({}, {}, m_CommandBuffer);
+            vk::SubmitInfo submitInfo({}, {}, cmdBuf);
 
             m_Ctx->GetGraphicsQueue().submit(submitInfo);
 
             m_Ctx->GetDevice().waitIdle();
-            m_CommandBuffer.reset();
+            m_Ctx->GetDevice().resetCommandPool(m_Frames[0].commandPool);
         }
 
         ImGui_ImplVulkan_DestroyFontUploadObjects();
@@ -6,36 +6,72 @@
 #include "Iris/Platform/Vulkan/Buffer.hpp"
 #include "Iris/Platform/Vulkan/PipelineBuilder.hpp"
 #include "Iris/Platform/Vulkan/Mesh.hpp"
+#include "Iris/Platform/Vulkan/GeometryPool.hpp"
 #include "Iris/Platform/Vulkan/UploadContext.hpp"
 #include "Iris/Platform/Vulkan/Texture.hpp"
 #include "Iris/Platform/Vulkan/CameraData.hpp"
 #include "Iris/Platform/Vulkan/LightData.hpp"
+#include "Iris/Platform/Vulkan/CullData.hpp"
+#include "Iris/Platform/Vulkan/FrameData.hpp"
+#include "Iris/Platform/Vulkan/TransientArena.hpp"
+#include "Iris/Platform/Vulkan/ResourceRegistry.hpp"
+#include "Iris/Platform/Vulkan/TextureStreamer.hpp"
 #include "Iris/Entity/Components/Light.hpp"
+#include "Iris/Debug/FrameStats.hpp"
+#include "Iris/Util/RadixSort.hpp"
 
 namespace Iris::Vulkan {
     class Renderer final : public Iris::Renderer {
     public:
         //explicit Renderer(const WindowOptions& opts, const std::shared_ptr<Scene>& scene);
-        explicit Renderer(const std::shared_ptr<Window>& window);
+        explicit Renderer(const std::shared_ptr<Window>& window, const RendererOptions& options = {});
 
         void Render(const Camera& camera) override;
         void SetScene(const std::shared_ptr<Scene>& scene) override;
+        void Flush() override;
 
         ~Renderer() override;
     private:
+        // Forward shades in the first subpass. Deferred writes the G-buffer there and lights it in the second.
+        enum class ShadingPass : uint32_t {
+            Forward,
+            GBuffer,
+            Lighting
+        };
 
         void InitSwapchain();
+        void InitOffscreenTargets();
+        void InitReadbackBuffers();
         void InitDepthBuffer();
+        void InitHiZBuffer();
         void InitIDBuffer();
+        void InitGBuffer();
         void InitRenderPass();
         void InitFramebuffers();
         void InitCommandBuffers();
         void InitSyncStructures();
         void InitUniformBuffer();
         void InitPipelines();
+        // depthEqual: for opaque draws after the depth prepass, which only test for the depth it wrote
+        std::unique_ptr<PipelineBuilder::Pipeline> BuildUberPipeline(ShadingPass pass, uint32_t features,
+                                                                     bool depthEqual = false);
+        const PipelineBuilder::Pipeline& GetUberPipeline(ShadingPass pass, uint32_t features);
         void InitImGui();
+
+        void ReserveInstances(uint32_t frameIndex, size_t count);
+        // lightOffsets: dynamic offsets of the camera, light meta and light array slices
+        void RecordCulling(FrameData& frame, uint32_t cullOffset, uint32_t instanceCount, uint32_t drawCount,
+                           const std::array<uint32_t, 3>& lightOffsets);
+        void RecordHiZ(FrameData& frame);
+        uint32_t AcquireTexture(const Material& material);
+        void ReleaseResources(uint32_t mesh, uint32_t texture);
+        void RequestTextureLevels(const std::array<glm::vec4, 6>& frustum, float pixelsPerUnit);
+        void WriteTextureSwaps();
+        void RenderUI(const Camera& camera);
+        void EmitReadback(FrameData& frame);
     private:
         std::shared_ptr<Context> m_Ctx{ nullptr };
+        bool m_Headless = false;
 
         vk::Format m_SwapchainFormat{};
         vk::SwapchainKHR m_Swapchain;
@@ -43,32 +79,79 @@ namespace Iris::Vulkan {
         std::vector<vk::Image> m_SwapchainImages;
         std::vector<vk::ImageView> m_SwapchainImageViews;
         std::vector<vk::Framebuffer> m_Framebuffers;
+        std::vector<std::unique_ptr<Texture<uint8_t>>> m_OffscreenTargets; // headless stand-in for the swapchain
 
         vk::Format m_DepthFormat = vk::Format::eD16Unorm;
-        vk::DeviceMemory m_DepthMemory;
+        Allocation m_DepthMemory;
         vk::Image m_DepthImage;
         vk::ImageView m_DepthImageView;
         std::shared_ptr<Texture<uint32_t>> m_IDTexture;
 
-        vk::RenderPass m_MainRenderPass;
-
-        vk::CommandPool m_CommandPool;
-        vk::CommandBuffer m_CommandBuffer;
+        // Only live within the render pass. Always attached so deferred can be toggled without a new render pass;
+        // transient and lazily allocated where supported, so forward rendering on tilers commits no memory for them.
+        bool m_Deferred = false;
+        bool m_DepthPrepass = false;
+        std::unique_ptr<Texture<uint8_t>> m_GBufferAlbedo;
+        std::unique_ptr<Texture<uint8_t>> m_GBufferNormal;
+
+        // Size of the per-frame Hi-Z pyramids, see FrameData
+        glm::uvec2 m_HiZSize{};
+        uint32_t m_HiZLevels = 0;
+        vk::Sampler m_HiZSampler;   // owned by the context's sampler cache
+
+        // Frame N's culling waits on the rendering of frame N - FramesInFlight, which built the Hi-Z pyramid it
+        // tests against, rendering waits on culling. Frames in between keep running on the graphics queue.
+        std::vector<uint32_t> m_CullQueueFamilies;
+        vk::Semaphore m_ComputeTimeline;
+        vk::Semaphore m_GraphicsTimeline;
+        uint32_t m_VisibleDraws = 0;
+        uint32_t m_TotalDraws = 0;
 
-        vk::Fence m_RenderFence;
-        vk::Semaphore m_RenderSemaphore;
-        vk::Semaphore m_PresentSemaphore;
+        vk::RenderPass m_MainRenderPass;
 
-        std::unique_ptr<Buffer<CameraData>> m_CameraDataBuffer;
-        std::unique_ptr<Buffer<LightData>> m_LightDataBuffer;
-        std::unique_ptr<Buffer<Light>> m_LightStorageBuffer;
+        std::vector<FrameData> m_Frames;
+        uint32_t m_FrameIndex = 0;
+        Debug::FrameStats m_FrameStats{ "Vulkan::Renderer" };
+        std::unique_ptr<TransientArena> m_TransientArena;
 
         std::unique_ptr<PipelineBuilder> m_PipelineBuilder;
-        std::unique_ptr<PipelineBuilder::Pipeline> m_Pipeline;
+        std::unique_ptr<PipelineBuilder::Pipeline> m_Pipeline;     // uber shader with every feature, owns the sets
+        // Fullscreen lighting with every light type, owns the G-buffer input attachment sets
+        std::unique_ptr<PipelineBuilder::Pipeline> m_LightingPipeline;
+        // Position only, writes the depth of the opaque buckets before they are shaded
+        std::unique_ptr<PipelineBuilder::Pipeline> m_DepthPipeline;
+        // Variants by (pass << 1 | depthEqual) << 8 | features, built when first drawn and sharing the sets above
+        std::unordered_map<uint32_t, std::unique_ptr<PipelineBuilder::Pipeline>> m_UberPipelines;
         std::unique_ptr<PipelineBuilder::Pipeline> m_BillboardPipeline;
-
-        std::vector<Mesh> m_Meshes;
-        std::vector<Texture<float>> m_Textures;
+        std::unique_ptr<PipelineBuilder::Pipeline> m_HiZPipeline;   // one set copy per pyramid level of every frame
+        std::unique_ptr<PipelineBuilder::Pipeline> m_CullPipeline;
+        std::unique_ptr<PipelineBuilder::Pipeline> m_CompactPipeline;
+        std::unique_ptr<PipelineBuilder::Pipeline> m_OrderedCompactPipeline;  // keeps the draw order, one workgroup
+        std::unique_ptr<PipelineBuilder::Pipeline> m_LightCullPipeline;
+
+        // Every renderable holds one reference on its mesh and texture
+        struct Renderable {
+            size_t entity;
+            uint32_t mesh;      // m_Meshes slot
+            uint32_t texture;   // descriptor index, m_Textures slot + 1 or 0 without a texture
+            uint32_t features;  // material ShaderFeature bits, also its draw bucket
+        };
+
+        std::unique_ptr<GeometryPool> m_GeometryPool;
+        ResourceRegistry<Mesh> m_Meshes;
+        std::vector<Renderable> m_Renderables;
+        bool m_RenderablesDirty = false;
+        std::vector<uint32_t> m_RenderableDraws;   // indirect command index of every renderable
+        // Renderable range of every (mesh, material) group and their sort keys, kept to reuse the storage
+        std::vector<std::pair<uint32_t, uint32_t>> m_DrawGroups;
+        std::vector<SortItem> m_DrawKeys;
+        std::vector<SortItem> m_DrawKeysScratch;
+        ResourceRegistry<Texture<float>> m_Textures;
+        std::vector<Texture<float>> m_Icons;       // light billboards
+        SamplerDesc m_MaterialSampler;
+        std::unique_ptr<TextureStreamer> m_TextureStreamer;
+        // Slots whose texture was swapped, per descriptor set copy, rewritten once that copy is no longer in use
+        std::vector<std::vector<uint32_t>> m_TextureSwaps;
         std::vector<size_t> m_Lights;
 
         std::shared_ptr<UploadContext> m_UploadContext;
@@ -0,0 +1,112 @@
+#pragma once
+
+namespace Iris::Vulkan {
+    // Device resources shared by everything referencing the same source, keyed by a content hash. Every
+    // Acquire adds a reference, the last Release retires the slot and Collect evicts it once the frame that
+    // may still read it has completed. Slots are small stable indices, so they double as handles in instance
+    // data and descriptor arrays and get reused after eviction.
+    template <typename T>
+    class ResourceRegistry final {
+    public:
+        using Slot = uint32_t;
+
+        // Looks up key, creating the resource with create() when it isn't resident. The bool is true for
+        // freshly created resources, e.g. to write their descriptor.
+        template <typename F>
+        std::pair<Slot, bool> Acquire(uint64_t key, F&& create) {
+            if (auto it = m_Lookup.find(key); it != m_Lookup.end()) {
+                ++m_Entries[it->second].refs;   // also revives a retired but not yet evicted slot
+                return { it->second, false };
+            }
+
+            Slot slot;
+            if (m_FreeSlots.empty()) {
+                slot = static_cast<Slot>(m_Entries.size());
+                m_Entries.emplace_back();
+            } else {
+                slot = m_FreeSlots.back();
+                m_FreeSlots.pop_back();
+            }
+
+            auto& entry = m_Entries[slot];
+            entry.resource.emplace(create());
+            entry.key = key;
+            entry.refs = 1;
+            m_Lookup.emplace(key, slot);
+            ++m_Resident;
+            return { slot, true };
+        }
+
+        // frame is the value of the graphics timeline the last frame that could use the slot signals
+        void Release(Slot slot, uint64_t frame) {
+            auto& entry = m_Entries[slot];
+            if (--entry.refs > 0) return;
+            entry.retireFrame = frame;
+            if (!entry.retired) m_Retired.push_back(slot);
+            entry.retired = true;
+        }
+
+        // Swaps the resource behind a slot, e.g. for a different resolution. The old one is kept until frame
+        // has completed.
+        void Replace(Slot slot, T&& resource, uint64_t frame) {
+            m_Graveyard.emplace_back(frame, std::move(*m_Entries[slot].resource));
+            m_Entries[slot].resource.emplace(std::move(resource));
+        }
+
+        // Evicts retired slots nobody acquired again, onEvict runs right before a slot is destroyed. Returns
+        // how many were evicted.
+        size_t Collect(uint64_t completedFrame, const std::function<void(Slot)>& onEvict = {}) {
+            while (!m_Graveyard.empty() && m_Graveyard.front().first <= completedFrame) m_Graveyard.pop_front();
+
+            size_t evicted = 0;
+            std::erase_if(m_Retired, [&](Slot slot) {
+                auto& entry = m_Entries[slot];
+                if (entry.refs > 0) {
+                    entry.retired = false;
+                    return true;
+                }
+                if (entry.retireFrame > completedFrame) return false;
+
+                if (onEvict) onEvict(slot);
+                m_Lookup.erase(entry.key);
+                entry.resource.reset();
+                entry.retired = false;
+                m_FreeSlots.push_back(slot);
+                --m_Resident;
+                ++evicted;
+                return true;
+            });
+            return evicted;
+        }
+
+        void Clear() {
+            m_Graveyard.clear();
+            m_Entries.clear();
+            m_Lookup.clear();
+            m_FreeSlots.clear();
+            m_Retired.clear();
+            m_Resident = 0;
+        }
+
+        [[nodiscard]] T& operator[](Slot slot) { return *m_Entries[slot].resource; }
+        [[nodiscard]] const T& operator[](Slot slot) const { return *m_Entries[slot].resource; }
+        [[nodiscard]] size_t GetResidentCount() const { return m_Resident; }
+        // Nobody holds the slot anymore, it only waits for eviction
+        [[nodiscard]] bool IsReleased(Slot slot) const { return m_Entries[slot].refs == 0; }
+    private:
+        struct Entry {
+            std::optional<T> resource;
+            uint64_t key = 0;
+            uint32_t refs = 0;
+            uint64_t retireFrame = 0;
+            bool retired = false;   // listed in m_Retired
+        };
+
+        std::vector<Entry> m_Entries;
+        std::unordered_map<uint64_t, Slot> m_Lookup;
+        std::vector<Slot> m_FreeSlots;
+        std::vector<Slot> m_Retired;
+        std::deque<std::pair<uint64_t, T>> m_Graveyard;    // replaced resources, by retire frame
+        size_t m_Resident = 0;
+    };
+}
@@ -0,0 +1,35 @@
+#include "SamplerCache.hpp"
+
+namespace Iris::Vulkan {
+    SamplerCache::SamplerCache(vk::Device device, vk::PhysicalDevice physicalDevice, bool anisotropy)
+            : m_Device(device) {
+        if (anisotropy) m_MaxAnisotropy = physicalDevice.getProperties().limits.maxSamplerAnisotropy;
+    }
+
+    vk::Sampler SamplerCache::Get(const SamplerDesc& desc) {
+        std::lock_guard lock(m_Mutex);
+        if (auto it = m_Samplers.find(desc); it != m_Samplers.end()) return it->second;
+
+        float anisotropy = std::clamp(desc.maxAnisotropy, 1.f, m_MaxAnisotropy);
+        vk::SamplerCreateInfo createInfo({}, desc.magFilter, desc.minFilter, desc.mipmapMode,
+                                         desc.addressMode, desc.addressMode, desc.addressMode, desc.lodBias,
+                                         anisotropy > 1.f, anisotropy, false, vk::CompareOp::eNever,
+                                         0.f, desc.maxLod);
+        vk::Sampler sampler = m_Device.createSampler(createInfo);
+        m_Samplers.emplace(desc, sampler);
+        return sampler;
+    }
+
+    size_t SamplerCache::DescHash::operator()(const SamplerDesc& desc) const {
+        size_t hash = static_cast<size_t>(desc.magFilter) | static_cast<size_t>(desc.minFilter) << 4 |
+                      static_cast<size_t>(desc.mipmapMode) << 8 | static_cast<size_t>(desc.addressMode) << 12;
+        for (float value: { desc.maxAnisotropy, desc.lodBias, desc.maxLod }) {
+            hash = hash * 31 + std::hash<float>()(value);
+        }
+        return hash;
+    }
+
+    SamplerCache::~SamplerCache() {
+        for (auto& [desc, sampler]: m_Samplers) m_Device.destroySampler(sampler);
+    }
+}
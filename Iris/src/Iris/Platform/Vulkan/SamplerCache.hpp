@@ -0,0 +1,38 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+namespace Iris::Vulkan {
+    // Sampling state of a texture. Anisotropy is clamped to what the device supports, 1 disables it.
+    struct SamplerDesc {
+        vk::Filter magFilter = vk::Filter::eLinear;
+        vk::Filter minFilter = vk::Filter::eLinear;
+        vk::SamplerMipmapMode mipmapMode = vk::SamplerMipmapMode::eLinear;
+        vk::SamplerAddressMode addressMode = vk::SamplerAddressMode::eRepeat;
+        float maxAnisotropy = 16.f;
+        float lodBias = 0.f;
+        float maxLod = VK_LOD_CLAMP_NONE;
+
+        bool operator==(const SamplerDesc&) const = default;
+    };
+
+    // Samplers are immutable and few, so every distinct description is created once and shared by all
+    // textures using it. They live until the context is destroyed.
+    class SamplerCache final {
+    public:
+        SamplerCache(vk::Device device, vk::PhysicalDevice physicalDevice, bool anisotropy);
+
+        vk::Sampler Get(const SamplerDesc& desc);
+        [[nodiscard]] size_t GetCount() const { return m_Samplers.size(); }
+
+        ~SamplerCache();
+    private:
+        struct DescHash {
+            size_t operator()(const SamplerDesc& desc) const;
+        };
+    private:
+        vk::Device m_Device;
+        float m_MaxAnisotropy = 1.f;    // 1 when the feature isn't enabled
+        std::unordered_map<SamplerDesc, vk::Sampler, DescHash> m_Samplers;
+        std::mutex m_Mutex;
+    };
+}
@@ -0,0 +1,316 @@
+#include "ShaderReflection.hpp"
+
+namespace Iris::Vulkan {
+    // The few SPIR-V enumerants reflection needs, values from the SPIR-V specification
+    namespace Spv {
+        constexpr uint32_t Magic = 0x07230203;
+
+        constexpr uint32_t OpEntryPoint = 15;
+        constexpr uint32_t OpTypeVoid = 19;
+        constexpr uint32_t OpTypeInt = 21;
+        constexpr uint32_t OpTypeFloat = 22;
+        constexpr uint32_t OpTypeVector = 23;
+        constexpr uint32_t OpTypeMatrix = 24;
+        constexpr uint32_t OpTypeImage = 25;
+        constexpr uint32_t OpTypeSampler = 26;
+        constexpr uint32_t OpTypeSampledImage = 27;
+        constexpr uint32_t OpTypeArray = 28;
+        constexpr uint32_t OpTypeRuntimeArray = 29;
+        constexpr uint32_t OpTypeStruct = 30;
+        constexpr uint32_t OpTypePointer = 32;
+        constexpr uint32_t OpConstant = 43;
+        constexpr uint32_t OpSpecConstant = 50;
+        constexpr uint32_t OpVariable = 59;
+        constexpr uint32_t OpDecorate = 71;
+        constexpr uint32_t OpMemberDecorate = 72;
+
+        constexpr uint32_t DecorationBufferBlock = 3;
+        constexpr uint32_t DecorationArrayStride = 6;
+        constexpr uint32_t DecorationMatrixStride = 7;
+        constexpr uint32_t DecorationBuiltIn = 11;
+        constexpr uint32_t DecorationLocation = 30;
+        constexpr uint32_t DecorationBinding = 33;
+        constexpr uint32_t DecorationDescriptorSet = 34;
+        constexpr uint32_t DecorationOffset = 35;
+
+        constexpr uint32_t StorageUniformConstant = 0;
+        constexpr uint32_t StorageInput = 1;
+        constexpr uint32_t StorageUniform = 2;
+        constexpr uint32_t StoragePushConstant = 9;
+        constexpr uint32_t StorageStorageBuffer = 12;
+
+        constexpr uint32_t DimBuffer = 5;
+        constexpr uint32_t DimSubpassData = 6;
+    }
+
+    namespace {
+        struct Module {
+            struct Type {
+                uint32_t op;
+                std::span<const uint32_t> operands;    // words after the result id
+            };
+
+            struct Variable {
+                uint32_t id;
+                uint32_t type;
+                uint32_t storage;
+            };
+
+            std::optional<uint32_t> executionModel;
+            std::unordered_map<uint32_t, Type> types;
+            std::unordered_map<uint32_t, uint32_t> constants;     // specialization constants by their default
+            std::unordered_map<uint32_t, std::map<uint32_t, uint32_t>> decorations;
+            std::unordered_map<uint32_t, std::map<uint32_t, std::map<uint32_t, uint32_t>>> memberDecorations;
+            std::vector<Variable> variables;
+
+            [[nodiscard]] std::optional<uint32_t> GetDecoration(uint32_t id, uint32_t decoration) const {
+                auto it = decorations.find(id);
+                if (it == decorations.end()) return {};
+                auto value = it->second.find(decoration);
+                if (value == it->second.end()) return {};
+                return value->second;
+            }
+
+            [[nodiscard]] std::optional<uint32_t> GetMemberDecoration(uint32_t id, uint32_t member,
+                                                                      uint32_t decoration) const {
+                auto it = memberDecorations.find(id);
+                if (it == memberDecorations.end() || !it->second.contains(member)) return {};
+                const auto& values = it->second.at(member);
+                auto value = values.find(decoration);
+                if (value == values.end()) return {};
+                return value->second;
+            }
+
+            // Element type of (nested) arrays, count is multiplied by their lengths and 0 for runtime arrays.
+            // Lengths computed from specialization constants (OpSpecConstantOp) can't be resolved and count as 1.
+            uint32_t StripArrays(uint32_t type, uint32_t& count, bool& resolved) const {
+                while (types.contains(type)) {
+                    const auto& info = types.at(type);
+                    if (info.op == Spv::OpTypeArray) {
+                        auto length = constants.find(info.operands[1]);
+                        resolved &= length != constants.end();
+                        count *= length != constants.end() ? length->second : 1;
+                    } else if (info.op == Spv::OpTypeRuntimeArray) {
+                        count = 0;
+                    } else {
+                        break;
+                    }
+                    type = info.operands[0];
+                }
+                return type;
+            }
+
+            // Size of a type in an explicitly laid out block (push constants)
+            [[nodiscard]] uint32_t GetSize(uint32_t type) const {
+                if (!types.contains(type)) return 0;
+                const auto& info = types.at(type);
+                switch (info.op) {
+                    case Spv::OpTypeInt:
+                    case Spv::OpTypeFloat:
+                        return info.operands[0] / 8;
+                    case Spv::OpTypeVector:
+                    case Spv::OpTypeMatrix:
+                        return info.operands[1] * GetSize(info.operands[0]);
+                    case Spv::OpTypeArray: {
+                        uint32_t length = constants.contains(info.operands[1]) ? constants.at(info.operands[1]) : 1;
+                        auto stride = GetDecoration(type, Spv::DecorationArrayStride);
+                        return length * (stride ? *stride : GetSize(info.operands[0]));
+                    }
+                    case Spv::OpTypeStruct: {
+                        uint32_t size = 0;
+                        for (uint32_t member = 0; member < info.operands.size(); ++member) {
+                            uint32_t memberType = info.operands[member];
+                            uint32_t memberSize = GetSize(memberType);
+                            // Matrix columns are padded to their stride
+                            auto stride = GetMemberDecoration(type, member, Spv::DecorationMatrixStride);
+                            if (stride && types.at(memberType).op == Spv::OpTypeMatrix) {
+                                memberSize = types.at(memberType).operands[1] * *stride;
+                            }
+                            auto offset = GetMemberDecoration(type, member, Spv::DecorationOffset);
+                            size = std::max(size, offset.value_or(size) + memberSize);
+                        }
+                        return size;
+                    }
+                    default:
+                        return 0;
+                }
+            }
+        };
+    }
+
+    static std::optional<vk::ShaderStageFlagBits> ToStage(uint32_t executionModel) {
+        switch (executionModel) {
+            case 0: return vk::ShaderStageFlagBits::eVertex;
+            case 1: return vk::ShaderStageFlagBits::eTessellationControl;
+            case 2: return vk::ShaderStageFlagBits::eTessellationEvaluation;
+            case 3: return vk::ShaderStageFlagBits::eGeometry;
+            case 4: return vk::ShaderStageFlagBits::eFragment;
+            case 5: return vk::ShaderStageFlagBits::eCompute;
+            default: return {};
+        }
+    }
+
+    static std::optional<vk::DescriptorType> ToDescriptorType(const Module& module, uint32_t storage, uint32_t type) {
+        if (!module.types.contains(type)) return {};
+        const auto& info = module.types.at(type);
+
+        switch (storage) {
+            case Spv::StorageStorageBuffer:
+                return vk::DescriptorType::eStorageBuffer;
+            case Spv::StorageUniform:
+                // SPIR-V before 1.3 declares storage buffers as uniform blocks decorated BufferBlock
+                return module.GetDecoration(type, Spv::DecorationBufferBlock) ? vk::DescriptorType::eStorageBuffer
+                                                                              : vk::DescriptorType::eUniformBuffer;
+            case Spv::StorageUniformConstant:
+                switch (info.op) {
+                    case Spv::OpTypeSampler:
+                        return vk::DescriptorType::eSampler;
+                    case Spv::OpTypeSampledImage:
+                        return vk::DescriptorType::eCombinedImageSampler;
+                    case Spv::OpTypeImage: {
+                        uint32_t dim = info.operands[1];
+                        bool storageImage = info.operands[5] == 2;
+                        if (dim == Spv::DimSubpassData) return vk::DescriptorType::eInputAttachment;
+                        if (dim == Spv::DimBuffer) {
+                            return storageImage ? vk::DescriptorType::eStorageTexelBuffer
+                                                : vk::DescriptorType::eUniformTexelBuffer;
+                        }
+                        return storageImage ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+                    }
+                    default:
+                        return {};
+                }
+            default:
+                return {};
+        }
+    }
+
+    static std::optional<ShaderReflection::Input> ToInput(const Module& module, uint32_t location, uint32_t type) {
+        uint32_t components = 1;
+        if (module.types.contains(type) && module.types.at(type).op == Spv::OpTypeVector) {
+            components = module.types.at(type).operands[1];
+            type = module.types.at(type).operands[0];
+        }
+        if (!module.types.contains(type) || components < 1 || components > 4) return {};
+
+        const auto& scalar = module.types.at(type);
+        if (scalar.operands.empty() || scalar.operands[0] != 32) return {};
+        static constexpr std::array floats{ vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat,
+                                            vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat };
+        static constexpr std::array ints{ vk::Format::eR32Sint, vk::Format::eR32G32Sint,
+                                          vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint };
+        static constexpr std::array uints{ vk::Format::eR32Uint, vk::Format::eR32G32Uint,
+                                           vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint };
+
+        vk::Format format;
+        if (scalar.op == Spv::OpTypeFloat) {
+            format = floats[components - 1];
+        } else if (scalar.op == Spv::OpTypeInt) {
+            format = scalar.operands[1] ? ints[components - 1] : uints[components - 1];
+        } else {
+            return {};
+        }
+        return ShaderReflection::Input{ location, format, components * 4 };
+    }
+
+    std::optional<ShaderReflection> ReflectShader(std::span<const uint32_t> code, std::string_view name) {
+        if (code.size() < 5 || code[0] != Spv::Magic) {
+            Log::Core::Error("{} is not a SPIR-V module", name);
+            return {};
+        }
+
+        Module module;
+        for (size_t i = 5; i < code.size();) {
+            uint32_t wordCount = code[i] >> 16;
+            uint32_t op = code[i] & 0xffff;
+            if (wordCount == 0 || i + wordCount > code.size()) {
+                Log::Core::Error("{} is truncated", name);
+                return {};
+            }
+            auto words = code.subspan(i + 1, wordCount - 1);
+            i += wordCount;
+
+            switch (op) {
+                case Spv::OpEntryPoint:
+                    if (!module.executionModel) module.executionModel = words[0];
+                    break;
+                case Spv::OpDecorate:
+                    module.decorations[words[0]][words[1]] = words.size() > 2 ? words[2] : 0;
+                    break;
+                case Spv::OpMemberDecorate:
+                    module.memberDecorations[words[0]][words[1]][words[2]] = words.size() > 3 ? words[3] : 0;
+                    break;
+                case Spv::OpConstant:
+                case Spv::OpSpecConstant:
+                    module.constants[words[1]] = words[2];
+                    break;
+                case Spv::OpVariable:
+                    module.variables.push_back({ words[1], words[0], words[2] });
+                    break;
+                default:
+                    if (op >= Spv::OpTypeVoid && op <= Spv::OpTypePointer && !words.empty()) {
+                        module.types[words[0]] = { op, words.subspan(1) };
+                    }
+                    break;
+            }
+        }
+
+        auto stage = module.executionModel ? ToStage(*module.executionModel) : std::nullopt;
+        if (!stage) {
+            Log::Core::Error("{} has no supported entry point", name);
+            return {};
+        }
+
+        ShaderReflection out{ .stage = *stage };
+        for (const auto& variable: module.variables) {
+            // Variables are always pointers, everything below is about the pointee
+            const auto& pointer = module.types.at(variable.type);
+            uint32_t type = pointer.operands[1];
+
+            if (variable.storage == Spv::StoragePushConstant) {
+                out.pushConstantSize = std::max(out.pushConstantSize, module.GetSize(type));
+                continue;
+            }
+
+            if (variable.storage == Spv::StorageInput) {
+                auto location = module.GetDecoration(variable.id, Spv::DecorationLocation);
+                if (out.stage != vk::ShaderStageFlagBits::eVertex || !location ||
+                    module.GetDecoration(variable.id, Spv::DecorationBuiltIn)) {
+                    continue;
+                }
+                auto input = ToInput(module, *location, type);
+                if (!input) {
+                    Log::Core::Error("{}: vertex input at location {} isn't a 32 bit scalar or vector", name,
+                                     *location);
+                    return {};
+                }
+                out.inputs.push_back(*input);
+                continue;
+            }
+
+            auto set = module.GetDecoration(variable.id, Spv::DecorationDescriptorSet);
+            auto binding = module.GetDecoration(variable.id, Spv::DecorationBinding);
+            if (!set || !binding) continue;
+
+            uint32_t count = 1;
+            bool resolved = true;
+            uint32_t element = module.StripArrays(type, count, resolved);
+            if (!resolved) {
+                Log::Core::Error("{}: array size at set {} binding {} isn't a constant, assuming {}", name, *set,
+                                 *binding, count);
+            }
+            auto descriptorType = ToDescriptorType(module, variable.storage, element);
+            if (!descriptorType) {
+                Log::Core::Error("{}: unsupported resource at set {} binding {}", name, *set, *binding);
+                return {};
+            }
+            out.bindings[*set][*binding] = vk::DescriptorSetLayoutBinding(*binding, *descriptorType, count,
+                                                                          out.stage);
+        }
+
+        std::sort(out.inputs.begin(), out.inputs.end(), [](const auto& a, const auto& b) {
+            return a.location < b.location;
+        });
+        return out;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+namespace Iris::Vulkan {
+    // Interface of a SPIR-V module, as far as building a pipeline for it is concerned
+    struct ShaderReflection {
+        struct Input {
+            uint32_t location;
+            vk::Format format;
+            uint32_t size;
+        };
+
+        vk::ShaderStageFlagBits stage = vk::ShaderStageFlagBits::eVertex;
+        // set -> binding, runtime sized arrays have a descriptor count of 0. Arrays sized by a specialization
+        // constant use its default, PipelineBuilder::SetArraySize overrides it.
+        std::map<uint32_t, std::map<uint32_t, vk::DescriptorSetLayoutBinding>> bindings;
+        uint32_t pushConstantSize = 0;  // 0 without a push constant block
+        std::vector<Input> inputs;      // vertex shaders only, sorted by location
+    };
+
+    // Reads the stage, descriptor bindings, push constant block and vertex inputs of a module with a single
+    // entry point. Logs and returns nothing for code that isn't valid SPIR-V.
+    std::optional<ShaderReflection> ReflectShader(std::span<const uint32_t> code, std::string_view name);
+}
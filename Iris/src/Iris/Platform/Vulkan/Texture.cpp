@@ -1,133 +1,170 @@
 #include "Texture.hpp"
-#include <stb_image.h>
 
 namespace Iris::Vulkan {
-    template <>
-    Texture<float>::Texture(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx,
-                            std::string_view path, uint32_t desiredChannels)
-            : m_Ctx(std::move(ctx)), m_UCtx(std::move(uctx)) {
+    // Decoding failures are fatal here, these are textures the renderer itself can't do without
+    static std::shared_ptr<const ImageData> LoadOrExit(std::string_view path, ImageUsage usage) {
+        auto image = ImageData::Load(std::string(path), usage);
+        if (!image) std::exit(1);
+        return image;
+    }
 
-        int width, height, channels;
-        float* data = stbi_loadf(path.data(), &width, &height, &channels, static_cast<int>(desiredChannels));
-        if (data == nullptr) {
-            Log::Core::Error("Failed to load texture {}, reason: ", path, stbi_failure_reason());
-            std::exit(1);
+    static vk::Format ToVkFormat(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::RGBA8: return vk::Format::eR8G8B8A8Unorm;
+            case PixelFormat::RGBA8Srgb: return vk::Format::eR8G8B8A8Srgb;
+            case PixelFormat::RGBA16F: return vk::Format::eR16G16B16A16Sfloat;
+            case PixelFormat::BC1Srgb: return vk::Format::eBc1RgbSrgbBlock;
+            case PixelFormat::BC3Srgb: return vk::Format::eBc3SrgbBlock;
+            case PixelFormat::BC5: return vk::Format::eBc5UnormBlock;
+            case PixelFormat::BC7Srgb: return vk::Format::eBc7SrgbBlock;
+        }
+        return vk::Format::eUndefined;
+    }
+
+    // Every level is blitted from the one above it, all levels end up ready for sampling
+    static void RecordMipChain(vk::CommandBuffer& buf, vk::Image image, glm::uvec2 size, uint32_t levels) {
+        auto levelRange = [](uint32_t level) {
+            return vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1);
         };
 
-        m_Size = { width, height };
-
-        m_StagingBuffer = std::make_unique<Buffer<float>>(
-                m_Ctx, vk::BufferUsageFlagBits::eTransferSrc, data, desiredChannels * width * height);
-        stbi_image_free(data);
-
-        vk::Format imageFormat;
-        switch (desiredChannels) {
-            case 4:
-                imageFormat = vk::Format::eR32G32B32A32Sfloat;
-                break;
-            case 3:
-                imageFormat = vk::Format::eR32G32B32Sfloat;
-                break;
-            case 2:
-                imageFormat = vk::Format::eR32G32Sfloat;
-                break;
-            case 1:
-                imageFormat = vk::Format::eR32Sfloat;
-                break;
-            default:
-                Log::Core::Error("Unknown format for texture {}", path);
-                std::exit(-1);
+        auto extent = glm::ivec2(size);
+        for (uint32_t level = 1; level < levels; ++level) {
+            std::array barriers{
+                    vk::ImageMemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead,
+                                           vk::ImageLayout::eTransferDstOptimal,
+                                           vk::ImageLayout::eTransferSrcOptimal, VK_QUEUE_FAMILY_IGNORED,
+                                           VK_QUEUE_FAMILY_IGNORED, image, levelRange(level - 1)),
+                    vk::ImageMemoryBarrier({}, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined,
+                                           vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED,
+                                           VK_QUEUE_FAMILY_IGNORED, image, levelRange(level))
+            };
+            buf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {},
+                                {}, barriers);
+
+            glm::ivec2 next = glm::max(extent / 2, glm::ivec2(1));
+            vk::ImageBlit blit(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level - 1, 0, 1),
+                               { vk::Offset3D(0, 0, 0), vk::Offset3D(extent.x, extent.y, 1) },
+                               vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, 0, 1),
+                               { vk::Offset3D(0, 0, 0), vk::Offset3D(next.x, next.y, 1) });
+            buf.blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal,
+                          blit, vk::Filter::eLinear);
+            extent = next;
         }
 
-        vk::FormatProperties formatProperties = m_Ctx->GetPhysDevice().getFormatProperties(imageFormat);
+        std::array barriers{
+                vk::ImageMemoryBarrier(vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead,
+                                       vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                       VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image,
+                                       vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, levels - 1, 0, 1)),
+                vk::ImageMemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+                                       vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                       VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, levelRange(levels - 1))
+        };
+        buf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {},
+                            {}, barriers);
+    }
 
-        vk::ImageTiling tiling;
-        if (formatProperties.linearTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage) {
-            tiling = vk::ImageTiling::eLinear;
-        } else if (formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage) {
-            tiling = vk::ImageTiling::eOptimal;
-        } else {
-            Log::Core::Critical("SampledImage is not supported for texture format.");
+    template <>
+    Texture<float>::Texture(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx,
+                            std::string_view path, ImageUsage usage, const SamplerDesc& sampler)
+            : Texture(std::move(ctx), std::move(uctx), *LoadOrExit(path, usage), sampler) {}
+
+    template <>
+    Texture<float>::Texture(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx,
+                            const ImageData& image, const SamplerDesc& sampler, uint32_t firstLevel)
+            : m_Ctx(std::move(ctx)), m_UCtx(std::move(uctx)) {
+        firstLevel = std::min(firstLevel, static_cast<uint32_t>(image.levels.size()) - 1);
+        m_Size = image.levels[firstLevel].size;
+        auto storedLevels = static_cast<uint32_t>(image.levels.size()) - firstLevel;
+
+        // Uploaded exactly as stored, compressed images stay compressed in VRAM. Levels are contiguous, so
+        // skipping the first ones is a single offset.
+        uint64_t texelOffset = image.levels[firstLevel].offset;
+        auto texels = image.GetTexels().subspan(texelOffset);
+        auto stagingBuffer = std::make_shared<Buffer<std::byte>>(
+                m_Ctx, vk::BufferUsageFlagBits::eTransferSrc, texels.data(), texels.size());
+
+        vk::Format imageFormat = ToVkFormat(image.format);
+        auto features = m_Ctx->GetPhysDevice().getFormatProperties(imageFormat).optimalTilingFeatures;
+        if (!(features & vk::FormatFeatureFlagBits::eSampledImage)) {
+            Log::Core::Critical("SampledImage is not supported for texture format {}.", ToString(image.format));
             std::exit(1);
         }
 
+        // Block compressed images bring their levels from the texture cache, the rest get theirs blitted
+        constexpr auto blitFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst |
+                                      vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+        uint32_t levels = storedLevels;
+        if (storedLevels == 1 && (features & blitFeatures) == blitFeatures) {
+            levels = static_cast<uint32_t>(std::floor(std::log2(std::max(m_Size.x, m_Size.y)))) + 1;
+        }
+        bool generateMips = levels > storedLevels;
+
+        vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+        if (generateMips) usage |= vk::ImageUsageFlagBits::eTransferSrc;
         vk::ImageCreateInfo imageCreateInfo(vk::ImageCreateFlags(),
                                             vk::ImageType::e2D,
                                             imageFormat,
                                             vk::Extent3D(m_Size.x, m_Size.y, 1),
-                                            1,
+                                            levels,
                                             1,
                                             vk::SampleCountFlagBits::e1,
-                                            tiling,
-                                            vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
+                                            vk::ImageTiling::eOptimal,
+                                            usage);
         m_Image = m_Ctx->GetDevice().createImage(imageCreateInfo);
 
-        vk::PhysicalDeviceMemoryProperties memoryProperties = m_Ctx->GetPhysDevice().getMemoryProperties();
-        vk::MemoryRequirements memoryRequirements = m_Ctx->GetDevice().getImageMemoryRequirements(m_Image);
-        uint32_t typeBits = memoryRequirements.memoryTypeBits;
-        auto typeIndex = uint32_t(~0);
-        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
-            if ((typeBits & 1) &&
-                ((memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) ==
-                 vk::MemoryPropertyFlagBits::eDeviceLocal)) {
-                typeIndex = i;
-                break;
-            }
-            typeBits >>= 1;
-        }
-        assert(typeIndex != uint32_t(~0));
-        m_MemorySize = memoryRequirements.size;
-        m_Memory = m_Ctx->GetDevice().allocateMemory(vk::MemoryAllocateInfo(m_MemorySize, typeIndex));
-
-        m_Ctx->GetDevice().bindImageMemory(m_Image, m_Memory, 0);
+        m_Allocation = m_Ctx->GetAllocator().AllocateImage(m_Image, vk::ImageTiling::eOptimal,
+                                                           vk::MemoryPropertyFlagBits::eDeviceLocal);
+        m_MemorySize = m_Allocation.size;
 
         m_ImageView = m_Ctx->GetDevice().createImageView(vk::ImageViewCreateInfo(
                 vk::ImageViewCreateFlags(), m_Image, vk::ImageViewType::e2D, imageFormat, {},
-                { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }));
-
-        vk::BufferImageCopy copyRegion(
-                0,
-                m_Size.x,
-                m_Size.y,
-                vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
-                vk::Offset3D(0, 0, 0),
-                vk::Extent3D(m_Size.x, m_Size.y, 1));
+                { vk::ImageAspectFlagBits::eColor, 0, levels, 0, 1 }));
+
+        std::vector<vk::BufferImageCopy> copyRegions;
+        for (uint32_t level = 0; level < storedLevels; ++level) {
+            const auto& source = image.levels[firstLevel + level];
+            copyRegions.emplace_back(
+                    source.offset - texelOffset,
+                    0,
+                    0,
+                    vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, 0, 1),
+                    vk::Offset3D(0, 0, 0),
+                    vk::Extent3D(source.size.x, source.size.y, 1));
+        }
 
-        vk::ImageSubresourceRange imageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+        vk::ImageSubresourceRange uploadedRange(vk::ImageAspectFlagBits::eColor, 0, storedLevels, 0, 1);
 
-        m_UCtx->SubmitCommand([&](vk::CommandBuffer& buf) {
+        // Barrier and copy are batched with the other pending uploads, the staging buffer is released once
+        // the batch has executed
+        m_Ticket = m_UCtx->Enqueue([&](vk::CommandBuffer& buf) {
             vk::ImageMemoryBarrier imageMemoryBarrier(
                     vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined,
-                    vk::ImageLayout::eTransferDstOptimal, {}, {}, m_Image, imageSubresourceRange);
+                    vk::ImageLayout::eTransferDstOptimal, {}, {}, m_Image, uploadedRange);
 
-            buf.pipelineBarrier(vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer),
+            buf.pipelineBarrier(vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe),
                                 vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer), vk::DependencyFlags(),
                                 {}, {}, imageMemoryBarrier);
-        });
-
-        m_UCtx->SubmitCommand([&](vk::CommandBuffer& buf) {
-            buf.copyBufferToImage(m_StagingBuffer->m_Buffer, m_Image, vk::ImageLayout::eTransferDstOptimal,
-                                  copyRegion);
 
+            buf.copyBufferToImage(stagingBuffer->m_Buffer, m_Image, vk::ImageLayout::eTransferDstOptimal,
+                                  copyRegions);
         });
-        m_UCtx->SubmitCommand([&](vk::CommandBuffer& buf) {
-            vk::ImageMemoryBarrier imageMemoryBarrier(
-                    vk::AccessFlagBits::eTransferWrite, vk::AccessFlags(),
-                    vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
-                    {}, {}, m_Image, imageSubresourceRange);
-
-            buf.pipelineBarrier(vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer),
-                                vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer),
-                                vk::DependencyFlags(),
-                                {},
-                                {},
-                                imageMemoryBarrier);
-        });
-
-        m_StagingBuffer.reset();
-
-        m_Sampler = m_Ctx->GetDevice().createSampler(vk::SamplerCreateInfo(vk::SamplerCreateFlags(
+        m_UCtx->KeepAlive(std::move(stagingBuffer));
+
+        if (generateMips) {
+            // Blits need a graphics queue, so level 0 is handed over as is and the chain is built there
+            m_UCtx->ReleaseImage(m_Image, uploadedRange, vk::ImageLayout::eTransferDstOptimal,
+                                 vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits::eTransfer,
+                                 vk::AccessFlagBits::eTransferRead);
+            m_UCtx->EnqueueGraphics([image = m_Image, size = m_Size, levels](vk::CommandBuffer& buf) {
+                RecordMipChain(buf, image, size, levels);
+            });
+        } else {
+            m_UCtx->ReleaseImage(m_Image, uploadedRange, vk::ImageLayout::eTransferDstOptimal,
+                                 vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader,
+                                 vk::AccessFlagBits::eShaderRead);
+        }
 
-        )));
+        m_Sampler = m_Ctx->GetSamplerCache().Get(sampler);
     }
-}
\ No newline at end of file
+}
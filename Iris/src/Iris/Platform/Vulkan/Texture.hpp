@@ -2,13 +2,19 @@
 #include "Iris/Platform/Vulkan/Context.hpp"
 #include "Iris/Platform/Vulkan/Buffer.hpp"
 #include "Iris/Platform/Vulkan/UploadContext.hpp"
+#include "Iris/Renderer/Image.hpp"
 
 namespace Iris::Vulkan {
     template <typename T>
     class Texture final {
     public:
         Texture(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx,
-                std::string_view path, uint32_t desiredChannels = 3);
+                std::string_view path, ImageUsage usage = ImageUsage::Color, const SamplerDesc& sampler = {});
+        // Uploads an image decoded elsewhere, e.g. by the asset loader. Images without stored mip levels get a
+        // full chain blitted on the GPU. Stored levels above firstLevel are left out, the texture streamer
+        // uses that to keep only the coarse levels of distant textures resident.
+        Texture(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx, const ImageData& image,
+                const SamplerDesc& sampler = {}, uint32_t firstLevel = 0);
 
         Texture(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx,
                 glm::uvec2 size, vk::Format format, vk::ImageUsageFlags flags) : m_Ctx(std::move(ctx)),
@@ -16,14 +22,8 @@ namespace Iris::Vulkan {
                                                                                  m_Size(size) {
             vk::FormatProperties formatProperties = m_Ctx->GetPhysDevice().getFormatProperties(format);
 
-            vk::ImageTiling tiling;
-            if (formatProperties.linearTilingFeatures &
-                (vk::FormatFeatureFlagBits::eTransferSrc | vk::FormatFeatureFlagBits::eColorAttachment)) {
-                tiling = vk::ImageTiling::eLinear;
-            } else if (formatProperties.optimalTilingFeatures &
-                       (vk::FormatFeatureFlagBits::eTransferSrc | vk::FormatFeatureFlagBits::eColorAttachment)) {
-                tiling = vk::ImageTiling::eOptimal;
-            } else {
+            if (!(formatProperties.optimalTilingFeatures &
+                  (vk::FormatFeatureFlagBits::eTransferSrc | vk::FormatFeatureFlagBits::eColorAttachment))) {
                 Log::Core::Critical(
                         "ColorAttachment | TransferSrc  is not supported for texture format.");
                 std::exit(1);
@@ -40,43 +40,42 @@ namespace Iris::Vulkan {
                                                 flags);
             m_Image = m_Ctx->GetDevice().createImage(imageCreateInfo);
 
-            vk::PhysicalDeviceMemoryProperties memoryProperties = m_Ctx->GetPhysDevice().getMemoryProperties();
-            vk::MemoryRequirements memoryRequirements = m_Ctx->GetDevice().getImageMemoryRequirements(m_Image);
-            uint32_t typeBits = memoryRequirements.memoryTypeBits;
-            auto typeIndex = uint32_t(~0);
-            for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
-                if ((typeBits & 1) &&
-                    ((memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) ==
-                     vk::MemoryPropertyFlagBits::eDeviceLocal)) {
-                    typeIndex = i;
-                    break;
+            // Transient attachments get lazily allocated memory where the device has it, so on tilers they are
+            // never backed by real memory. Elsewhere they are ordinary device memory.
+            vk::MemoryPropertyFlags memoryFlags = vk::MemoryPropertyFlagBits::eDeviceLocal;
+            auto strategy = AllocationStrategy::Buddy;
+            if (flags & vk::ImageUsageFlagBits::eTransientAttachment) {
+                auto lazy = memoryFlags | vk::MemoryPropertyFlagBits::eLazilyAllocated;
+                auto typeBits = m_Ctx->GetDevice().getImageMemoryRequirements(m_Image).memoryTypeBits;
+                if (m_Ctx->GetAllocator().HasMemoryType(typeBits, lazy)) {
+                    memoryFlags = lazy;
+                    strategy = AllocationStrategy::Dedicated;
                 }
-                typeBits >>= 1;
             }
-            assert(typeIndex != uint32_t(~0));
-            m_MemorySize = memoryRequirements.size;
-            m_Memory = m_Ctx->GetDevice().allocateMemory(vk::MemoryAllocateInfo(m_MemorySize, typeIndex));
-
-            m_Ctx->GetDevice().bindImageMemory(m_Image, m_Memory, 0);
+            m_Allocation = m_Ctx->GetAllocator().AllocateImage(m_Image, vk::ImageTiling::eOptimal, memoryFlags,
+                                                               strategy);
+            m_MemorySize = m_Allocation.size;
 
             m_ImageView = m_Ctx->GetDevice().createImageView(vk::ImageViewCreateInfo(
                     vk::ImageViewCreateFlags(), m_Image, vk::ImageViewType::e2D, format, {},
                     { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }));
 
-            m_Sampler = m_Ctx->GetDevice().createSampler(vk::SamplerCreateInfo(vk::SamplerCreateFlags(
-
-            )));
+            m_Sampler = m_Ctx->GetSamplerCache().Get({ .magFilter = vk::Filter::eNearest,
+                                                        .minFilter = vk::Filter::eNearest,
+                                                        .mipmapMode = vk::SamplerMipmapMode::eNearest,
+                                                        .addressMode = vk::SamplerAddressMode::eClampToEdge,
+                                                        .maxAnisotropy = 1.f });
         }
 
-        Texture(Texture&& rhs) noexcept: m_Size(rhs.m_Size), m_Sampler(rhs.m_Sampler),
+        Texture(Texture&& rhs) noexcept: m_Size(rhs.m_Size), m_Ticket(rhs.m_Ticket), m_Sampler(rhs.m_Sampler),
                                          m_Ctx(rhs.m_Ctx),
                                          m_UCtx(rhs.m_UCtx),
                                          m_StagingBuffer(std::move(rhs.m_StagingBuffer)),
-                                         m_Image(rhs.m_Image), m_Memory(rhs.m_Memory),
+                                         m_Image(rhs.m_Image), m_Allocation(rhs.m_Allocation),
                                          m_ImageView(rhs.m_ImageView) {
             rhs.m_Sampler = nullptr;
             rhs.m_Image = nullptr;
-            rhs.m_Memory = nullptr;
+            rhs.m_Allocation = {};
             rhs.m_ImageView = nullptr;
         }
 
@@ -95,22 +94,20 @@ namespace Iris::Vulkan {
 
             vk::ImageSubresourceRange imageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
 
+            // Readbacks are needed right away, so this blocks until the copy has finished
             m_UCtx->SubmitCommand([&](vk::CommandBuffer& buf) {
-                vk::ImageMemoryBarrier imageMemoryBarrier(
+                vk::ImageMemoryBarrier toTransfer(
                         vk::AccessFlags(), vk::AccessFlagBits::eTransferRead, vk::ImageLayout::eColorAttachmentOptimal,
                         vk::ImageLayout::eTransferSrcOptimal, {}, {}, m_Image, imageSubresourceRange);
 
                 buf.pipelineBarrier(vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer),
                                     vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer), vk::DependencyFlags(),
-                                    {}, {}, imageMemoryBarrier);
-            });
+                                    {}, {}, toTransfer);
 
-            m_UCtx->SubmitCommand([&](vk::CommandBuffer& buf) {
                 buf.copyImageToBuffer(m_Image, vk::ImageLayout::eTransferSrcOptimal, m_StagingBuffer->m_Buffer,
                                       copyRegion);
-            });
-            m_UCtx->SubmitCommand([&](vk::CommandBuffer& buf) {
-                vk::ImageMemoryBarrier imageMemoryBarrier(
+
+                vk::ImageMemoryBarrier toAttachment(
                         vk::AccessFlagBits::eTransferRead, vk::AccessFlags(),
                         vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eColorAttachmentOptimal,
                         {}, {}, m_Image, imageSubresourceRange);
@@ -120,7 +117,7 @@ namespace Iris::Vulkan {
                                     vk::DependencyFlags(),
                                     {},
                                     {},
-                                    imageMemoryBarrier);
+                                    toAttachment);
             });
         }
 
@@ -132,16 +129,24 @@ namespace Iris::Vulkan {
             m_StagingBuffer->Unmap();
         }
 
+        // Completes once the texel upload has executed, 0 for textures without an upload
+        [[nodiscard]] UploadTicket GetTicket() const {
+            return m_Ticket;
+        }
+
+        [[nodiscard]] vk::Image GetImage() const {
+            return m_Image;
+        }
+
         [[nodiscard]] vk::DescriptorImageInfo GetDescriptor() const {
             return { m_Sampler, m_ImageView, vk::ImageLayout::eShaderReadOnlyOptimal };
         }
 
         ~Texture() {
             if (!m_Ctx) return;
-            m_Ctx->GetDevice().destroySampler(m_Sampler);
             m_Ctx->GetDevice().destroyImageView(m_ImageView);
-            m_Ctx->GetDevice().freeMemory(m_Memory);
             m_Ctx->GetDevice().destroyImage(m_Image);
+            m_Ctx->GetAllocator().Free(m_Allocation);
         }
 
     private:
@@ -149,10 +154,11 @@ namespace Iris::Vulkan {
         std::shared_ptr<UploadContext> m_UCtx{};
         glm::uvec2 m_Size{};
         size_t m_MemorySize{};
-        vk::Sampler m_Sampler;
+        UploadTicket m_Ticket = 0;
+        vk::Sampler m_Sampler;  // owned by the context's sampler cache
         std::unique_ptr<Buffer<T>> m_StagingBuffer;
         vk::Image m_Image;
-        vk::DeviceMemory m_Memory;
+        Allocation m_Allocation;
         vk::ImageView m_ImageView;
     };
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "TextureStreamer.hpp"
+
+namespace Iris::Vulkan {
+    // Levels up to this size are always resident, so something sensible can be drawn right away
+    static constexpr uint32_t MinResidentSize = 64;
+    // Every swap re-uploads a texture, spreading them out keeps frame times even
+    static constexpr uint32_t MaxSwapsPerFrame = 2;
+    // Frames a texture has to want less before finer levels are dropped while under budget
+    static constexpr uint32_t DowngradeDelay = 120;
+
+    TextureStreamer::TextureStreamer(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx,
+                                     uint64_t budget, const SamplerDesc& sampler)
+            : m_Ctx(std::move(ctx)), m_UCtx(std::move(uctx)), m_Budget(budget), m_Sampler(sampler) {}
+
+    Texture<float> TextureStreamer::Create(const ImageData& image) const {
+        return { m_Ctx, m_UCtx, image, m_Sampler, GetCoarsestLevel(image) };
+    }
+
+    void TextureStreamer::Track(Textures::Slot slot, std::string name, std::shared_ptr<const ImageData> image) {
+        Entry entry{ .name = std::move(name), .image = std::move(image) };
+        entry.coarsestLevel = GetCoarsestLevel(*entry.image);
+        entry.residentLevel = entry.coarsestLevel;
+        m_ResidentBytes += GetBytes(*entry.image, entry.residentLevel);
+        m_Entries[slot] = std::move(entry);
+    }
+
+    void TextureStreamer::Untrack(Textures::Slot slot) {
+        auto it = m_Entries.find(slot);
+        if (it == m_Entries.end()) return;
+        m_ResidentBytes -= GetBytes(*it->second.image, it->second.residentLevel);
+        m_Entries.erase(it);
+    }
+
+    void TextureStreamer::Request(Textures::Slot slot, float pixels) {
+        auto it = m_Entries.find(slot);
+        if (it != m_Entries.end()) it->second.pixels = std::max(it->second.pixels, pixels);
+    }
+
+    void TextureStreamer::Update(Textures& textures, uint64_t frame,
+                                 const std::function<void(Textures::Slot)>& onSwap) {
+        // The coarse levels are always paid for, the rest of the budget goes to the largest uses first
+        std::vector<std::pair<Textures::Slot, Entry*>> order;
+        uint64_t total = 0;
+        for (auto& [slot, entry]: m_Entries) {
+            total += GetBytes(*entry.image, entry.coarsestLevel);
+            if (entry.coarsestLevel > 0) order.emplace_back(slot, &entry);
+        }
+        std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+            return a.second->pixels > b.second->pixels;
+        });
+
+        struct Swap {
+            Textures::Slot slot;
+            Entry* entry;
+            uint32_t level;
+        };
+        std::vector<Swap> upgrades, downgrades;
+        for (auto& [slot, entry]: order) {
+            uint64_t floor = GetBytes(*entry->image, entry->coarsestLevel);
+            // Released textures keep what they have until eviction, a swap would outlive the slot
+            if (textures.IsReleased(slot)) {
+                total += GetBytes(*entry->image, entry->residentLevel) - floor;
+                entry->pixels = 0.f;
+                continue;
+            }
+            uint32_t target = GetWantedLevel(*entry);
+            while (target < entry->coarsestLevel && total + GetBytes(*entry->image, target) - floor > m_Budget) {
+                ++target;
+            }
+            total += GetBytes(*entry->image, target) - floor;
+
+            entry->unseenFrames = target > entry->residentLevel ? entry->unseenFrames + 1 : 0;
+            if (target < entry->residentLevel) {
+                upgrades.push_back({ slot, entry, target });
+            } else if (target > entry->residentLevel &&
+                       (m_ResidentBytes > m_Budget || entry->unseenFrames > DowngradeDelay)) {
+                downgrades.push_back({ slot, entry, target });
+            }
+            entry->pixels = 0.f;
+        }
+
+        // Dropping levels first makes room for the upgrades, both already sorted by priority
+        uint32_t swaps = 0;
+        auto apply = [&](const Swap& swap) {
+            if (swaps++ >= MaxSwapsPerFrame) return;
+            const auto& image = *swap.entry->image;
+            m_ResidentBytes += GetBytes(image, swap.level) - GetBytes(image, swap.entry->residentLevel);
+            swap.entry->residentLevel = swap.level;
+            swap.entry->unseenFrames = 0;
+            textures.Replace(swap.slot, Texture<float>(m_Ctx, m_UCtx, image, m_Sampler, swap.level), frame);
+            onSwap(swap.slot);
+        };
+        std::for_each(downgrades.rbegin(), downgrades.rend(), apply);
+        std::for_each(upgrades.begin(), upgrades.end(), apply);
+    }
+
+    std::vector<TextureResidency> TextureStreamer::GetResidency() const {
+        std::vector<TextureResidency> out;
+        for (const auto& [slot, entry]: m_Entries) {
+            out.push_back({
+                    .name = entry.name,
+                    .size = entry.image->size,
+                    .levelCount = static_cast<uint32_t>(entry.image->levels.size()),
+                    .residentLevel = entry.residentLevel,
+                    .wantedLevel = GetWantedLevel(entry),
+                    .residentBytes = GetBytes(*entry.image, entry.residentLevel)
+            });
+        }
+        std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+        return out;
+    }
+
+    uint32_t TextureStreamer::GetCoarsestLevel(const ImageData& image) {
+        // Only images with stored levels can stream, the others get their chain blitted on upload
+        if (image.levels.size() <= 1) return 0;
+        for (uint32_t level = 0; level < image.levels.size(); ++level) {
+            if (std::max(image.levels[level].size.x, image.levels[level].size.y) <= MinResidentSize) return level;
+        }
+        return static_cast<uint32_t>(image.levels.size()) - 1;
+    }
+
+    uint64_t TextureStreamer::GetBytes(const ImageData& image, uint32_t firstLevel) {
+        if (image.levels.empty()) return 0;
+
+        // Counted from the extent and format of every level on the GPU. Images with a single stored level get
+        // the rest of their chain blitted on upload (see Texture), their stored bytes would leave it out.
+        bool blitted = image.levels.size() == 1;
+        firstLevel = std::min(firstLevel, static_cast<uint32_t>(image.levels.size()) - 1);
+        glm::uvec2 size = image.levels[firstLevel].size;
+        uint64_t bytes = 0;
+        for (uint32_t level = firstLevel;; ++level) {
+            bytes += GetImageBytes(image.format, size);
+            if (blitted ? size == glm::uvec2(1) : level + 1 == image.levels.size()) break;
+            size = blitted ? glm::max(size / 2u, glm::uvec2(1)) : image.levels[level + 1].size;
+        }
+        return bytes;
+    }
+
+    uint32_t TextureStreamer::GetWantedLevel(const Entry& entry) {
+        if (entry.pixels <= 0.f) return entry.coarsestLevel;
+
+        // One texel per pixel, assuming the UVs span the surface once
+        float texels = static_cast<float>(std::max(entry.image->size.x, entry.image->size.y));
+        float level = std::floor(std::log2(std::max(texels / entry.pixels, 1.f)));
+        return std::min(static_cast<uint32_t>(level), entry.coarsestLevel);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "Iris/Platform/Vulkan/Texture.hpp"
+#include "Iris/Platform/Vulkan/ResourceRegistry.hpp"
+
+namespace Iris::Vulkan {
+    // Residency of one streamed texture, for the stats UI
+    struct TextureResidency {
+        std::string name;
+        glm::uvec2 size{};
+        uint32_t levelCount = 0;
+        uint32_t residentLevel = 0; // finest level on the GPU
+        uint32_t wantedLevel = 0;   // finest level any visible use needs
+        uint64_t residentBytes = 0;
+    };
+
+    // Keeps the material textures that have a stored mip chain (the block compressed ones) resident only down
+    // to the level their largest on-screen use needs. New textures start with their coarse levels, finer
+    // levels stream in by projected screen size, largest first, while the total stays under the budget.
+    // Changing residency re-uploads the texture from its mapped cache and swaps it in the registry, the old
+    // image lives until the frames using it have completed. Textures without stored levels are always fully
+    // resident and count towards the budget.
+    class TextureStreamer final {
+    public:
+        using Textures = ResourceRegistry<Texture<float>>;
+
+        TextureStreamer(std::shared_ptr<Context> ctx, std::shared_ptr<UploadContext> uctx, uint64_t budget,
+                        const SamplerDesc& sampler);
+
+        // The GPU texture a new image starts out with
+        Texture<float> Create(const ImageData& image) const;
+        void Track(Textures::Slot slot, std::string name, std::shared_ptr<const ImageData> image);
+        void Untrack(Textures::Slot slot);
+
+        // Called for every visible use of a texture each frame, with the projected size of the surface in pixels
+        void Request(Textures::Slot slot, float pixels);
+
+        // Picks this frame's residency and swaps at most a few textures, onSwap rewrites the slot's descriptor
+        void Update(Textures& textures, uint64_t frame, const std::function<void(Textures::Slot)>& onSwap);
+
+        [[nodiscard]] std::vector<TextureResidency> GetResidency() const;
+        [[nodiscard]] uint64_t GetResidentBytes() const { return m_ResidentBytes; }
+        [[nodiscard]] uint64_t GetBudget() const { return m_Budget; }
+    private:
+        struct Entry {
+            std::string name;
+            std::shared_ptr<const ImageData> image;
+            uint32_t residentLevel = 0;
+            uint32_t coarsestLevel = 0;     // never streamed out further than this
+            float pixels = 0.f;             // largest request this frame
+            uint32_t unseenFrames = 0;
+        };
+
+        [[nodiscard]] static uint32_t GetCoarsestLevel(const ImageData& image);
+        [[nodiscard]] static uint64_t GetBytes(const ImageData& image, uint32_t firstLevel);
+        [[nodiscard]] static uint32_t GetWantedLevel(const Entry& entry);
+    private:
+        std::shared_ptr<Context> m_Ctx;
+        std::shared_ptr<UploadContext> m_UCtx;
+        uint64_t m_Budget;
+        SamplerDesc m_Sampler;
+
+        std::unordered_map<Textures::Slot, Entry> m_Entries;
+        uint64_t m_ResidentBytes = 0;
+    };
+}
@@ -0,0 +1,42 @@
+#include "TransientArena.hpp"
+
+namespace Iris::Vulkan {
+    TransientArena::TransientArena(std::shared_ptr<Context> ctx, uint32_t frames, vk::DeviceSize frameCapacity)
+            : m_Ctx(std::move(ctx)) {
+        auto limits = m_Ctx->GetPhysDevice().getProperties().limits;
+        m_Alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+        m_FrameCapacity = (frameCapacity + m_Alignment - 1) & ~(m_Alignment - 1);
+
+        // Read by the graphics queue and by the culling pass on the compute queue
+        m_Buffer = std::make_unique<Buffer<uint8_t>>(
+                m_Ctx, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer,
+                static_cast<size_t>(m_FrameCapacity * frames),
+                std::vector<uint32_t>{ m_Ctx->GetGraphicsQueueFamilyIndex(), m_Ctx->GetComputeQueueFamilyIndex() });
+        m_Data = m_Buffer->MapPersistent();
+    }
+
+    void TransientArena::BeginFrame(uint32_t frameIndex) {
+        m_FrameBegin = frameIndex * m_FrameCapacity;
+        m_Head = m_FrameBegin;
+    }
+
+    uint32_t TransientArena::AllocateBytes(vk::DeviceSize size) {
+        vk::DeviceSize offset = m_Head;
+        vk::DeviceSize end = offset + size;
+        if (end > m_FrameBegin + m_FrameCapacity) {
+            Log::Core::Critical("Transient arena out of space: {} of {} bytes used, {} requested",
+                                m_Head - m_FrameBegin, m_FrameCapacity, size);
+            std::exit(1);
+        }
+        m_Head = (end + m_Alignment - 1) & ~(m_Alignment - 1);
+        return static_cast<uint32_t>(offset);
+    }
+
+    vk::DescriptorBufferInfo TransientArena::GetDescriptorBufferInfo(vk::DeviceSize range) const {
+        return { m_Buffer->m_Buffer, 0, range };
+    }
+
+    vk::DeviceSize TransientArena::GetUsed() const {
+        return m_Head - m_FrameBegin;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include "Iris/Platform/Vulkan/Context.hpp"
+#include "Iris/Platform/Vulkan/Buffer.hpp"
+
+namespace Iris::Vulkan {
+    template <typename T>
+    struct TransientSlice {
+        T* data;
+        uint32_t offset;    // dynamic offset to bind the slice with
+    };
+
+    // Per-frame uniform/storage data, bump allocated from one persistently mapped buffer that is split into a
+    // region per frame in flight. Slices are bound through dynamic descriptors, so the descriptors never change.
+    class TransientArena final {
+    public:
+        TransientArena(std::shared_ptr<Context> ctx, uint32_t frames, vk::DeviceSize frameCapacity = 4 * 1024 * 1024);
+
+        // Starts handing out slices from the given frame's region, the caller guarantees the GPU is done with it
+        void BeginFrame(uint32_t frameIndex);
+
+        template <typename T>
+        TransientSlice<T> Allocate(size_t count = 1) {
+            auto offset = AllocateBytes(count * sizeof(T));
+            return { reinterpret_cast<T*>(m_Data + offset), offset };
+        }
+
+        // Descriptor for a dynamic binding, range is the size of the largest slice bound through it
+        [[nodiscard]] vk::DescriptorBufferInfo GetDescriptorBufferInfo(vk::DeviceSize range) const;
+        [[nodiscard]] vk::DeviceSize GetUsed() const;
+    private:
+        uint32_t AllocateBytes(vk::DeviceSize size);
+    private:
+        std::shared_ptr<Context> m_Ctx;
+        std::unique_ptr<Buffer<uint8_t>> m_Buffer;
+        uint8_t* m_Data = nullptr;
+
+        vk::DeviceSize m_Alignment;
+        vk::DeviceSize m_FrameCapacity;
+        vk::DeviceSize m_FrameBegin = 0;
+        vk::DeviceSize m_Head = 0;
+    };
+}
@@ -8,35 +8,186 @@ namespace Iris::Vulkan {
         m_CommandPool = m_Ctx->GetDevice()
                 .createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
                                                              m_Ctx->GetTransferQueueFamilyIndex()));
-        m_CommandBuffer = m_Ctx->GetDevice().allocateCommandBuffers(
-                vk::CommandBufferAllocateInfo(m_CommandPool, vk::CommandBufferLevel::ePrimary, 1)).front();
 
-        m_TransferFence = m_Ctx->GetDevice().createFence(vk::FenceCreateInfo());
-        m_TransferSemaphore = m_Ctx->GetDevice().createSemaphore(vk::SemaphoreCreateInfo());
+        vk::SemaphoreTypeCreateInfo timelineCreateInfo(vk::SemaphoreType::eTimeline, 0);
+        m_Timeline = m_Ctx->GetDevice().createSemaphore(vk::SemaphoreCreateInfo().setPNext(&timelineCreateInfo));
+    }
+
+    UploadTicket UploadContext::Enqueue(const std::function<void(vk::CommandBuffer&)>& function) {
+        std::lock_guard lock(m_Mutex);
+        if (!m_Current) BeginBatch();
+
+        function(m_Current->commandBuffer);
+        return m_Current->ticket;
+    }
+
+    void UploadContext::KeepAlive(std::shared_ptr<void> resource) {
+        std::lock_guard lock(m_Mutex);
+        if (!m_Current) BeginBatch();
+
+        m_Current->keepAlive.emplace_back(std::move(resource));
+    }
+
+    void UploadContext::ReleaseImage(vk::Image image, const vk::ImageSubresourceRange& range,
+                                     vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+                                     vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) {
+        std::lock_guard lock(m_Mutex);
+        if (!m_Current) BeginBatch();
+
+        if (!NeedsOwnershipTransfer()) {
+            // Same queue family, a layout transition is enough. Visibility comes from the timeline wait.
+            m_Current->commandBuffer.pipelineBarrier(
+                    vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {},
+                    vk::ImageMemoryBarrier(vk::AccessFlagBits::eTransferWrite, {}, oldLayout, newLayout,
+                                           VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range));
+            return;
+        }
+
+        uint32_t src = m_Ctx->GetTransferQueueFamilyIndex();
+        uint32_t dst = m_Ctx->GetGraphicsQueueFamilyIndex();
+        m_Current->commandBuffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {},
+                vk::ImageMemoryBarrier(vk::AccessFlagBits::eTransferWrite, {}, oldLayout, newLayout, src, dst,
+                                       image, range));
+        m_PendingAcquires.push_back({
+                .image = vk::ImageMemoryBarrier({}, dstAccess, oldLayout, newLayout, src, dst, image, range),
+                .dstStage = dstStage });
+    }
+
+    void UploadContext::ReleaseBuffer(vk::Buffer buffer, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) {
+        std::lock_guard lock(m_Mutex);
+        if (!m_Current) BeginBatch();
+        if (!NeedsOwnershipTransfer()) return;
+
+        uint32_t src = m_Ctx->GetTransferQueueFamilyIndex();
+        uint32_t dst = m_Ctx->GetGraphicsQueueFamilyIndex();
+        m_Current->commandBuffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {},
+                vk::BufferMemoryBarrier(vk::AccessFlagBits::eTransferWrite, {}, src, dst, buffer, 0, VK_WHOLE_SIZE),
+                {});
+        m_PendingAcquires.push_back({
+                .buffer = vk::BufferMemoryBarrier({}, dstAccess, src, dst, buffer, 0, VK_WHOLE_SIZE),
+                .dstStage = dstStage });
+    }
+
+    void UploadContext::EnqueueGraphics(std::function<void(vk::CommandBuffer&)> function) {
+        std::lock_guard lock(m_Mutex);
+        m_PendingGraphics.emplace_back(std::move(function));
+    }
+
+    UploadTicket UploadContext::Flush() {
+        std::lock_guard lock(m_Mutex);
+        return FlushLocked();
+    }
+
+    void UploadContext::Wait(UploadTicket ticket) {
+        {
+            std::lock_guard lock(m_Mutex);
+            if (m_Current && ticket >= m_Current->ticket) FlushLocked();
+        }
+
+        while (vk::Result::eTimeout ==
+               m_Ctx->GetDevice().waitSemaphores(vk::SemaphoreWaitInfo({}, m_Timeline, ticket), 100000000));
+
+        std::lock_guard lock(m_Mutex);
+        Collect();
+    }
+
+    bool UploadContext::IsComplete(UploadTicket ticket) const {
+        return m_Ctx->GetDevice().getSemaphoreCounterValue(m_Timeline) >= ticket;
+    }
+
+    UploadTicket UploadContext::RecordAcquires(vk::CommandBuffer& cmdBuf) {
+        std::lock_guard lock(m_Mutex);
+
+        // Anything recorded so far belongs to resources this frame may already use
+        FlushLocked();
+        Collect();
+
+        if (!m_PendingAcquires.empty()) {
+            std::vector<vk::ImageMemoryBarrier> images;
+            std::vector<vk::BufferMemoryBarrier> buffers;
+            vk::PipelineStageFlags dstStage;
+            for (auto& acquire: m_PendingAcquires) {
+                if (acquire.image) images.push_back(*acquire.image);
+                if (acquire.buffer) buffers.push_back(*acquire.buffer);
+                dstStage |= acquire.dstStage;
+            }
+            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, dstStage, {}, {}, buffers, images);
+            m_PendingAcquires.clear();
+        }
+        for (auto& function: m_PendingGraphics) function(cmdBuf);
+        m_PendingGraphics.clear();
+
+        // Only wait on batches graphics hasn't waited on before
+        UploadTicket submitted = m_NextTicket - 1;
+        if (submitted <= m_AcquiredTicket) return 0;
+        m_AcquiredTicket = submitted;
+        return submitted;
+    }
+
+    vk::Semaphore UploadContext::GetTimelineSemaphore() const {
+        return m_Timeline;
     }
 
     void UploadContext::SubmitCommand(const std::function<void(vk::CommandBuffer&)>& function) {
-        m_CommandBuffer.begin(vk::CommandBufferBeginInfo(
-                vk::CommandBufferUsageFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
+        Wait(Enqueue(function));
+    }
 
-        function(m_CommandBuffer);
+    void UploadContext::BeginBatch() {
+        Collect();
 
-        m_CommandBuffer.end();
+        vk::CommandBuffer commandBuffer;
+        if (m_FreeCommandBuffers.empty()) {
+            commandBuffer = m_Ctx->GetDevice().allocateCommandBuffers(
+                    vk::CommandBufferAllocateInfo(m_CommandPool, vk::CommandBufferLevel::ePrimary, 1)).front();
+        } else {
+            commandBuffer = m_FreeCommandBuffers.back();
+            m_FreeCommandBuffers.pop_back();
+        }
 
-        vk::SubmitInfo submitInfo({}, {}, m_CommandBuffer);
+        commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        m_Current = Batch{ .commandBuffer = commandBuffer, .ticket = m_NextTicket++ };
+    }
 
-        m_Ctx->GetTransferQueue().submit(submitInfo, m_TransferFence);
+    UploadTicket UploadContext::FlushLocked() {
+        if (!m_Current) return m_NextTicket - 1;
 
-        while (vk::Result::eTimeout == m_Ctx->GetDevice().waitForFences(m_TransferFence, VK_TRUE, 100000000));
-        m_Ctx->GetDevice().resetFences(m_TransferFence);
+        m_Current->commandBuffer.end();
 
-        m_CommandBuffer.reset();
+        vk::TimelineSemaphoreSubmitInfo timelineInfo({}, m_Current->ticket);
+        vk::SubmitInfo submitInfo({}, {}, m_Current->commandBuffer, m_Timeline);
+        submitInfo.setPNext(&timelineInfo);
+        m_Ctx->GetTransferQueue().submit(submitInfo);
+
+        UploadTicket ticket = m_Current->ticket;
+        m_InFlight.emplace_back(std::move(*m_Current));
+        m_Current.reset();
+        return ticket;
+    }
+
+    void UploadContext::Collect() {
+        UploadTicket completed = m_Ctx->GetDevice().getSemaphoreCounterValue(m_Timeline);
+        while (!m_InFlight.empty() && m_InFlight.front().ticket <= completed) {
+            m_InFlight.front().commandBuffer.reset();
+            m_FreeCommandBuffers.push_back(m_InFlight.front().commandBuffer);
+            m_InFlight.pop_front();
+        }
+    }
+
+    bool UploadContext::NeedsOwnershipTransfer() const {
+        return m_Ctx->GetTransferQueueFamilyIndex() != m_Ctx->GetGraphicsQueueFamilyIndex();
     }
 
     UploadContext::~UploadContext() {
-        m_Ctx->GetDevice().destroyFence(m_TransferFence);
-        m_Ctx->GetDevice().destroySemaphore(m_TransferSemaphore);
-        m_Ctx->GetDevice().freeCommandBuffers(m_CommandPool, m_CommandBuffer);
+        Wait(Flush());
+
+        for (auto& batch: m_InFlight) m_FreeCommandBuffers.push_back(batch.commandBuffer);
+        m_InFlight.clear();
+        if (!m_FreeCommandBuffers.empty()) {
+            m_Ctx->GetDevice().freeCommandBuffers(m_CommandPool, m_FreeCommandBuffers);
+        }
+        m_Ctx->GetDevice().destroySemaphore(m_Timeline);
         m_Ctx->GetDevice().destroyCommandPool(m_CommandPool);
     }
-}
\ No newline at end of file
+}
@@ -3,19 +3,73 @@
 #include "Iris/Platform/Vulkan/Context.hpp"
 
 namespace Iris::Vulkan {
+    // Timeline semaphore value the upload is complete at
+    using UploadTicket = uint64_t;
+
+    // Batches transfer work into one submission on the transfer queue. Completion is tracked with a timeline
+    // semaphore, so the CPU never blocks unless asked to and the graphics queue only waits on frames that
+    // actually use a freshly uploaded resource.
     class UploadContext final {
     public:
         UploadContext(std::shared_ptr<Context> ctx);
 
+        // Records into the current batch, nothing is submitted until Flush()
+        UploadTicket Enqueue(const std::function<void(vk::CommandBuffer&)>& function);
+        // Keeps e.g. a staging buffer alive until the current batch has finished executing
+        void KeepAlive(std::shared_ptr<void> resource);
+
+        // Hands a freshly written image over to the graphics queue in its final layout. When the queue families
+        // differ this records the release here and queues the matching acquire for RecordAcquires.
+        void ReleaseImage(vk::Image image, const vk::ImageSubresourceRange& range, vk::ImageLayout oldLayout,
+                          vk::ImageLayout newLayout, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
+        void ReleaseBuffer(vk::Buffer buffer, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
+        // Recorded into the next graphics command buffer right after the acquires, for follow-up work the
+        // transfer queue can't do, e.g. blitting mip levels
+        void EnqueueGraphics(std::function<void(vk::CommandBuffer&)> function);
+
+        UploadTicket Flush();
+        void Wait(UploadTicket ticket);
+        [[nodiscard]] bool IsComplete(UploadTicket ticket) const;
+
+        // Called while recording a graphics command buffer. Records the pending acquire barriers and returns
+        // the ticket the submission has to wait on, or 0 when nothing new is used.
+        UploadTicket RecordAcquires(vk::CommandBuffer& cmdBuf);
+        [[nodiscard]] vk::Semaphore GetTimelineSemaphore() const;
+
+        // Blocking, for the few places that need the result right away (e.g. readbacks)
         void SubmitCommand(const std::function<void(vk::CommandBuffer&)>& function);
 
         ~UploadContext();
+    private:
+        struct Batch {
+            vk::CommandBuffer commandBuffer;
+            UploadTicket ticket = 0;
+            std::vector<std::shared_ptr<void>> keepAlive;
+        };
+
+        void BeginBatch();
+        UploadTicket FlushLocked();
+        void Collect();
+        [[nodiscard]] bool NeedsOwnershipTransfer() const;
     private:
         std::shared_ptr<Context> m_Ctx;
         vk::CommandPool m_CommandPool;
-        vk::CommandBuffer m_CommandBuffer;
+        vk::Semaphore m_Timeline;
+
+        std::optional<Batch> m_Current;
+        std::deque<Batch> m_InFlight;
+        std::vector<vk::CommandBuffer> m_FreeCommandBuffers;
+        UploadTicket m_NextTicket = 1;
+        UploadTicket m_AcquiredTicket = 0;   // last ticket the graphics queue has been told to wait on
+
+        struct PendingAcquire {
+            std::optional<vk::ImageMemoryBarrier> image;
+            std::optional<vk::BufferMemoryBarrier> buffer;
+            vk::PipelineStageFlags dstStage;
+        };
+        std::vector<PendingAcquire> m_PendingAcquires;
+        std::vector<std::function<void(vk::CommandBuffer&)>> m_PendingGraphics;
 
-        vk::Fence m_TransferFence;
-        vk::Semaphore m_TransferSemaphore;
+        mutable std::mutex m_Mutex;
     };
-}
\ No newline at end of file
+}
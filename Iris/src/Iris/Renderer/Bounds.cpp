@@ -0,0 +1,24 @@
+#include "Bounds.hpp"
+
+namespace Iris {
+    Bounds Bounds::FromVertices(std::span<const Vertex> vertices) {
+        Bounds out;
+        if (vertices.empty()) return out;
+
+        out.min = out.max = glm::vec3(vertices.front().position);
+        for (const auto& vertex: vertices) {
+            out.min = glm::min(out.min, glm::vec3(vertex.position));
+            out.max = glm::max(out.max, glm::vec3(vertex.position));
+        }
+
+        // Tighter than half the box diagonal for most meshes
+        out.center = (out.min + out.max) * 0.5f;
+        float radius2 = 0.f;
+        for (const auto& vertex: vertices) {
+            glm::vec3 d = glm::vec3(vertex.position) - out.center;
+            radius2 = glm::max(radius2, glm::dot(d, d));
+        }
+        out.radius = glm::sqrt(radius2);
+        return out;
+    }
+}
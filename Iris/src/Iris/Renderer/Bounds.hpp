@@ -0,0 +1,15 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "Iris/Renderer/Vertex.hpp"
+
+namespace Iris {
+    // Object space bounds of a mesh, computed once when the geometry is loaded
+    struct Bounds {
+        glm::vec3 min{ 0.f };
+        glm::vec3 max{ 0.f };
+        glm::vec3 center{ 0.f };   // bounding sphere, centered on the box
+        float radius = 0.f;
+
+        static Bounds FromVertices(std::span<const Vertex> vertices);
+    };
+}
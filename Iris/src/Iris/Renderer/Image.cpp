@@ -0,0 +1,167 @@
+#include "Image.hpp"
+#include <stb_image.h>
+#include <glm/gtc/packing.hpp>
+#include "Iris/Renderer/TextureCompressor.hpp"
+#include "Iris/Util/MappedFile.hpp"
+#include "Iris/Util/Hash.hpp"
+
+namespace Iris {
+    static std::atomic<bool> s_BlockCompression = false;
+
+    void ImageData::SetBlockCompression(bool enabled) {
+        s_BlockCompression = enabled;
+    }
+
+    static bool HasAlpha(std::span<const uint8_t> rgba) {
+        for (size_t i = 3; i < rgba.size(); i += 4) {
+            if (rgba[i] != 255) return true;
+        }
+        return false;
+    }
+
+    static PixelFormat ChooseFormat(ImageUsage usage, bool hasAlpha) {
+        if (!s_BlockCompression || usage == ImageUsage::Icon) {
+            return usage == ImageUsage::Normal ? PixelFormat::RGBA8 : PixelFormat::RGBA8Srgb;
+        }
+        if (usage == ImageUsage::Normal) return PixelFormat::BC5;
+        return hasAlpha ? PixelFormat::BC7Srgb : PixelFormat::BC1Srgb;
+    }
+
+    static bool IsCacheUsable(const TextureCache& cache, ImageUsage usage) {
+        if (!s_BlockCompression || usage == ImageUsage::Icon) return false;
+        if (usage == ImageUsage::Normal) return cache.GetFormat() == PixelFormat::BC5;
+        return cache.GetFormat() == PixelFormat::BC1Srgb || cache.GetFormat() == PixelFormat::BC7Srgb;
+    }
+
+    static void LoadHdr(ImageData& out, std::span<const std::byte> bytes) {
+        int width, height, fileChannels;
+        float* data = stbi_loadf_from_memory(reinterpret_cast<const stbi_uc*>(bytes.data()),
+                                             static_cast<int>(bytes.size()), &width, &height, &fileChannels, 4);
+        if (data == nullptr) return;
+
+        out.size = { width, height };
+        out.format = PixelFormat::RGBA16F;
+        out.texels.resize(GetImageBytes(out.format, out.size));
+        auto* halves = reinterpret_cast<uint16_t*>(out.texels.data());
+        for (size_t i = 0; i < size_t(width) * height * 4; ++i) halves[i] = glm::packHalf1x16(data[i]);
+        out.levels.push_back({ .size = out.size, .offset = 0, .bytes = out.texels.size() });
+        stbi_image_free(data);
+    }
+
+    static void CompressLevels(ImageData& out, const std::string& path, uint64_t sourceHash, const FileStamp& stamp,
+                               std::vector<uint8_t> rgba) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Block compressed levels can't be blitted on the GPU, so the whole chain is built here
+        bool srgb = out.format != PixelFormat::BC5;
+        glm::uvec2 size = out.size;
+        while (true) {
+            auto blocks = TextureCompressor::Compress(rgba, size, out.format);
+            uint64_t offset = (out.texels.size() + 15) & ~uint64_t(15);
+            out.levels.push_back({ .size = size, .offset = offset, .bytes = blocks.size() });
+            out.texels.resize(offset + blocks.size());
+            memcpy(out.texels.data() + offset, blocks.data(), blocks.size());
+
+            if (size.x == 1 && size.y == 1) break;
+            rgba = TextureCompressor::Downsample(rgba, size, srgb);
+            size = glm::max(size / 2u, glm::uvec2(1));
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start)
+                .count();
+        Log::Core::Info("Compressed {} to {} ({} levels, {} KiB) in {:.2f}ms", path, ToString(out.format),
+                        out.levels.size(), out.texels.size() / 1024, ms);
+
+        std::filesystem::path cachePath = path + ".irtex";
+        if (TextureCache::Write(cachePath, sourceHash, stamp, out.format, out.levels, out.texels)) {
+            if (auto cache = TextureCache::Open(cachePath)) {
+                out.cache = std::move(cache);
+                out.texels = {};
+                out.texels.shrink_to_fit();
+                return;
+            }
+        }
+        Log::Core::Warn("Couldn't write texture cache {}, the texture is compressed again next launch",
+                        cachePath.string());
+    }
+
+    std::shared_ptr<const ImageData> ImageData::Load(const std::string& path, ImageUsage usage) {
+        // Taken before the source is read, a change while loading makes the next launch check it again
+        auto stamp = GetFileStamp(path);
+        if (!stamp) {
+            Log::Core::Error("Failed to open texture {}", path);
+            return nullptr;
+        }
+
+        auto out = std::make_shared<ImageData>();
+        auto useCache = [&](std::shared_ptr<TextureCache> cache) {
+            out->hash = HashBytes(std::as_bytes(std::span(&usage, 1)), cache->GetSourceHash());
+            out->size = cache->GetSize();
+            out->format = cache->GetFormat();
+            out->hasAlpha = out->format == PixelFormat::BC7Srgb;   // only picked for images with alpha
+            out->levels.assign(cache->GetLevels().begin(), cache->GetLevels().end());
+            out->cache = std::move(cache);
+            return out;
+        };
+
+        // An unchanged source isn't read at all, the cache knows its hash
+        std::string cachePath = path + ".irtex";
+        auto cache = TextureCache::Open(cachePath);
+        if (cache && !IsCacheUsable(*cache, usage)) cache.reset();
+        if (cache && cache->GetSourceStamp() == *stamp) return useCache(std::move(cache));
+
+        auto file = MappedFile::Open(path);
+        if (!file) {
+            Log::Core::Error("Failed to open texture {}", path);
+            return nullptr;
+        }
+
+        auto bytes = file->GetData();
+        uint64_t sourceHash = HashBytes(bytes);
+        out->hash = HashBytes(std::as_bytes(std::span(&usage, 1)), sourceHash);
+
+        // Touched but unchanged, restamped so the next launch skips the hash
+        if (cache && cache->GetSourceHash() == sourceHash) {
+            cache.reset();
+            RestampCache<TextureCacheHeader>(cachePath, *stamp);
+            cache = TextureCache::Open(cachePath);
+            if (cache && cache->GetSourceHash() == sourceHash && IsCacheUsable(*cache, usage)) {
+                return useCache(std::move(cache));
+            }
+        }
+        cache.reset();
+
+        const auto* encoded = reinterpret_cast<const stbi_uc*>(bytes.data());
+        if (stbi_is_hdr_from_memory(encoded, static_cast<int>(bytes.size()))) {
+            LoadHdr(*out, bytes);
+            if (out->texels.empty()) {
+                Log::Core::Error("Failed to load texture {}, reason: {}", path, stbi_failure_reason());
+                return nullptr;
+            }
+            return out;
+        }
+
+        int width, height, fileChannels;
+        stbi_uc* data = stbi_load_from_memory(encoded, static_cast<int>(bytes.size()), &width, &height,
+                                              &fileChannels, 4);
+        if (data == nullptr) {
+            Log::Core::Error("Failed to load texture {}, reason: {}", path, stbi_failure_reason());
+            return nullptr;
+        }
+        std::vector<uint8_t> rgba(data, data + size_t(width) * height * 4);
+        stbi_image_free(data);
+        file.reset();
+
+        out->size = { width, height };
+        out->hasAlpha = usage == ImageUsage::Color && HasAlpha(rgba);
+        out->format = ChooseFormat(usage, out->hasAlpha);
+        if (IsBlockCompressed(out->format)) {
+            CompressLevels(*out, path, sourceHash, *stamp, std::move(rgba));
+        } else {
+            out->texels.resize(rgba.size());
+            memcpy(out->texels.data(), rgba.data(), rgba.size());
+            out->levels.push_back({ .size = out->size, .offset = 0, .bytes = out->texels.size() });
+        }
+        return out;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "Iris/Renderer/PixelFormat.hpp"
+#include "Iris/Renderer/TextureCache.hpp"
+
+namespace Iris {
+    // What an image is sampled for, picks the format it is stored in
+    enum class ImageUsage : uint8_t {
+        Color,      // sRGB albedo: BC1 when opaque, BC7 with alpha
+        Normal,     // tangent space normals, BC5
+        Icon        // UI sprites, kept uncompressed so the edges stay sharp
+    };
+
+    // Texels on the CPU, waiting for upload. LDR images are stored as RGBA8, HDR images as RGBA16F. When the
+    // device can sample block compressed formats, color and normal maps are compressed once and kept next to
+    // the source as <path>.irtex, later loads map that file instead of decoding the source.
+    struct ImageData {
+        glm::uvec2 size{};
+        PixelFormat format = PixelFormat::RGBA8Srgb;
+        std::vector<ImageLevel> levels;         // level 0 first
+        std::vector<std::byte> texels;          // decoded images
+        std::shared_ptr<TextureCache> cache;    // compressed images
+        uint64_t hash = 0;  // content hash of the encoded file and the usage
+        bool hasAlpha = false;  // color images with a texel that isn't opaque, alpha tested materials need it
+
+        [[nodiscard]] std::span<const std::byte> GetTexels() const {
+            return cache ? cache->GetTexels() : std::span<const std::byte>(texels);
+        }
+
+        // Thread safe, nullptr when the file can't be decoded
+        static std::shared_ptr<const ImageData> Load(const std::string& path, ImageUsage usage = ImageUsage::Color);
+
+        // Set by the renderer once it knows whether the device supports BC formats
+        static void SetBlockCompression(bool enabled);
+    };
+}
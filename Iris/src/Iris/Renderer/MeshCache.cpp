@@ -0,0 +1,89 @@
+#include "MeshCache.hpp"
+
+namespace Iris {
+    static constexpr uint64_t SectionAlignment = 16;
+
+    static uint64_t AlignSection(uint64_t offset) {
+        return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+    }
+
+    std::shared_ptr<MeshCache> MeshCache::Open(const std::filesystem::path& path) {
+        auto file = MappedFile::Open(path);
+        if (!file || file->GetSize() < sizeof(MeshCacheHeader)) return nullptr;
+
+        const auto* header = reinterpret_cast<const MeshCacheHeader*>(file->GetData().data());
+        if (header->magic != MeshCacheHeader::Magic || header->version != MeshCacheHeader::Version ||
+            header->vertexStride != sizeof(Vertex)) {
+            return nullptr;
+        }
+
+        auto fits = [&](uint64_t offset, uint64_t size) {
+            return offset % SectionAlignment == 0 && offset + size <= file->GetSize();
+        };
+        if (!fits(header->vertexOffset, uint64_t(header->vertexCount) * sizeof(Vertex)) ||
+            !fits(header->indexOffset, uint64_t(header->indexCount) * sizeof(uint32_t)) ||
+            !fits(header->submeshOffset, uint64_t(header->submeshCount) * sizeof(Submesh))) {
+            Log::Core::Warn("Mesh cache {} is truncated", path.string());
+            return nullptr;
+        }
+
+        auto out = std::make_shared<MeshCache>();
+        out->m_Header = header;
+        out->m_File = std::move(file);
+        return out;
+    }
+
+    bool MeshCache::Write(const std::filesystem::path& path, uint64_t sourceHash, const FileStamp& sourceStamp,
+                          const MeshData& data) {
+        MeshCacheHeader header{
+                .sourceHash = sourceHash,
+                .sourceStamp = sourceStamp,
+                .vertexCount = static_cast<uint32_t>(data.vertices.size()),
+                .indexCount = static_cast<uint32_t>(data.indices.size()),
+                .submeshCount = static_cast<uint32_t>(data.submeshes.size()),
+                .bounds = data.bounds
+        };
+        header.vertexOffset = AlignSection(sizeof(MeshCacheHeader));
+        header.indexOffset = AlignSection(header.vertexOffset + data.vertices.size() * sizeof(Vertex));
+        header.submeshOffset = AlignSection(header.indexOffset + data.indices.size() * sizeof(uint32_t));
+
+        // Written under a temporary name first, so a crash never leaves a half written cache behind
+        auto temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+
+            auto writeAt = [&](uint64_t offset, const void* bytes, size_t size) {
+                static constexpr char padding[SectionAlignment]{};
+                file.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp())));
+                file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+            };
+            writeAt(0, &header, sizeof(header));
+            writeAt(header.vertexOffset, data.vertices.data(), data.vertices.size() * sizeof(Vertex));
+            writeAt(header.indexOffset, data.indices.data(), data.indices.size() * sizeof(uint32_t));
+            writeAt(header.submeshOffset, data.submeshes.data(), data.submeshes.size() * sizeof(Submesh));
+            if (!file) return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+
+    std::span<const Vertex> MeshCache::GetVertices() const {
+        return GetSection<Vertex>(m_Header->vertexOffset, m_Header->vertexCount);
+    }
+
+    std::span<const uint32_t> MeshCache::GetIndices() const {
+        return GetSection<uint32_t>(m_Header->indexOffset, m_Header->indexCount);
+    }
+
+    std::span<const Submesh> MeshCache::GetSubmeshes() const {
+        return GetSection<Submesh>(m_Header->submeshOffset, m_Header->submeshCount);
+    }
+
+    const Bounds& MeshCache::GetBounds() const {
+        return m_Header->bounds;
+    }
+}
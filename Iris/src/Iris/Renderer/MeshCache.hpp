@@ -0,0 +1,67 @@
+#pragma once
+#include "Iris/Renderer/Vertex.hpp"
+#include "Iris/Renderer/Bounds.hpp"
+#include "Iris/Util/MappedFile.hpp"
+#include "Iris/Util/Hash.hpp"
+
+namespace Iris {
+    // Range of the index buffer drawn with one material
+    struct Submesh {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+    };
+
+    // Geometry as produced by an importer, before it is written to the cache
+    struct MeshData {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<Submesh> submeshes;
+        Bounds bounds;
+    };
+
+    // File layout of a compiled mesh. Every section is stored exactly as in memory and 16 byte aligned, so a
+    // mapped file can be used without any parsing or copying.
+    struct MeshCacheHeader {
+        static constexpr uint32_t Magic = 0x48534D49;   // "IMSH"
+        static constexpr uint32_t Version = 3;          // bump whenever the layout or the importer output changes
+
+        uint32_t magic = Magic;
+        uint32_t version = Version;
+        uint64_t sourceHash = 0;
+        FileStamp sourceStamp;
+        uint32_t vertexStride = sizeof(Vertex);
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t submeshCount = 0;
+        uint64_t vertexOffset = 0;
+        uint64_t indexOffset = 0;
+        uint64_t submeshOffset = 0;
+        Bounds bounds;
+    };
+
+    // Memory mapped compiled mesh
+    class MeshCache final {
+    public:
+        // nullptr when the file is missing, damaged or of another version. Whether it was built from the current
+        // source is up to the caller, by the stamp or the hash of the source.
+        static std::shared_ptr<MeshCache> Open(const std::filesystem::path& path);
+        static bool Write(const std::filesystem::path& path, uint64_t sourceHash, const FileStamp& sourceStamp,
+                          const MeshData& data);
+
+        [[nodiscard]] uint64_t GetSourceHash() const { return m_Header->sourceHash; }
+        [[nodiscard]] const FileStamp& GetSourceStamp() const { return m_Header->sourceStamp; }
+
+        [[nodiscard]] std::span<const Vertex> GetVertices() const;
+        [[nodiscard]] std::span<const uint32_t> GetIndices() const;
+        [[nodiscard]] std::span<const Submesh> GetSubmeshes() const;
+        [[nodiscard]] const Bounds& GetBounds() const;
+    private:
+        template <class T>
+        [[nodiscard]] std::span<const T> GetSection(uint64_t offset, uint32_t count) const {
+            return { reinterpret_cast<const T*>(m_File->GetData().data() + offset), count };
+        }
+    private:
+        std::unique_ptr<MappedFile> m_File;
+        const MeshCacheHeader* m_Header = nullptr;
+    };
+}
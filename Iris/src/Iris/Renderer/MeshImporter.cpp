@@ -0,0 +1,153 @@
+#include "MeshImporter.hpp"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+#include "Iris/Renderer/MeshOptimizer.hpp"
+#include "Iris/Util/Hash.hpp"
+
+namespace Iris::MeshImporter {
+    std::shared_ptr<const MeshAsset> Import(const std::filesystem::path& path) {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto elapsedMs = [&] {
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start)
+                    .count();
+        };
+
+        // Taken before the source is read, a change while importing makes the next launch check it again
+        auto stamp = GetFileStamp(path);
+        if (!stamp) {
+            Log::Core::Error("Failed to open mesh {}", path.string());
+            return nullptr;
+        }
+
+        auto out = std::make_shared<MeshAsset>();
+        auto cachePath = path;
+        cachePath += ".irmesh";
+        out->cache = MeshCache::Open(cachePath);
+        if (out->cache && out->cache->GetSourceStamp() == *stamp) {
+            out->hash = out->cache->GetSourceHash();
+            Log::Core::Info("Loaded {} from its cache in {:.2f}ms", path.string(), elapsedMs());
+            return out;
+        }
+
+        // Only a source that looks changed is hashed, the cache may still match its content
+        auto source = MappedFile::Open(path);
+        if (!source) {
+            Log::Core::Error("Failed to open mesh {}", path.string());
+            return nullptr;
+        }
+        uint64_t hash = HashBytes(source->GetData());
+        source.reset();
+        out->hash = hash;
+        if (out->cache && out->cache->GetSourceHash() == hash) {
+            out->cache.reset();
+            RestampCache<MeshCacheHeader>(cachePath, *stamp);
+            out->cache = MeshCache::Open(cachePath);
+            if (out->cache && out->cache->GetSourceHash() == hash) {
+                Log::Core::Info("Loaded {} from its cache in {:.2f}ms", path.string(), elapsedMs());
+                return out;
+            }
+        }
+        out->cache.reset();
+
+        auto data = LoadObj(path);
+        if (!data) {
+            Log::Core::Error("Failed to load obj {}", path.string());
+            return nullptr;
+        }
+
+        if (MeshCache::Write(cachePath, hash, *stamp, *data)) out->cache = MeshCache::Open(cachePath);
+        if (!out->cache) {
+            Log::Core::Warn("Couldn't write mesh cache {}, the mesh is imported again next launch",
+                            cachePath.string());
+            out->data = std::move(*data);
+        }
+        Log::Core::Info("Imported {} in {:.2f}ms", path.string(), elapsedMs());
+        return out;
+    }
+
+    std::optional<MeshData> LoadObj(const std::filesystem::path& path) {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn;
+        std::string err;
+        bool status = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.string().c_str());
+        if (!warn.empty()) {
+            Log::Core::Warn("Loading obj: {}", warn);
+        }
+
+        if (!err.empty()) {
+            Log::Core::Error("Loading obj: {}", err);
+        }
+
+        if (!status) return std::nullopt;
+
+        // Every distinct position/normal/uv combination becomes one vertex, so seams keep both of their normals
+        struct CornerHash {
+            size_t operator()(const tinyobj::index_t& index) const {
+                return std::hash<uint64_t>()((uint64_t(uint32_t(index.vertex_index)) << 42) ^
+                                             (uint64_t(uint32_t(index.normal_index)) << 21) ^
+                                             uint64_t(uint32_t(index.texcoord_index)));
+            }
+        };
+        struct CornerEqual {
+            bool operator()(const tinyobj::index_t& a, const tinyobj::index_t& b) const {
+                return a.vertex_index == b.vertex_index && a.normal_index == b.normal_index &&
+                       a.texcoord_index == b.texcoord_index;
+            }
+        };
+        std::unordered_map<tinyobj::index_t, uint32_t, CornerHash, CornerEqual> unique;
+
+        bool hasColors = attrib.colors.size() >= attrib.vertices.size();
+        auto makeVertex = [&](const tinyobj::index_t& idx) {
+            Vertex vertex{};
+            vertex.position = { attrib.vertices[idx.vertex_index * 3], attrib.vertices[idx.vertex_index * 3 + 1],
+                                attrib.vertices[idx.vertex_index * 3 + 2], 1.f };
+            vertex.color = hasColors ? glm::vec4(attrib.colors[idx.vertex_index * 3],
+                                                 attrib.colors[idx.vertex_index * 3 + 1],
+                                                 attrib.colors[idx.vertex_index * 3 + 2], 1.f)
+                                     : glm::vec4(1.f);
+            if (idx.normal_index >= 0) {
+                vertex.normal = { attrib.normals[idx.normal_index * 3], attrib.normals[idx.normal_index * 3 + 1],
+                                  attrib.normals[idx.normal_index * 3 + 2], 1.f };
+            }
+            if (idx.texcoord_index >= 0) {
+                vertex.uv = { attrib.texcoords[idx.texcoord_index * 2],
+                              1.0f - attrib.texcoords[idx.texcoord_index * 2 + 1] }; // Flip Y coord.
+            }
+            return vertex;
+        };
+
+        MeshData out;
+        size_t corners = 0;
+        for (const auto& shape: shapes) {
+            Submesh submesh{ .firstIndex = static_cast<uint32_t>(out.indices.size()) };
+            for (const auto& idx: shape.mesh.indices) {
+                auto [it, inserted] = unique.try_emplace(idx, static_cast<uint32_t>(out.vertices.size()));
+                if (inserted) out.vertices.push_back(makeVertex(idx));
+                out.indices.push_back(it->second);
+            }
+            submesh.indexCount = static_cast<uint32_t>(out.indices.size()) - submesh.firstIndex;
+            corners += submesh.indexCount;
+            if (submesh.indexCount > 0) out.submeshes.push_back(submesh);
+        }
+
+        // Triangles are reordered within their submesh, the vertices once for the whole buffer
+        float acmrBefore = MeshOptimizer::ComputeACMR(out.indices, out.vertices.size());
+        for (const auto& submesh: out.submeshes) {
+            auto indices = std::span(out.indices).subspan(submesh.firstIndex, submesh.indexCount);
+            if (indices.empty()) continue;
+            auto [first, last] = std::minmax_element(indices.begin(), indices.end());
+            MeshOptimizer::OptimizeVertexCache(indices, *first, *last - *first + 1);
+        }
+        MeshOptimizer::OptimizeVertexFetch(out.vertices, out.indices);
+        float acmrAfter = MeshOptimizer::ComputeACMR(out.indices, out.vertices.size());
+
+        Log::Core::Info("{}: {} submeshes, {} vertices from {} corners, ACMR {:.3f} -> {:.3f}", path.string(),
+                        out.submeshes.size(), out.vertices.size(), corners, acmrBefore, acmrAfter);
+
+        out.bounds = Bounds::FromVertices(out.vertices);
+        return out;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "Iris/Renderer/MeshCache.hpp"
+
+namespace Iris {
+    // Imported mesh, mapped from its cache or kept in memory when the cache couldn't be written
+    struct MeshAsset {
+        std::shared_ptr<MeshCache> cache;
+        MeshData data;
+        uint64_t hash = 0;  // content hash of the source file, identical files share GPU resources
+
+        [[nodiscard]] std::span<const Vertex> GetVertices() const {
+            return cache ? cache->GetVertices() : std::span<const Vertex>(data.vertices);
+        }
+        [[nodiscard]] std::span<const uint32_t> GetIndices() const {
+            return cache ? cache->GetIndices() : std::span<const uint32_t>(data.indices);
+        }
+        [[nodiscard]] std::span<const Submesh> GetSubmeshes() const {
+            return cache ? cache->GetSubmeshes() : std::span<const Submesh>(data.submeshes);
+        }
+        [[nodiscard]] const Bounds& GetBounds() const { return cache ? cache->GetBounds() : data.bounds; }
+    };
+}
+
+namespace Iris::MeshImporter {
+    // Compiled mesh for a source file, stored next to it as <path>.irmesh. The cache is reused without reading
+    // the source while its size and modification time are unchanged, otherwise as long as the source content
+    // hash matches. Failing both the source is imported again and the cache rewritten.
+    // Thread safe, nullptr when the source can't be read.
+    std::shared_ptr<const MeshAsset> Import(const std::filesystem::path& path);
+
+    std::optional<MeshData> LoadObj(const std::filesystem::path& path);
+}
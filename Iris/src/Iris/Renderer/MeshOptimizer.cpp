@@ -0,0 +1,115 @@
+#include "MeshOptimizer.hpp"
+
+namespace Iris::MeshOptimizer {
+    static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+    void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t firstVertex, size_t vertexCount,
+                             uint32_t cacheSize) {
+        if (indices.size() % 3 != 0) {
+            Log::Core::Error("OptimizeVertexCache: {} indices are not a triangle list", indices.size());
+            return;
+        }
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) return;
+
+        // Per-vertex tables only cover the range, indices are rebased while working and restored on output
+        for (auto& index: indices) index -= firstVertex;
+
+        // Triangles using each vertex, as offsets into one flat array
+        std::vector<uint32_t> live(vertexCount, 0);
+        for (auto index: indices) ++live[index];
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + live[v];
+        std::vector<uint32_t> adjacency(offsets.back());
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        uint32_t time = cacheSize + 1;
+        size_t cursor = 0;
+
+        // Most recently used vertex that still has triangles, or the next one in input order
+        auto skipDeadEnd = [&]() -> uint32_t {
+            while (!deadEnds.empty()) {
+                uint32_t vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if (live[vertex] > 0) return vertex;
+            }
+            for (; cursor < vertexCount; ++cursor) {
+                if (live[cursor] > 0) return static_cast<uint32_t>(cursor);
+            }
+            return None;
+        };
+
+        uint32_t fan = skipDeadEnd();
+        while (fan != None) {
+            candidates.clear();
+            for (uint32_t i = offsets[fan]; i < offsets[fan + 1]; ++i) {
+                uint32_t triangle = adjacency[i];
+                if (emitted[triangle]) continue;
+                emitted[triangle] = true;
+
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    uint32_t vertex = indices[triangle * 3 + corner];
+                    output.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    --live[vertex];
+                    if (time - timestamps[vertex] > cacheSize) timestamps[vertex] = time++;
+                }
+            }
+
+            // Prefer the candidate that is oldest in the cache but still in it after its remaining triangles
+            fan = None;
+            uint32_t best = 0;
+            for (auto vertex: candidates) {
+                if (live[vertex] == 0) continue;
+                uint32_t priority = 0;
+                if (time - timestamps[vertex] + 2 * live[vertex] <= cacheSize) priority = time - timestamps[vertex];
+                if (fan == None || priority > best) {
+                    best = priority;
+                    fan = vertex;
+                }
+            }
+            if (fan == None) fan = skipDeadEnd();
+        }
+
+        std::transform(output.begin(), output.end(), indices.begin(),
+                       [firstVertex](uint32_t index) { return index + firstVertex; });
+    }
+
+    void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices) {
+        std::vector<uint32_t> remap(vertices.size(), None);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+        for (auto& index: indices) {
+            if (remap[index] == None) {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices = std::move(reordered);
+    }
+
+    float ComputeACMR(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+        if (indices.size() < 3) return 0.f;
+
+        // FIFO: a vertex stays cached until cacheSize other vertices were loaded after it
+        std::vector<uint64_t> loadedAt(vertexCount, 0);
+        uint64_t loads = 0;
+        for (auto index: indices) {
+            if (loadedAt[index] == 0 || loads + 1 - loadedAt[index] > cacheSize) {
+                loadedAt[index] = ++loads;
+            }
+        }
+        return static_cast<float>(loads) / static_cast<float>(indices.size() / 3);
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "Iris/Renderer/Vertex.hpp"
+
+namespace Iris::MeshOptimizer {
+    // Post-transform cache size the optimizer and the statistics assume, close to what current GPUs reuse
+    static constexpr uint32_t CacheSize = 16;
+
+    // Reorders the triangles of a triangle list for post-transform vertex cache reuse (Tipsify, Sander et al.
+    // 2007). Every index lies in [firstVertex, firstVertex + vertexCount), e.g. the vertex range of one submesh.
+    // Runs in time linear in the indices and that range. Leaves lists whose size isn't a multiple of 3 untouched.
+    void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t firstVertex, size_t vertexCount,
+                             uint32_t cacheSize = CacheSize);
+
+    // Sorts the vertices by first use so vertex fetches walk memory forward, drops unreferenced vertices
+    void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices);
+
+    // Average cache miss ratio: transformed vertices per triangle with a FIFO cache, 0.5 is ideal, 3 is no reuse
+    float ComputeACMR(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = CacheSize);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace Iris {
+    // Storage formats of sampled images. Block compressed formats encode 4x4 texel blocks.
+    enum class PixelFormat : uint32_t {
+        RGBA8,
+        RGBA8Srgb,
+        RGBA16F,    // HDR images
+        BC1Srgb,    // opaque color, 4 bits per texel
+        BC3Srgb,    // color with alpha, 8 bits per texel
+        BC5,        // two channel data such as tangent space normals, 8 bits per texel
+        BC7Srgb     // high quality color with alpha, 8 bits per texel
+    };
+
+    constexpr bool IsBlockCompressed(PixelFormat format) {
+        return format >= PixelFormat::BC1Srgb;
+    }
+
+    // Bytes per 4x4 block for block compressed formats, per texel otherwise
+    constexpr uint32_t GetBlockBytes(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::RGBA8:
+            case PixelFormat::RGBA8Srgb:
+                return 4;
+            case PixelFormat::RGBA16F:
+            case PixelFormat::BC1Srgb:
+                return 8;
+            case PixelFormat::BC3Srgb:
+            case PixelFormat::BC5:
+            case PixelFormat::BC7Srgb:
+                return 16;
+        }
+        return 0;
+    }
+
+    constexpr uint64_t GetImageBytes(PixelFormat format, glm::uvec2 size) {
+        if (!IsBlockCompressed(format)) return uint64_t(size.x) * size.y * GetBlockBytes(format);
+        return uint64_t((size.x + 3) / 4) * ((size.y + 3) / 4) * GetBlockBytes(format);
+    }
+
+    constexpr std::string_view ToString(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::RGBA8: return "RGBA8";
+            case PixelFormat::RGBA8Srgb: return "RGBA8 sRGB";
+            case PixelFormat::RGBA16F: return "RGBA16F";
+            case PixelFormat::BC1Srgb: return "BC1 sRGB";
+            case PixelFormat::BC3Srgb: return "BC3 sRGB";
+            case PixelFormat::BC5: return "BC5";
+            case PixelFormat::BC7Srgb: return "BC7 sRGB";
+        }
+        return "Unknown";
+    }
+
+    // One mip level, as a byte range of the image's texel data
+    struct ImageLevel {
+        glm::uvec2 size{};
+        uint64_t offset = 0;
+        uint64_t bytes = 0;
+    };
+}
@@ -6,8 +6,9 @@
 using namespace std::chrono_literals;
 
 namespace Iris {
-    Renderer::Renderer(const std::shared_ptr<Window>& window) : m_Window(window) {
-        Log::Core::Info("Renderer {} created", window->GetTitle());
+    Renderer::Renderer(const std::shared_ptr<Window>& window, const RendererOptions& options)
+            : m_Size(options.Size), m_Window(window) {
+        Log::Core::Info("Renderer {} created", m_Window ? m_Window->GetTitle() : "headless");
         if (m_Window) {
             m_Size.x = window->GetWidth();
             m_Size.y = window->GetHeight();
@@ -15,11 +16,15 @@ namespace Iris {
     }
 
     std::unique_ptr<Renderer>
-    Renderer::Create(RenderAPI api, const std::shared_ptr<Window>& window) {
+    Renderer::Create(RenderAPI api, const std::shared_ptr<Window>& window, const RendererOptions& options) {
         switch (api) {
             case RenderAPI::Vulkan:
-                return std::make_unique<Vulkan::Renderer>(window);
+                return std::make_unique<Vulkan::Renderer>(window, options);
             case RenderAPI::OpenGL:
+                if (!window) {
+                    Log::Core::Error("OpenGL renderer can't run headless");
+                    return {};
+                }
                 return std::make_unique<OpenGLRenderer>(window);
             default:
                 return {};
@@ -3,21 +3,42 @@
 #include "Iris/Core/Window.hpp"
 #include "Iris/Scene/Scene.hpp"
 #include "Iris/Entity/Components/Camera.hpp"
+#include "Iris/Util/EventEmitter.hpp"
 
 namespace Iris {
-    class Renderer {
+    struct RendererOptions {
+        uint32_t FramesInFlight = 2;
+        glm::uvec2 Size{ 1600, 900 }; // used when there is no window to take the size from
+        float MaxAnisotropy = 16.f;   // material textures, clamped to the device limit
+        float TextureLodBias = 0.f;
+        uint64_t TextureBudget = 512ull << 20; // VRAM for streamed material textures, in bytes
+        bool Deferred = false;        // G-buffer and a fullscreen lighting pass instead of forward shading
+        bool DepthPrepass = false;    // opaque geometry is shaded only where its depth is the nearest
+    };
+
+    // Emitted with the RGBA8 pixels of a finished frame when rendering headless
+    struct FrameReady final : public EventHandler<uint64_t, glm::uvec2, std::span<const uint8_t>> {
+    };
+
+    class Renderer : public EventEmitter<
+            FrameReady
+    > {
     public:
         static std::unique_ptr<Renderer>
-        Create(RenderAPI api, const std::shared_ptr<Window>& window);
+        Create(RenderAPI api, const std::shared_ptr<Window>& window, const RendererOptions& options = {});
 
         virtual void SetScene(const std::shared_ptr<Scene>& scene);
         virtual void Render(const Camera& camera) = 0;
+        // Waits for all submitted frames to finish
+        virtual void Flush() {};
 
         [[nodiscard]] std::shared_ptr<Window>& GetWindow() { return m_Window; }
 
+        [[nodiscard]] uint64_t GetFrameNumber() const { return m_FrameNr; }
+
         virtual ~Renderer() = default;
     protected:
-        explicit Renderer(const std::shared_ptr<Window>& window);
+        explicit Renderer(const std::shared_ptr<Window>& window, const RendererOptions& options = {});
         virtual void Present();
     protected:
         glm::uvec2 m_Size{ 1600, 900 };
@@ -0,0 +1,87 @@
+#include "TextureCache.hpp"
+
+namespace Iris {
+    static constexpr uint64_t SectionAlignment = 16;
+
+    static uint64_t AlignSection(uint64_t offset) {
+        return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+    }
+
+    std::shared_ptr<TextureCache> TextureCache::Open(const std::filesystem::path& path) {
+        auto file = MappedFile::Open(path);
+        if (!file || file->GetSize() < sizeof(TextureCacheHeader)) return nullptr;
+
+        const auto* header = reinterpret_cast<const TextureCacheHeader*>(file->GetData().data());
+        if (header->magic != TextureCacheHeader::Magic || header->version != TextureCacheHeader::Version ||
+            !IsBlockCompressed(header->format) || header->levelCount == 0) {
+            return nullptr;
+        }
+
+        auto fits = [&](uint64_t offset, uint64_t size) {
+            return offset % SectionAlignment == 0 && offset + size <= file->GetSize();
+        };
+        if (!fits(header->levelOffset, uint64_t(header->levelCount) * sizeof(ImageLevel)) ||
+            !fits(header->dataOffset, header->dataSize)) {
+            Log::Core::Warn("Texture cache {} is truncated", path.string());
+            return nullptr;
+        }
+        const auto* levels = reinterpret_cast<const ImageLevel*>(file->GetData().data() + header->levelOffset);
+        for (uint32_t i = 0; i < header->levelCount; ++i) {
+            if (levels[i].offset + levels[i].bytes > header->dataSize) {
+                Log::Core::Warn("Texture cache {} is damaged", path.string());
+                return nullptr;
+            }
+        }
+
+        auto out = std::make_shared<TextureCache>();
+        out->m_Header = header;
+        out->m_File = std::move(file);
+        return out;
+    }
+
+    bool TextureCache::Write(const std::filesystem::path& path, uint64_t sourceHash, const FileStamp& sourceStamp,
+                             PixelFormat format, std::span<const ImageLevel> levels,
+                             std::span<const std::byte> texels) {
+        TextureCacheHeader header{
+                .sourceHash = sourceHash,
+                .sourceStamp = sourceStamp,
+                .format = format,
+                .levelCount = static_cast<uint32_t>(levels.size()),
+                .size = levels.front().size,
+                .dataSize = texels.size()
+        };
+        header.levelOffset = AlignSection(sizeof(TextureCacheHeader));
+        header.dataOffset = AlignSection(header.levelOffset + levels.size() * sizeof(ImageLevel));
+
+        // Written under a temporary name first, so a crash never leaves a half written cache behind
+        auto temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+
+            auto writeAt = [&](uint64_t offset, const void* bytes, size_t size) {
+                static constexpr char padding[SectionAlignment]{};
+                file.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp())));
+                file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+            };
+            writeAt(0, &header, sizeof(header));
+            writeAt(header.levelOffset, levels.data(), levels.size() * sizeof(ImageLevel));
+            writeAt(header.dataOffset, texels.data(), texels.size());
+            if (!file) return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+
+    std::span<const ImageLevel> TextureCache::GetLevels() const {
+        return { reinterpret_cast<const ImageLevel*>(m_File->GetData().data() + m_Header->levelOffset),
+                 m_Header->levelCount };
+    }
+
+    std::span<const std::byte> TextureCache::GetTexels() const {
+        return m_File->GetData().subspan(m_Header->dataOffset, m_Header->dataSize);
+    }
+}
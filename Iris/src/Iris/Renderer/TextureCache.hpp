@@ -0,0 +1,45 @@
+#pragma once
+#include "Iris/Renderer/PixelFormat.hpp"
+#include "Iris/Util/MappedFile.hpp"
+#include "Iris/Util/Hash.hpp"
+
+namespace Iris {
+    // File layout of a compressed texture: the header, the level table and the texel data of every mip level,
+    // each 16 byte aligned so the mapped file can be copied into a staging buffer as is
+    struct TextureCacheHeader {
+        static constexpr uint32_t Magic = 0x58455449;   // "ITEX"
+        static constexpr uint32_t Version = 2;          // bump whenever the layout or the encoder output changes
+
+        uint32_t magic = Magic;
+        uint32_t version = Version;
+        uint64_t sourceHash = 0;
+        FileStamp sourceStamp;
+        PixelFormat format = PixelFormat::RGBA8;
+        uint32_t levelCount = 0;
+        glm::uvec2 size{};
+        uint64_t levelOffset = 0;
+        uint64_t dataOffset = 0;
+        uint64_t dataSize = 0;
+    };
+
+    // Memory mapped compressed texture
+    class TextureCache final {
+    public:
+        // nullptr when the file is missing, damaged or of another version. Whether it was built from the current
+        // source is up to the caller, by the stamp or the hash of the source.
+        static std::shared_ptr<TextureCache> Open(const std::filesystem::path& path);
+        // Level offsets are relative to the start of texels
+        static bool Write(const std::filesystem::path& path, uint64_t sourceHash, const FileStamp& sourceStamp,
+                          PixelFormat format, std::span<const ImageLevel> levels, std::span<const std::byte> texels);
+
+        [[nodiscard]] uint64_t GetSourceHash() const { return m_Header->sourceHash; }
+        [[nodiscard]] const FileStamp& GetSourceStamp() const { return m_Header->sourceStamp; }
+        [[nodiscard]] PixelFormat GetFormat() const { return m_Header->format; }
+        [[nodiscard]] glm::uvec2 GetSize() const { return m_Header->size; }
+        [[nodiscard]] std::span<const ImageLevel> GetLevels() const;
+        [[nodiscard]] std::span<const std::byte> GetTexels() const;
+    private:
+        std::unique_ptr<MappedFile> m_File;
+        const TextureCacheHeader* m_Header = nullptr;
+    };
+}
@@ -0,0 +1,231 @@
+#include "TextureCompressor.hpp"
+#include "Iris/Core/JobSystem.hpp"
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+namespace Iris::TextureCompressor {
+    static const std::array<float, 256>& GetSrgbToLinear() {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> out{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                float c = static_cast<float>(i) / 255.f;
+                out[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return out;
+        }();
+        return table;
+    }
+
+    static uint8_t LinearToSrgb(float c) {
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::clamp(c * 255.f + 0.5f, 0.f, 255.f));
+    }
+
+    std::vector<uint8_t> Downsample(std::span<const uint8_t> rgba, glm::uvec2 size, bool srgb) {
+        const auto& toLinear = GetSrgbToLinear();
+        glm::uvec2 half = glm::max(size / 2u, glm::uvec2(1));
+        std::vector<uint8_t> out(size_t(half.x) * half.y * 4);
+
+        for (uint32_t y = 0; y < half.y; ++y) {
+            uint32_t y0 = std::min(y * 2, size.y - 1), y1 = std::min(y * 2 + 1, size.y - 1);
+            for (uint32_t x = 0; x < half.x; ++x) {
+                uint32_t x0 = std::min(x * 2, size.x - 1), x1 = std::min(x * 2 + 1, size.x - 1);
+                const uint8_t* texels[4] = {
+                        &rgba[(size_t(y0) * size.x + x0) * 4], &rgba[(size_t(y0) * size.x + x1) * 4],
+                        &rgba[(size_t(y1) * size.x + x0) * 4], &rgba[(size_t(y1) * size.x + x1) * 4]
+                };
+
+                uint8_t* dst = &out[(size_t(y) * half.x + x) * 4];
+                for (uint32_t c = 0; c < 4; ++c) {
+                    // Alpha is always linear
+                    if (srgb && c < 3) {
+                        float sum = 0.f;
+                        for (auto* texel: texels) sum += toLinear[texel[c]];
+                        dst[c] = LinearToSrgb(sum * 0.25f);
+                    } else {
+                        uint32_t sum = 2;
+                        for (auto* texel: texels) sum += texel[c];
+                        dst[c] = static_cast<uint8_t>(sum / 4);
+                    }
+                }
+            }
+        }
+        return out;
+    }
+
+    std::vector<std::byte> Compress(std::span<const uint8_t> rgba, glm::uvec2 size, PixelFormat format) {
+        glm::uvec2 blocks = (size + 3u) / 4u;
+        uint32_t blockBytes = GetBlockBytes(format);
+        std::vector<std::byte> out(GetImageBytes(format, size));
+
+        JobSystem::Get().ParallelFor("Compress texture", blocks.y, 4, [&](size_t begin, size_t end) {
+            uint8_t texels[16 * 4];
+            uint8_t channels[16 * 2];
+            for (size_t by = begin; by < end; ++by) {
+                for (uint32_t bx = 0; bx < blocks.x; ++bx) {
+                    for (uint32_t i = 0; i < 16; ++i) {
+                        uint32_t x = std::min(bx * 4 + i % 4, size.x - 1);
+                        uint32_t y = std::min(static_cast<uint32_t>(by) * 4 + i / 4, size.y - 1);
+                        memcpy(&texels[i * 4], &rgba[(size_t(y) * size.x + x) * 4], 4);
+                    }
+
+                    auto* block = reinterpret_cast<uint8_t*>(&out[(by * blocks.x + bx) * blockBytes]);
+                    switch (format) {
+                        case PixelFormat::BC1Srgb:
+                            stb_compress_dxt_block(block, texels, 0, STB_DXT_HIGHQUAL);
+                            break;
+                        case PixelFormat::BC3Srgb:
+                            stb_compress_dxt_block(block, texels, 1, STB_DXT_HIGHQUAL);
+                            break;
+                        case PixelFormat::BC5:
+                            for (uint32_t i = 0; i < 16; ++i) {
+                                channels[i * 2] = texels[i * 4];
+                                channels[i * 2 + 1] = texels[i * 4 + 1];
+                            }
+                            stb_compress_bc5_block(block, channels);
+                            break;
+                        case PixelFormat::BC7Srgb:
+                            EncodeBC7Block(texels, block);
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+        });
+        return out;
+    }
+
+    // Interpolation weights of 4 bit indices, out of 64
+    static constexpr std::array<int32_t, 16> BC7Weights{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    struct BC7Candidate {
+        std::array<int32_t, 4> endpoints[2];    // 7 bit
+        int32_t pbits[2];
+        std::array<uint8_t, 16> indices;
+        int64_t error;
+    };
+
+    static BC7Candidate EvaluateBC7(const uint8_t* texels, const glm::vec4& e0, const glm::vec4& e1,
+                                    int32_t p0, int32_t p1) {
+        BC7Candidate out{};
+        out.pbits[0] = p0;
+        out.pbits[1] = p1;
+
+        int32_t palette[16][4];
+        int32_t ends[2][4];
+        for (uint32_t c = 0; c < 4; ++c) {
+            out.endpoints[0][c] = std::clamp(static_cast<int32_t>(std::round((e0[c] - p0) / 2.f)), 0, 127);
+            out.endpoints[1][c] = std::clamp(static_cast<int32_t>(std::round((e1[c] - p1) / 2.f)), 0, 127);
+            ends[0][c] = out.endpoints[0][c] << 1 | p0;
+            ends[1][c] = out.endpoints[1][c] << 1 | p1;
+        }
+        for (uint32_t i = 0; i < 16; ++i) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                palette[i][c] = ((64 - BC7Weights[i]) * ends[0][c] + BC7Weights[i] * ends[1][c] + 32) >> 6;
+            }
+        }
+
+        for (uint32_t t = 0; t < 16; ++t) {
+            int64_t best = std::numeric_limits<int64_t>::max();
+            for (uint32_t i = 0; i < 16; ++i) {
+                int64_t error = 0;
+                for (uint32_t c = 0; c < 4; ++c) {
+                    int32_t d = palette[i][c] - texels[t * 4 + c];
+                    error += d * d;
+                }
+                if (error < best) {
+                    best = error;
+                    out.indices[t] = static_cast<uint8_t>(i);
+                }
+            }
+            out.error += best;
+        }
+        return out;
+    }
+
+    void EncodeBC7Block(const uint8_t* texels, uint8_t* block) {
+        // Endpoints on the principal axis of the block's colors, found by power iteration
+        glm::vec4 mean(0.f);
+        for (uint32_t t = 0; t < 16; ++t) mean += glm::vec4(texels[t * 4], texels[t * 4 + 1], texels[t * 4 + 2],
+                                                              texels[t * 4 + 3]);
+        mean /= 16.f;
+
+        glm::mat4 covariance(0.f);
+        for (uint32_t t = 0; t < 16; ++t) {
+            glm::vec4 d = glm::vec4(texels[t * 4], texels[t * 4 + 1], texels[t * 4 + 2], texels[t * 4 + 3]) - mean;
+            covariance += glm::outerProduct(d, d);
+        }
+
+        glm::vec4 axis(1.f);
+        for (uint32_t i = 0; i < 8; ++i) {
+            glm::vec4 next = covariance * axis;
+            float length = glm::length(next);
+            if (length < 1e-6f) break;
+            axis = next / length;
+        }
+        axis = glm::normalize(axis);
+
+        float minT = std::numeric_limits<float>::max(), maxT = std::numeric_limits<float>::lowest();
+        for (uint32_t t = 0; t < 16; ++t) {
+            glm::vec4 p(texels[t * 4], texels[t * 4 + 1], texels[t * 4 + 2], texels[t * 4 + 3]);
+            float d = glm::dot(p - mean, axis);
+            minT = std::min(minT, d);
+            maxT = std::max(maxT, d);
+        }
+        glm::vec4 e0 = glm::clamp(mean + axis * minT, 0.f, 255.f);
+        glm::vec4 e1 = glm::clamp(mean + axis * maxT, 0.f, 255.f);
+
+        BC7Candidate best{ .error = std::numeric_limits<int64_t>::max() };
+        for (int32_t p = 0; p < 4; ++p) {
+            auto candidate = EvaluateBC7(texels, e0, e1, p & 1, p >> 1);
+
+            // One least squares refit of the endpoints to the chosen indices
+            float a = 0.f, b = 0.f, c = 0.f;
+            glm::vec4 r0(0.f), r1(0.f);
+            for (uint32_t t = 0; t < 16; ++t) {
+                float w = static_cast<float>(BC7Weights[candidate.indices[t]]) / 64.f;
+                glm::vec4 x(texels[t * 4], texels[t * 4 + 1], texels[t * 4 + 2], texels[t * 4 + 3]);
+                a += (1.f - w) * (1.f - w);
+                b += (1.f - w) * w;
+                c += w * w;
+                r0 += (1.f - w) * x;
+                r1 += w * x;
+            }
+            float det = a * c - b * b;
+            if (std::abs(det) > 1e-3f) {
+                glm::vec4 f0 = glm::clamp((c * r0 - b * r1) / det, 0.f, 255.f);
+                glm::vec4 f1 = glm::clamp((a * r1 - b * r0) / det, 0.f, 255.f);
+                auto refit = EvaluateBC7(texels, f0, f1, p & 1, p >> 1);
+                if (refit.error < candidate.error) candidate = refit;
+            }
+
+            if (candidate.error < best.error) best = candidate;
+        }
+
+        // The first index is stored with an implicit 0 high bit
+        if (best.indices[0] >= 8) {
+            std::swap(best.endpoints[0], best.endpoints[1]);
+            std::swap(best.pbits[0], best.pbits[1]);
+            for (auto& index: best.indices) index = static_cast<uint8_t>(15 - index);
+        }
+
+        memset(block, 0, 16);
+        uint32_t bit = 0;
+        auto write = [&](uint32_t value, uint32_t bits) {
+            for (uint32_t i = 0; i < bits; ++i, ++bit) {
+                if (value >> i & 1) block[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+            }
+        };
+        write(1 << 6, 7);
+        for (uint32_t c = 0; c < 4; ++c) {
+            write(best.endpoints[0][c], 7);
+            write(best.endpoints[1][c], 7);
+        }
+        write(best.pbits[0], 1);
+        write(best.pbits[1], 1);
+        write(best.indices[0], 3);
+        for (uint32_t t = 1; t < 16; ++t) write(best.indices[t], 4);
+    }
+}
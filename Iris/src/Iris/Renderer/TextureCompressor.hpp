@@ -0,0 +1,15 @@
+#pragma once
+#include "Iris/Renderer/PixelFormat.hpp"
+
+namespace Iris::TextureCompressor {
+    // Box filtered half size copy of an RGBA8 image. sRGB images are averaged in linear space.
+    std::vector<uint8_t> Downsample(std::span<const uint8_t> rgba, glm::uvec2 size, bool srgb);
+
+    // Encodes an RGBA8 image into a block compressed format, the edge blocks repeat the last row/column.
+    // BC1, BC3 and BC5 use stb_dxt, BC7 uses mode 6 only (one subset, RGBA endpoints with 4 bit indices),
+    // which is fast and handles smooth color with alpha well. Blocks are spread over the job system.
+    std::vector<std::byte> Compress(std::span<const uint8_t> rgba, glm::uvec2 size, PixelFormat format);
+
+    // Single BC7 mode 6 block from 16 RGBA8 texels in row order
+    void EncodeBC7Block(const uint8_t* texels, uint8_t* block);
+}
@@ -1,22 +1,159 @@
 #include "Scene.hpp"
 
 namespace Iris {
-    Entity& Scene::CreateObject() {
-        m_Entities.emplace_back(m_Entities.size(), std::shared_ptr<Scene>(m_This));
-        return m_Entities[m_Entities.size() - 1];
+    Scene::Scene() {
+        m_CameraSystem = AddSystem("Cameras", [](Scene& scene, float dt) {
+            for (auto& camera: scene.GetPool<Camera>()) {
+                camera.Update(dt);
+            }
+        });
+    }
+
+    Entity Scene::CreateObject() {
+        size_t id;
+        if (!m_FreeIds.empty()) {
+            id = m_FreeIds.back();
+            m_FreeIds.pop_back();
+            m_Entities[id].m_Alive = true;
+        } else {
+            id = m_Entities.size();
+            m_Entities.emplace_back(id, this);
+            m_WorldMatrices.emplace_back(1.f);
+            m_WorldNormals.emplace_back(1.f);
+        }
+
+        GetPool<Transform>().Emplace(static_cast<uint32_t>(id), id, this);
+        return m_Entities[id];
     }
 
     void Scene::AddObject(Entity& entity) {
+        if (HasPendingAssets(entity.GetId())) {
+            m_WaitingForAssets.push_back(entity.GetHandle());
+            return;
+        }
         emit<ObjectAdd>(entity.GetId());
     }
 
-    std::vector<Entity>& Scene::GetObjects() {
-        return m_Entities;
+    void Scene::OnAssetResolved(EntityHandle handle) {
+        auto it = std::find(m_WaitingForAssets.begin(), m_WaitingForAssets.end(), handle);
+        if (it == m_WaitingForAssets.end() || HasPendingAssets(handle.id)) return;
+
+        m_WaitingForAssets.erase(it);
+        emit<ObjectAdd>(handle.id);
+    }
+
+    bool Scene::HasPendingAssets(size_t id) {
+        auto entity = static_cast<uint32_t>(id);
+        auto* mesh = GetPool<Mesh>().TryGet(entity);
+        auto* material = GetPool<Material>().TryGet(entity);
+        return (mesh && mesh->GetState() == AssetState::Pending) ||
+               (material && material->GetState() == AssetState::Pending);
+    }
+
+    void Scene::DestroyObject(size_t id) {
+        auto& entity = m_Entities[id];
+        if (!entity.m_Alive) return;
+
+        emit<ObjectRemove>(id);
+        std::erase(m_WaitingForAssets, entity.GetHandle());
+
+        // Children become roots, their local transform is kept
+        auto& transform = entity.GetTransform();
+        transform.Detach();
+        for (auto child: std::vector(transform.GetChildren())) {
+            GetEntity(child).GetTransform().Detach();
+        }
+
+        m_Components.RemoveAll(static_cast<uint32_t>(id));
+        entity.m_Alive = false;
+        ++entity.m_Generation;
+        m_FreeIds.push_back(static_cast<uint32_t>(id));
+    }
+
+    Entity* Scene::TryGetObject(size_t id) {
+        if (id >= m_Entities.size() || !m_Entities[id].m_Alive) return nullptr;
+        return &m_Entities[id];
+    }
+
+    bool Scene::IsAlive(EntityHandle handle) const {
+        return handle.id < m_Entities.size() && m_Entities[handle.id].m_Alive &&
+               m_Entities[handle.id].m_Generation == handle.generation;
+    }
+
+    Scene::SystemId Scene::AddSystem(std::string_view name, System system, std::vector<SystemId> dependencies) {
+        return m_Systems.Add(name, [this, system = std::move(system)] { system(*this, m_DeltaTime); },
+                             std::move(dependencies));
     }
 
     void Scene::Update(float dt) {
-        for (Entity& entity: m_Entities) {
-            entity.Update(dt);
+        m_DeltaTime = dt;
+        m_Systems.Run(JobSystem::Get());
+        UpdateTransforms();
+    }
+
+    void Scene::UpdateTransforms() {
+        std::lock_guard lock(m_DirtyMutex);
+        ComposeLocalMatrices();
+
+        for (auto id: m_DirtyTransforms) {
+            // Start at the topmost dirty ancestor, its subtree contains this transform as well
+            size_t root = id;
+            auto* transform = GetPool<Transform>().TryGet(static_cast<uint32_t>(id));
+            if (!transform) continue;   // destroyed since
+            for (size_t parent = transform->m_ParentEntity; parent != Transform::NoParent;
+                 parent = GetEntity(parent).GetTransform().m_ParentEntity) {
+                if (GetEntity(parent).GetTransform().m_Dirty) root = parent;
+            }
+            if (GetEntity(root).GetTransform().m_Dirty) UpdateSubtree(root);
+        }
+        m_DirtyTransforms.clear();
+    }
+
+    void Scene::ComposeLocalMatrices() {
+        m_BatchTransforms.clear();
+        for (auto id: m_DirtyTransforms) {
+            auto* transform = GetPool<Transform>().TryGet(static_cast<uint32_t>(id));
+            if (!transform || !transform->m_LocalDirty) continue;
+            transform->m_LocalDirty = false;
+            m_BatchTransforms.push_back(transform);
+        }
+        if (m_BatchTransforms.empty()) return;
+
+        m_LocalBatch.Resize(m_BatchTransforms.size());
+        m_BatchMatrices.resize(m_BatchTransforms.size());
+        m_BatchNormals.resize(m_BatchTransforms.size());
+        for (size_t i = 0; i < m_BatchTransforms.size(); ++i) {
+            auto* transform = m_BatchTransforms[i];
+            m_LocalBatch.Set(i, transform->m_Translation, glm::quat(glm::radians(transform->m_Rotation)),
+                             transform->m_Scale);
+        }
+        Math::ComposeTransforms(m_LocalBatch, m_BatchMatrices, m_BatchNormals);
+        for (size_t i = 0; i < m_BatchTransforms.size(); ++i) {
+            m_BatchTransforms[i]->m_LocalMatrix = m_BatchMatrices[i];
+            m_BatchTransforms[i]->m_NormalMatrix = m_BatchNormals[i];
+        }
+    }
+
+    void Scene::MarkTransformDirty(size_t id) {
+        std::lock_guard lock(m_DirtyMutex);
+        m_DirtyTransforms.push_back(id);
+    }
+
+    void Scene::UpdateSubtree(size_t id) {
+        auto& transform = GetEntity(id).GetTransform();
+        transform.m_Dirty = false;
+        const auto& local = transform.GetMatrix();
+        if (transform.m_ParentEntity == Transform::NoParent) {
+            m_WorldMatrices[id] = local;
+            m_WorldNormals[id] = transform.m_NormalMatrix;
+        } else {
+            // The inverse transpose of a product is the product of the inverse transposes
+            m_WorldMatrices[id] = m_WorldMatrices[transform.m_ParentEntity] * local;
+            m_WorldNormals[id] = glm::mat3x4(glm::mat3(m_WorldNormals[transform.m_ParentEntity]) *
+                                             glm::mat3(transform.m_NormalMatrix));
+        }
+        for (auto child: transform.m_Children) {
+            UpdateSubtree(child);
         }
     }
 }
@@ -1,5 +1,8 @@
 #pragma once
 #include "Iris/Entity/Entity.hpp"
+#include "Iris/Entity/ComponentStore.hpp"
+#include "Iris/Core/JobSystem.hpp"
+#include "Iris/Math/TransformBatch.hpp"
 #include "Iris/Util/EventEmitter.hpp"
 
 namespace Iris {
@@ -13,15 +16,112 @@ namespace Iris {
             ObjectRemove
     > {
     public:
-        Scene() = default;
-        Entity& CreateObject();
+        using SystemId = TaskGraph::TaskId;
+        using System = std::function<void(Scene&, float dt)>;
+
+        Scene();
+        // By value: the entity is a handle, a reference into the scene would dangle once it grows
+        Entity CreateObject();
+        // Announces the entity with ObjectAdd, held back until its mesh and material have finished loading
         void AddObject(Entity& entity);
-        std::vector<Entity>& GetObjects();
+        // Emits ObjectRemove while the components are still there, then frees the id for reuse
+        void DestroyObject(size_t id);
+        // Live entities only, a destroyed entity keeps its slot until the id is reused
+        [[nodiscard]] auto GetObjects() {
+            return m_Entities | std::views::filter([](const Entity& entity) { return entity.m_Alive; });
+        }
+        // nullptr for ids that are out of range or destroyed
+        Entity* TryGetObject(size_t id);
         void Update(float dt);
         Entity& GetEntity(size_t id) { return m_Entities[id]; };
-        void SetThis(const std::shared_ptr<Scene>& ptr) {m_This = ptr;};
+        [[nodiscard]] bool IsAlive(EntityHandle handle) const;
+        // Called by components when one of their assets finished loading or failed
+        void OnAssetResolved(EntityHandle handle);
+
+        // Systems run on the job system during Update, each one as soon as the systems it depends on are done.
+        // Systems without a dependency between them must not touch the same components.
+        SystemId AddSystem(std::string_view name, System system, std::vector<SystemId> dependencies = {});
+        [[nodiscard]] SystemId GetCameraSystem() const { return m_CameraSystem; }
+
+        // Recomputes the world matrices of every changed transform and its children, runs at the end of Update.
+        // Untouched subtrees cost nothing.
+        void UpdateTransforms();
+        void MarkTransformDirty(size_t id);
+        // Indexed by entity id, contiguous so it can be copied to the GPU as is
+        [[nodiscard]] std::span<const glm::mat4> GetWorldMatrices() const { return m_WorldMatrices; }
+        [[nodiscard]] const glm::mat4& GetWorldMatrix(size_t id) const { return m_WorldMatrices[id]; }
+        // Inverse transposes of the world matrices for transforming normals, in the std430 mat3 layout
+        [[nodiscard]] std::span<const glm::mat3x4> GetWorldNormalMatrices() const { return m_WorldNormals; }
+
+        template <class T>
+        ComponentPool<T>& GetPool() {
+            return m_Components.template GetPool<T>();
+        }
+
+        // Calls function(entityId, T&, Ts&...) for every entity that has all the given components. The first type
+        // drives the iteration, so it should be the rarest one.
+        template <class T, class... Ts, class F>
+        void Each(F&& function) {
+            auto& pool = GetPool<T>();
+            auto entities = pool.GetEntities();
+            auto components = pool.GetComponents();
+            for (size_t i = 0; i < components.size(); ++i) {
+                uint32_t entity = entities[i];
+                if ((GetPool<Ts>().Has(entity) && ...)) {
+                    function(entity, components[i], GetPool<Ts>().Get(entity)...);
+                }
+            }
+        }
+    private:
+        [[nodiscard]] bool HasPendingAssets(size_t id);
+        void ComposeLocalMatrices();
+        void UpdateSubtree(size_t id);
     private:
         std::vector<Entity> m_Entities{};
-        std::weak_ptr<Scene> m_This;
+        std::vector<uint32_t> m_FreeIds{};
+        std::vector<EntityHandle> m_WaitingForAssets{};   // added, but not announced yet
+
+        std::vector<glm::mat4> m_WorldMatrices{};
+        std::vector<glm::mat3x4> m_WorldNormals{};
+        std::vector<size_t> m_DirtyTransforms{};
+        // Local matrices of all changed transforms are composed in one batch
+        Math::TransformBatch m_LocalBatch;
+        std::vector<Transform*> m_BatchTransforms{};
+        std::vector<glm::mat4> m_BatchMatrices{};
+        std::vector<glm::mat3x4> m_BatchNormals{};
+        std::mutex m_DirtyMutex;    // systems may move different entities in parallel
+
+        TaskGraph m_Systems;
+        SystemId m_CameraSystem;
+        float m_DeltaTime = 0.f;    // of the Update the systems are currently running for
+
+        ComponentStore<
+                Transform,
+                Camera,
+                Material,
+                Mesh,
+                Light
+        > m_Components;
     };
+
+    template <class T>
+    T& Entity::GetComponent() {
+        return m_Scene->GetPool<T>().Get(static_cast<uint32_t>(m_Id));
+    }
+
+    template <class T>
+    bool Entity::HasComponent() const {
+        return m_Scene->GetPool<T>().Has(static_cast<uint32_t>(m_Id));
+    }
+
+    template <class T, class... Ts>
+    Entity& Entity::AddComponent(Ts... args) {
+        m_Scene->GetPool<T>().Emplace(static_cast<uint32_t>(m_Id), m_Id, m_Scene, args...);
+        return *this;
+    }
+
+    template <class T>
+    void Entity::RemoveComponent() {
+        m_Scene->GetPool<T>().Remove(static_cast<uint32_t>(m_Id));
+    }
 }
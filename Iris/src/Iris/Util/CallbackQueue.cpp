@@ -7,11 +7,15 @@ namespace Iris {
     }
 
     void CallbackQueue::Flush() {
-        std::scoped_lock lock(m_Mutex);
-        while (!m_Queue.empty()) {
-            auto item = m_Queue.front();
-            item();
-            m_Queue.pop();
+        // Run without the lock, so other threads can keep pushing and callbacks may push follow ups
+        std::queue<std::function<void(void)>> queue;
+        {
+            std::scoped_lock lock(m_Mutex);
+            std::swap(queue, m_Queue);
+        }
+        while (!queue.empty()) {
+            queue.front()();
+            queue.pop();
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+namespace Iris {
+    // 64 bit FNV-1a, used for content hashes of files (cache keys), not for hash tables
+    constexpr uint64_t HashBytes(std::span<const std::byte> data, uint64_t hash = 0xcbf29ce484222325ull) {
+        for (auto byte: data) {
+            hash ^= static_cast<uint64_t>(byte);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    // Size and modification time of a source file. Caches store it next to the content hash, so an unchanged
+    // source is recognized without reading and hashing it.
+    struct FileStamp {
+        uint64_t size = 0;
+        int64_t modified = 0;
+
+        bool operator==(const FileStamp&) const = default;
+    };
+
+    // nullopt when the file doesn't exist
+    inline std::optional<FileStamp> GetFileStamp(const std::filesystem::path& path) {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error) return std::nullopt;
+        auto modified = std::filesystem::last_write_time(path, error);
+        if (error) return std::nullopt;
+        return FileStamp{ size, static_cast<int64_t>(modified.time_since_epoch().count()) };
+    }
+
+    // Replaces the source stamp in a cache file's header, for sources that were touched but not changed.
+    // The stamp goes into a copy that is renamed over the cache like a newly written one, so loads mapping the
+    // old file keep seeing it whole.
+    template <class Header>
+    bool RestampCache(const std::filesystem::path& path, const FileStamp& stamp) {
+        auto temporary = path;
+        temporary += ".tmp";
+        std::error_code error;
+        std::filesystem::copy_file(path, temporary, std::filesystem::copy_options::overwrite_existing, error);
+        if (error) return false;
+        {
+            std::fstream file(temporary, std::ios::binary | std::ios::in | std::ios::out);
+            if (file) {
+                file.seekp(static_cast<std::streamoff>(offsetof(Header, sourceStamp)));
+                file.write(reinterpret_cast<const char*>(&stamp), sizeof(stamp));
+            }
+            if (!file) {
+                file.close();
+                std::filesystem::remove(temporary, error);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+}
@@ -0,0 +1,72 @@
+#include "MappedFile.hpp"
+
+#ifdef IRIS_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Iris {
+#ifdef IRIS_PLATFORM_WINDOWS
+    std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path) {
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!data) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        std::unique_ptr<MappedFile> out(new MappedFile());
+        out->m_Data = static_cast<const std::byte*>(data);
+        out->m_Size = static_cast<size_t>(size.QuadPart);
+        out->m_File = file;
+        out->m_Mapping = mapping;
+        return out;
+    }
+
+    MappedFile::~MappedFile() {
+        UnmapViewOfFile(m_Data);
+        CloseHandle(m_Mapping);
+        CloseHandle(m_File);
+    }
+#else
+    std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return nullptr;
+        }
+
+        // The mapping keeps its own reference to the file
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return nullptr;
+
+        std::unique_ptr<MappedFile> out(new MappedFile());
+        out->m_Data = static_cast<const std::byte*>(data);
+        out->m_Size = static_cast<size_t>(info.st_size);
+        return out;
+    }
+
+    MappedFile::~MappedFile() {
+        munmap(const_cast<std::byte*>(m_Data), m_Size);
+    }
+#endif
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace Iris {
+    // Read-only memory mapping of a whole file, pages are loaded by the OS on first access
+    class MappedFile final {
+    public:
+        // nullptr when the file doesn't exist or can't be mapped
+        static std::unique_ptr<MappedFile> Open(const std::filesystem::path& path);
+
+        [[nodiscard]] std::span<const std::byte> GetData() const { return { m_Data, m_Size }; }
+        [[nodiscard]] size_t GetSize() const { return m_Size; }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+    private:
+        MappedFile() = default;
+    private:
+        const std::byte* m_Data = nullptr;
+        size_t m_Size = 0;
+#ifdef IRIS_PLATFORM_WINDOWS
+        void* m_File = nullptr;
+        void* m_Mapping = nullptr;
+#endif
+    };
+}
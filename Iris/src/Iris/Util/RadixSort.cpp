@@ -0,0 +1,24 @@
+#include "RadixSort.hpp"
+
+namespace Iris {
+    void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch) {
+        if (items.size() < 2) return;
+        scratch.resize(items.size());
+
+        // Histograms of all bytes in a single read of the keys
+        std::array<std::array<uint32_t, 256>, 8> counts{};
+        for (const auto& item: items) {
+            for (uint32_t byte = 0; byte < 8; ++byte) ++counts[byte][(item.key >> (byte * 8)) & 0xff];
+        }
+
+        for (uint32_t byte = 0; byte < 8; ++byte) {
+            auto& count = counts[byte];
+            if (count[(items[0].key >> (byte * 8)) & 0xff] == items.size()) continue;
+
+            uint32_t offset = 0;
+            for (auto& c: count) offset += std::exchange(c, offset);
+            for (const auto& item: items) scratch[count[(item.key >> (byte * 8)) & 0xff]++] = item;
+            items.swap(scratch);
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace Iris {
+    struct SortItem {
+        uint64_t key;
+        uint32_t value;
+    };
+
+    // Stable LSD radix sort by key, one byte per pass. Bytes that are equal in every key are skipped, so keys
+    // using few bits cost few passes. scratch is only storage and can be reused between calls.
+    void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+}
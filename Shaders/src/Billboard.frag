@@ -6,6 +6,8 @@
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 inUV;
+layout (location = 3) flat in uint inObjectID;
+layout (location = 4) flat in uint inTextureID;
 
 layout (set = 0, binding = 0) uniform CameraData1 {
     CameraData camera;
@@ -16,19 +18,18 @@ layout (set = 1, binding = 0) uniform sampler2D textures[];
 layout (location = 0) out vec4 outColor;
 layout (location = 1) out uint outID;
 
-layout (push_constant) uniform PushConstants1 {
-    PushConstants pc;
-};
+// Every light type has an icon, the renderer can't start without them, so only a variant built with this
+// turned off draws the placeholder color
+layout (constant_id = 0) const bool Textured = true;
 
 void main()
 {
-    outID = pc.objectID + 1;
+    outID = inObjectID + 1;
 
-    ivec2 size = textureSize(textures[pc.textureID], 0);
-    if (size.x + size.y <= 2) {
-        outColor = vec4(0.7f, 0.f, 0.7f, 1.f); // empty texture
+    if (!Textured) {
+        outColor = vec4(0.7f, 0.f, 0.7f, 1.f); // no icon
         return;
     }
-    outColor = texture(textures[pc.textureID], inUV).rgba;
+    outColor = texture(textures[nonuniformEXT(inTextureID)], inUV).rgba;
     //if (outColor.a < 1.f) discard;
 }
\ No newline at end of file
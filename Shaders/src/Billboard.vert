@@ -7,13 +7,15 @@ layout (set = 0, binding = 0) uniform CameraData1 {
     CameraData camera;
 };
 
-layout (push_constant) uniform PushConstants1 {
-    PushConstants pc;
+layout (std430, set = 0, binding = 3) readonly buffer InstanceStorage1 {
+    InstanceData instances[];
 };
 
 layout (location = 0) out vec3 outPosition;
 layout (location = 1) out vec3 outNormal;
 layout (location = 2) out vec2 outUV;
+layout (location = 3) flat out uint outObjectID;
+layout (location = 4) flat out uint outTextureID;
 
 vec2 squarePositions[6] = {
 { -0.5f, -0.5f },
@@ -25,12 +27,15 @@ vec2 squarePositions[6] = {
 };
 
 void main() {
+    InstanceData instance = instances[gl_InstanceIndex];
+    mat4 modelMat = instance.modelMat;
+
     vec3 cameraRight = { camera.view[0][0], camera.view[1][0], camera.view[2][0] };
     vec3 cameraUp = { camera.view[0][1], camera.view[1][1], camera.view[2][1] };
 
-    vec3 scale = vec3(sqrt(pc.modelMat[0][0] * pc.modelMat[0][0] + pc.modelMat[0][1] * pc.modelMat[0][1] + pc.modelMat[0][2] * pc.modelMat[0][2]));
+    vec3 scale = vec3(sqrt(modelMat[0][0] * modelMat[0][0] + modelMat[0][1] * modelMat[0][1] + modelMat[0][2] * modelMat[0][2]));
 
-    vec3 position = vec3(pc.modelMat[3][0], pc.modelMat[3][1], pc.modelMat[3][2])
+    vec3 position = vec3(modelMat[3][0], modelMat[3][1], modelMat[3][2])
     + cameraRight * squarePositions[gl_VertexIndex].x * scale.x
     + cameraUp * squarePositions[gl_VertexIndex].y * scale.y;
 
@@ -39,6 +44,8 @@ void main() {
     outNormal = vec3(- camera.view[0][2], - camera.view[1][2], - camera.view[2][2]);
     outUV = squarePositions[gl_VertexIndex].xy + 0.5f;
     outUV.y = 1 - outUV.y;
+    outObjectID = instance.objectID;
+    outTextureID = instance.textureID;
 
     gl_Position = camera.viewProjection * locPos;
 }
\ No newline at end of file
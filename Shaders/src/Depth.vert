@@ -0,0 +1,27 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive : require
+#include "common.glsl"
+
+// Only the position stream, the main pass then shades each pixel once with an equal depth test
+layout (location = 0) in vec3 inPos;
+
+layout (set = 0, binding = 0) uniform CameraData1 {
+    CameraData camera;
+};
+
+layout (std430, set = 0, binding = 3) readonly buffer InstanceStorage1 {
+    InstanceData instances[];
+};
+
+layout (std430, set = 0, binding = 4) readonly buffer VisibleInstances1 {
+    uint visible[];
+};
+
+// Computed exactly like UberShader.vert, the depth must match bit for bit
+invariant gl_Position;
+
+void main() {
+    InstanceData instance = instances[visible[gl_InstanceIndex]];
+    vec4 locPos = instance.modelMat * vec4(inPos, 1.0);
+    gl_Position = camera.viewProjection * locPos;
+}
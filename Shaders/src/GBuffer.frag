@@ -0,0 +1,35 @@
+#version 450 core
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_GOOGLE_include_directive : require
+#include "common.glsl"
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUV;
+layout (location = 3) flat in uint inObjectID;
+layout (location = 4) flat in uint inTextureID;
+
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+
+// Material feature bits, same ids as UberShader.frag
+layout (constant_id = 0) const bool Textured = true;
+layout (constant_id = 1) const bool AlphaTest = true;
+
+// Location 0 is the final color, written by the lighting subpass
+layout (location = 1) out uint outID;
+layout (location = 2) out vec4 outAlbedo;
+layout (location = 3) out vec4 outNormal;
+
+void main()
+{
+    outID = inObjectID + 1;
+
+    vec4 color = vec4(0.7f, 0.7f, 0.7f, 1.f); // untextured
+    if (Textured) {
+        color = texture(textures[nonuniformEXT(inTextureID)], inUV);
+        if (AlphaTest && color.a < 0.5f) discard;
+    }
+
+    outAlbedo = vec4(color.rgb, 1.f);
+    outNormal = vec4(inNormal, 0.f);
+}
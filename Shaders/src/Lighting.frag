@@ -0,0 +1,26 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive : require
+#include "common.glsl"
+#include "lighting.glsl"
+
+// Written by GBuffer.frag in the previous subpass, read from tile memory where the GPU keeps it there
+layout (input_attachment_index = 0, set = 2, binding = 0) uniform subpassInput gAlbedo;
+layout (input_attachment_index = 1, set = 2, binding = 1) uniform subpassInput gNormal;
+layout (input_attachment_index = 2, set = 2, binding = 2) uniform subpassInput gDepth;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    float depth = subpassLoad(gDepth).r;
+    if (depth >= 1.f) discard; // nothing drawn, keep the clear color
+
+    // The viewport is flipped, framebuffer y grows downwards
+    vec2 uv = gl_FragCoord.xy / lightsMeta.screenSize;
+    vec4 world = camera.inverseViewProjection * vec4(uv.x * 2.f - 1.f, 1.f - uv.y * 2.f, depth, 1.f);
+    vec3 position = world.xyz / world.w;
+
+    vec3 albedo = subpassLoad(gAlbedo).rgb;
+    vec3 normal = subpassLoad(gNormal).xyz;
+    outColor = vec4(BlinnPhong(albedo, position, normal, gl_FragCoord.xy), 1.f);
+}
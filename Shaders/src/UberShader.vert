@@ -12,20 +12,33 @@ layout (set = 0, binding = 0) uniform CameraData1 {
     CameraData camera;
 };
 
-layout (push_constant) uniform PushConstants1 {
-    PushConstants pc;
+layout (std430, set = 0, binding = 3) readonly buffer InstanceStorage1 {
+    InstanceData instances[];
+};
+
+// Instances that survived culling, grouped by draw
+layout (std430, set = 0, binding = 4) readonly buffer VisibleInstances1 {
+    uint visible[];
 };
 
 layout (location = 0) out vec3 outPosition;
 layout (location = 1) out vec3 outNormal;
 layout (location = 2) out vec2 outUV;
+layout (location = 3) flat out uint outObjectID;
+layout (location = 4) flat out uint outTextureID;
+
+// Must match the depth prepass of Depth.vert bit for bit
+invariant gl_Position;
 
 void main() {
-    vec4 locPos = pc.modelMat * vec4(inPos.xyz, 1.0);
+    InstanceData instance = instances[visible[gl_InstanceIndex]];
+    vec4 locPos = instance.modelMat * vec4(inPos.xyz, 1.0);
 
     outPosition = locPos.xyz / locPos.w;
-    outNormal = inNormal.xyz;
+    outNormal = normalize(instance.normalMat * inNormal.xyz);
     outUV = inUV;
+    outObjectID = instance.objectID;
+    outTextureID = instance.textureID;
 
     gl_Position = camera.viewProjection * locPos;
 }
\ No newline at end of file
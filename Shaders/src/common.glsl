@@ -3,21 +3,68 @@ struct CameraData {
     mat4 view;
     mat4 projection;
     mat4 viewProjection;
+    mat4 inverseViewProjection;
 };
 
-struct PushConstants {
+struct InstanceData {
     mat4 modelMat;
+    mat3 normalMat;
     uint objectID;
     uint textureID;
+    uint drawID;
 };
 
 struct Light {
-    vec4 position;
+    vec4 position;  // w: range of point and spot lights
     vec4 rotation;
     vec4 color;
     uvec4 flags;
 };
 
 struct LightData {
-    uint count;
-};
\ No newline at end of file
+    uint count;             // directional lights come first, the point and spot lights after them are clustered
+    uint directionalCount;
+    float zNear;
+    float zFar;
+    vec2 screenSize;
+    vec2 projectionScale;   // projection[0][0] and [1][1], turns NDC into view space directions
+};
+
+struct CullData {
+    mat4 viewProjection;
+    mat4 prevViewProjection;   // camera of the frame the Hi-Z pyramid was rendered with
+    vec4 frustum[6];
+    vec2 hizSize;
+    uint instanceCount;
+    uint drawCount;
+    uint occlusion;
+    uvec4 bucketEnds;   // draws are sorted by material bucket, end of every bucket's range
+};
+
+// Matches VkDrawIndexedIndirectCommand
+struct DrawCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+// Clustered lighting: the view frustum is split into screen tiles and logarithmic depth slices, every cluster
+// lists the point and spot lights reaching into it
+const uvec3 ClusterGrid = uvec3(16, 9, 24);
+const uint ClusterCount = ClusterGrid.x * ClusterGrid.y * ClusterGrid.z;
+const uint MaxClusterLights = 127;                  // lights beyond that are dropped from the cluster
+const uint ClusterStride = MaxClusterLights + 1;    // light count, then the light indices
+
+// View space depth where a slice starts
+float ClusterSliceDepth(uint slice, LightData data) {
+    return data.zNear * pow(data.zFar / data.zNear, float(slice) / float(ClusterGrid.z));
+}
+
+uint ClusterIndex(vec2 fragCoord, float viewDepth, LightData data) {
+    uvec2 tile = min(uvec2(fragCoord / data.screenSize * vec2(ClusterGrid.xy)), ClusterGrid.xy - 1u);
+    float slice = log(max(viewDepth, data.zNear) / data.zNear) / log(data.zFar / data.zNear) * float(ClusterGrid.z);
+    uint z = min(uint(slice), ClusterGrid.z - 1u);
+    return tile.x + ClusterGrid.x * (tile.y + ClusterGrid.y * z);
+}
@@ -0,0 +1,131 @@
+// Blinn-Phong shading with clustered point and spot lights, shared by forward shading (UberShader.frag) and
+// the deferred lighting pass (Lighting.frag). Include after common.glsl.
+
+layout (set = 0, binding = 0) uniform CameraData1 {
+    CameraData camera;
+};
+
+layout (set = 0, binding = 1) uniform LightData1 {
+    LightData lightsMeta;
+};
+
+layout (std140, set = 0, binding = 2) readonly buffer LightStorage1 {
+    Light[] lights;
+};
+
+// Point and spot lights per cluster, built by LightCull.comp
+layout (std430, set = 0, binding = 5) readonly buffer ClusterLights1 {
+    uint clusterLights[];
+};
+
+// Light types present in the frame, matches ShaderFeature in the Vulkan renderer
+layout (constant_id = 2) const bool PointLights = true;
+layout (constant_id = 3) const bool DirectionalLights = true;
+layout (constant_id = 4) const bool SpotLights = true;
+
+float specularIntensity = 0.5f;
+float ambientLight = 0.1f;
+
+// Fades the light out towards its range, so it has no visible edge where the clusters stop listing it
+float RangeWindow(Light light, float dist) {
+    float ratio = dist / light.position.w;
+    float window = clamp(1.f - ratio * ratio * ratio * ratio, 0.f, 1.f);
+    return window * window;
+}
+
+vec3 PointLight(vec3 albedo, vec3 position, vec3 normal, Light light, vec3 cameraPos) {
+    vec3 lightVec = light.position.xyz - position;
+    float dist = length(lightVec);
+    float a = 1.f; // attenuation parameters
+    float b = 2.f;
+    float intensity = RangeWindow(light, dist) / (a * dist * dist + b * dist + 1.f);
+
+    vec3 lightDirection = normalize(lightVec);
+    float diffuse = max(dot(normal, lightDirection), 0.f);
+
+    float specular = 0.f;
+    if (diffuse != 0.f) {
+        vec3 viewDirection = normalize(cameraPos - position);
+        vec3 reflectionDirection = reflect(-lightDirection, viewDirection);
+        vec3 halfwayVec = normalize(viewDirection + lightDirection);
+        float specularAmount = pow(max(dot(normal, halfwayVec), 0), 8);
+        specular = specularIntensity * specularAmount;
+    }
+
+    return albedo * light.color.rgb * (diffuse + specular) * intensity;
+}
+
+vec3 DirectionalLight(vec3 albedo, vec3 position, vec3 normal, Light light, vec3 cameraPos) {
+    vec3 lightDirection = normalize(light.position.xyz);
+    float diffuse = max(dot(normal, lightDirection), 0.f);
+
+    float specular = 0.f;
+    if (diffuse != 0.f) {
+        vec3 viewDirection = normalize(cameraPos - position);
+        vec3 reflectionDirection = reflect(-lightDirection, viewDirection);
+        vec3 halfwayVec = normalize(viewDirection + lightDirection);
+        float specularAmount = pow(max(dot(normal, halfwayVec), 0), 8);
+        specular = specularIntensity * specularAmount;
+    }
+
+    return albedo * light.color.rgb * (diffuse + specular);
+}
+
+vec3 SpotLight(vec3 albedo, vec3 position, vec3 normal, Light light, vec3 cameraPos) {
+    float outerCone = 0.9f;
+    float innerCone = 0.95f;
+
+    vec3 lightVec = light.position.xyz - position;
+    vec3 lightDirection = normalize(lightVec);
+    float diffuse = max(dot(normal, lightDirection), 0.f);
+
+    float specular = 0.f;
+    if (diffuse != 0.f) {
+        vec3 viewDirection = normalize(cameraPos - position);
+        vec3 reflectionDirection = reflect(-lightDirection, viewDirection);
+        vec3 halfwayVec = normalize(viewDirection + lightDirection);
+        float specularAmount = pow(max(dot(normal, halfwayVec), 0), 8);
+        specular = specularIntensity * specularAmount;
+    }
+
+    // this is wrong, but it works
+    vec3 spotDirection = { light.rotation.z, -1.f, - light.rotation.x };
+    float angle = dot(normalize(spotDirection), -lightDirection);
+    float intensity = clamp((angle - outerCone) / (innerCone - outerCone), 0.f, 1.f) *
+                      RangeWindow(light, length(lightVec));
+
+    return albedo * light.color.rgb * (diffuse + specular) * intensity;
+}
+
+// position and normal in world space, fragCoord picks the light cluster
+vec3 BlinnPhong(vec3 color, vec3 position, vec3 normal, vec2 fragCoord) {
+    vec3 cameraPos = camera.position.xyz;
+
+    vec3 total = { 0.f, 0.f, 0.f };
+
+    // Directional lights reach everything, they aren't clustered
+    if (DirectionalLights) {
+        for (uint i = 0; i < lightsMeta.directionalCount; i++) {
+            total += DirectionalLight(color, position, normal, lights[i], cameraPos);
+        }
+    }
+
+    if (PointLights || SpotLights) {
+        float viewDepth = -(camera.view * vec4(position, 1.f)).z;
+        uint cluster = ClusterIndex(fragCoord, viewDepth, lightsMeta) * ClusterStride;
+        uint count = clusterLights[cluster];
+        for (uint i = 0; i < count; i++) {
+            Light light = lights[clusterLights[cluster + 1 + i]];
+            if (PointLights && light.flags.x == 0) // point
+            {
+                total += PointLight(color, position, normal, light, cameraPos);
+            }
+            else if (SpotLights && light.flags.x == 2) // spot
+            {
+                total += SpotLight(color, position, normal, light, cameraPos);
+            }
+        }
+    }
+
+    return total + color * 0.1f;
+}